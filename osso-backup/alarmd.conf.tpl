@@ -25,5 +25,6 @@
 <backup-configuration>
   <locations>
     <location type="file" category="comm_and_cal" auto="true">@CACHEDIR@/alarm_queue.ini</location>
+    <location type="file" category="comm_and_cal" auto="true">@CACHEDIR@/alarm_queue.ini.journal</location>
   </locations>
 </backup-configuration>
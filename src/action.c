@@ -27,6 +27,7 @@
 #include "libalarm.h"
 #include "xutil.h"
 #include "serialize.h"
+#include "unique.h"
 
 /* ------------------------------------------------------------------------- *
  * alarm_action_ctor
@@ -58,10 +59,10 @@ alarm_action_dtor(alarm_action_t *self)
 
   free(self->exec_command);
 
-  free(self->dbus_interface);
-  free(self->dbus_service);
-  free(self->dbus_path);
-  free(self->dbus_name);
+  unique_release(self->dbus_interface);
+  unique_release(self->dbus_service);
+  unique_release(self->dbus_path);
+  unique_release(self->dbus_name);
   free(self->dbus_args);
 }
 
@@ -228,7 +229,7 @@ alarm_action_set_exec_command(alarm_action_t *self, const char *exec_command)
 void
 alarm_action_set_dbus_interface(alarm_action_t *self, const char *dbus_interface)
 {
-  xstrset(&self->dbus_interface, dbus_interface);
+  unique_strset(&self->dbus_interface, dbus_interface);
 }
 
 /* ------------------------------------------------------------------------- *
@@ -238,7 +239,7 @@ alarm_action_set_dbus_interface(alarm_action_t *self, const char *dbus_interface
 void
 alarm_action_set_dbus_service(alarm_action_t *self, const char *dbus_service)
 {
-  xstrset(&self->dbus_service, dbus_service);
+  unique_strset(&self->dbus_service, dbus_service);
 }
 
 /* ------------------------------------------------------------------------- *
@@ -248,7 +249,7 @@ alarm_action_set_dbus_service(alarm_action_t *self, const char *dbus_service)
 void
 alarm_action_set_dbus_path(alarm_action_t *self, const char *dbus_path)
 {
-  xstrset(&self->dbus_path, dbus_path);
+  unique_strset(&self->dbus_path, dbus_path);
 }
 
 /* ------------------------------------------------------------------------- *
@@ -258,7 +259,7 @@ alarm_action_set_dbus_path(alarm_action_t *self, const char *dbus_path)
 void
 alarm_action_set_dbus_name(alarm_action_t *self, const char *dbus_name)
 {
-  xstrset(&self->dbus_name, dbus_name);
+  unique_strset(&self->dbus_name, dbus_name);
 }
 
 /* ------------------------------------------------------------------------- *
@@ -162,6 +162,56 @@
  **/
 #define ALARMD_EVENT_QUERY "query_event"
 
+/**
+ * Queries the queue for matching events and returns
+ * the event data instead of cookies.
+ *
+ * Events are matched as with ALARMD_EVENT_QUERY. The fields
+ * parameter is a bitmask of alarmqueryfields values that
+ * selects which parts of the events are sent; omitted parts
+ * are sent as empty strings / zero length tables.
+ *
+ * @param start_time : INT32 [time_t]
+ * @param stop_time  : INT32 [time_t]
+ * @param flag_mask  : INT32
+ * @param flag_want  : INT32
+ * @param app_name   : STRING
+ * @param fields     : UINT32
+ *
+ * @returns count : UINT32
+ * <br> event    : as in ALARMD_EVENT_GET - repeats 'count' times
+ *
+ * @since 1.1.17
+ **/
+#define ALARMD_EVENT_QUERY_FULL "query_events_full"
+
+/**
+ * Queries the queue for matching events one page at a time.
+ *
+ * Events are matched as with ALARMD_EVENT_QUERY and reported
+ * in trigger time order. At most limit cookies are returned
+ * per call. The cursor is an opaque continuation token from
+ * the previous reply, or an empty string to start from the
+ * first matching event.
+ *
+ * Events whose trigger time changes between calls might be
+ * skipped or reported twice.
+ *
+ * @param start_time : INT32 [time_t]
+ * @param stop_time  : INT32 [time_t]
+ * @param flag_mask  : INT32
+ * @param flag_want  : INT32
+ * @param app_name   : STRING
+ * @param limit      : UINT32, 0 = no limit
+ * @param cursor     : STRING
+ *
+ * @returns cookies : ARRAY of INT32
+ * <br> cursor      : STRING, empty when there are no more events
+ *
+ * @since 1.1.17
+ **/
+#define ALARMD_EVENT_QUERY_PAGE "query_event_page"
+
 /**
  * Updates an existing event.
  *
@@ -203,6 +253,31 @@
  **/
 #define ALARMD_EVENT_UPDATE "update_event"
 
+/**
+ * Adds several events to the queue in one DBus transaction.
+ *
+ * The queue is re-evaluated and saved once for the whole batch.
+ *
+ * @param count : UINT32
+ * @param event : as in ALARMD_EVENT_ADD - repeats 'count' times
+ *
+ * @returns cookies : ARRAY of INT32, 0 = event was rejected
+ *
+ * @since 1.1.17
+ **/
+#define ALARMD_EVENTS_ADD "add_events"
+
+/**
+ * Removes several events from the queue in one DBus transaction.
+ *
+ * @param cookies : ARRAY of INT32
+ *
+ * @returns deleted : ARRAY of BOOLEAN
+ *
+ * @since 1.1.17
+ **/
+#define ALARMD_EVENTS_DEL "del_events"
+
 /**
  * Set default snooze time in seconds.
  *
@@ -286,6 +361,42 @@
  **/
 #define ALARMD_TIME_CHANGE_IND "time_change_ind"
 
+/**
+ * Alarm queue content change indication.
+ *
+ * @since 1.1.17
+ *
+ * Changes made to queued events are collected while
+ * alarmd re-evaluates the queue and broadcast once the
+ * queue is stable again. Several changes to the same
+ * event are merged into one, and events that are both
+ * added and removed within the same round are not
+ * reported at all.
+ *
+ * Each signal carries changes for events belonging
+ * to one application, so that clients can use match
+ * rule "arg0='<appid>'" to receive only changes to
+ * their own events. The changes are given as parallel
+ * arrays: the n'th element of each array describes
+ * the same event.
+ *
+ * @param appid    : STRING
+ * @param cookies  : ARRAY of INT32
+ * @param kinds    : ARRAY of INT32 [ALARMD_QUEUE_CHANGE_xxx]
+ * @param triggers : ARRAY of INT32 [time_t]
+ * @param states   : ARRAY of INT32
+ **/
+#define ALARMD_QUEUE_CHANGED_IND "queue_changed_ind"
+
+/** ALARMD_QUEUE_CHANGED_IND kind: event was added to the queue */
+#define ALARMD_QUEUE_CHANGE_ADDED    1
+
+/** ALARMD_QUEUE_CHANGED_IND kind: trigger time or state changed */
+#define ALARMD_QUEUE_CHANGE_MODIFIED 2
+
+/** ALARMD_QUEUE_CHANGED_IND kind: event was removed from the queue */
+#define ALARMD_QUEUE_CHANGE_DELETED  3
+
 /*@}*/
 
 #endif
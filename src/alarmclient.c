@@ -2837,11 +2837,22 @@ alarmclient_handle_list_events(int verbose)
   cookie_t       *cookie = 0;
   alarm_event_t **event  = 0;
 
-  cookie = alarmd_event_query(0,0,0,0,0);
+  size_t n = 0;
 
-  size_t n;
-
-  for( n = 0; cookie && cookie[n]; ++n ) {}
+  if( verbose == 0 )
+  {
+    cookie = alarmd_event_query(0,0,0,0,0);
+    for( n = 0; cookie && cookie[n]; ++n ) {}
+  }
+  else
+  {
+    /* fetch events with one method call instead of
+     * separate alarmd_event_get() for each cookie */
+    event = alarmd_event_query_full(0,0,0,0,0,
+                                    (verbose == 1) ? ALARM_QUERY_TEXT
+                                                   : ALARM_QUERY_ALL);
+    for( n = 0; event && event[n]; ++n ) {}
+  }
 
   if( n == 0 )
   {
@@ -2854,55 +2865,46 @@ alarmclient_handle_list_events(int verbose)
       alarmclient_emitf("[%03ld]\n", cookie[i]);
     }
   }
-  else
+  else if( verbose == 1 )
   {
-    event = calloc(n, sizeof *event);
-    for( size_t i = 0; i < n; ++i )
-    {
-      event[i] = alarmd_event_get(cookie[i]);
-    }
+    time_t now = ticker_get_time();
 
-    if( verbose == 1 )
+    for( size_t i = 0; i < n; ++i )
     {
-      time_t now = ticker_get_time();
+      char date[128];
+      char secs[128];
+      char ident[256];
+      char stamp[256];
 
-      for( size_t i = 0; i < n; ++i )
-      {
-        char date[128];
-        char secs[128];
-        char ident[256];
-        char stamp[256];
+      time_t diff = now - event[i]->ALARMD_PRIVATE(trigger);
 
-        time_t diff = now - event[i]->ALARMD_PRIVATE(trigger);
+      alarmclient_date_format_short(date, sizeof date, &event[i]->ALARMD_PRIVATE(trigger));
+      alarmclient_secs_format(secs, sizeof secs, diff);
 
-        alarmclient_date_format_short(date, sizeof date, &event[i]->ALARMD_PRIVATE(trigger));
-        alarmclient_secs_format(secs, sizeof secs, diff);
+      snprintf(ident, sizeof ident, "%s/%s/%s",
+               alarm_event_get_alarm_appid(event[i]),
+               alarm_event_get_title(event[i]),
+               alarm_event_get_message(event[i]));
 
-        snprintf(ident, sizeof ident, "%s/%s/%s",
-                 alarm_event_get_alarm_appid(event[i]),
-                 alarm_event_get_title(event[i]),
-                 alarm_event_get_message(event[i]));
+      snprintf(stamp, sizeof stamp, "%s (T%s)", date, secs);
 
-        snprintf(stamp, sizeof stamp, "%s (T%s)", date, secs);
-
-        alarmclient_emitf("[%03ld] %-36s %s\n", cookie[i], stamp, ident);
-      }
-    }
-    else
-    {
-      for( size_t i = 0; i < n; ++i )
-      {
-        alarmclient_emitf("[%03ld]  ", cookie[i]);
-        alarmclient_event_show(event[i]);
-      }
+      alarmclient_emitf("[%03ld] %-36s %s\n", event[i]->ALARMD_PRIVATE(cookie), stamp, ident);
     }
+  }
+  else
+  {
     for( size_t i = 0; i < n; ++i )
     {
-      alarm_event_delete(event[i]);
+      alarmclient_emitf("[%03ld]  ", event[i]->ALARMD_PRIVATE(cookie));
+      alarmclient_event_show(event[i]);
     }
-    free(event);
   }
 
+  for( size_t i = 0; event && event[i]; ++i )
+  {
+    alarm_event_delete(event[i]);
+  }
+  free(event);
   free(cookie);
 }
 
@@ -46,7 +46,9 @@ static const char *LGPL =
 #include "alarmd_config.h"
 
 #include "logging.h"
+#include "ipc_exec.h"
 #include "mainloop.h"
+#include "queue.h"
 #include "server.h"
 #include "xutil.h"
 
@@ -221,10 +223,19 @@ static void show_usage(void)
     printf("                   * %s\n", levels[i]);
   }
 
+  printf("  -j <count>, --exec-limit=<count>\n"
+         "      Max number of exec actions starting at the same time,\n"
+         "      0 = no limit. Default is %d.\n", IPC_EXEC_LIMIT_DEFAULT);
+
   printf("  -Xrfs\n"
          "      Restore factory settings.\n"
          "  -Xcud\n"
          "      Clear user data\n"
+         "  -Xbin\n"
+         "      Rewrite queue file with binary copy and exit.\n"
+         "  -Xini\n"
+         "      Rewrite queue file as text only and exit.\n"
+         "      Use only while alarmd is not running.\n"
          );
 
   printf("\n"
@@ -264,7 +275,7 @@ static int cmp_flag(const char *input, const char *flag_name)
 int
 main(int argc, char **argv)
 {
-  static const char opt_s[] = "hVdl:L:X:w:t:";
+  static const char opt_s[] = "hVdl:L:X:w:t:j:";
 
   static const struct option opt_l[] =
   {
@@ -276,6 +287,7 @@ main(int argc, char **argv)
     {"log-target",    1, 0, 'l'},
     {"limbo-control", 1, 0, 'w'},
     {"limbo-timeout", 1, 0, 't'},
+    {"exec-limit",    1, 0, 'j'},
     {0,               0, 0,  0 }
   };
 
@@ -322,6 +334,9 @@ main(int argc, char **argv)
     case 't':
       server_limbo_set_timeout(strtol(optarg,0,0));
       break;
+    case 'j':
+      ipc_exec_set_limit(strtol(optarg,0,0));
+      break;
 
     case 'w':
       if( cmp_flag(optarg, "disabled") )
@@ -355,6 +370,14 @@ main(int argc, char **argv)
       {
         exit(restore_factory_settings() == -1 ? EXIT_FAILURE : EXIT_SUCCESS);
       }
+      else if( !strcmp(optarg, "bin") )
+      {
+        exit(queue_convert(1) == -1 ? EXIT_FAILURE : EXIT_SUCCESS);
+      }
+      else if( !strcmp(optarg, "ini") )
+      {
+        exit(queue_convert(0) == -1 ? EXIT_FAILURE : EXIT_SUCCESS);
+      }
       else
       {
         fprintf(stderr, "Unknwon option: -X%s\n", optarg);
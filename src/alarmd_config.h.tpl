@@ -71,6 +71,13 @@ extern "C" {
 # define ALARMD_QUEUE_MODIFIED_IGNORE  0
 #endif
 
+/* If non-zero, alarmd writes a binary copy of the queue file along
+ * with it. The copy is used for faster startup as long as the queue
+ * file itself has not been modified; the text file is always written
+ * and remains the master copy.
+ */
+#define ALARMD_QUEUE_BINARY 1
+
 /* ------------------------------------------------------------------------- *
  * D-Bus connection configuration
  * ------------------------------------------------------------------------- */
@@ -93,6 +100,16 @@ extern "C" {
 /* Enable '-Xrfs' command line option */
 #define ALARMD_RFS_ENABLE 1
 
+// Send systemui dialog requests as array method calls; the stock
+// systemui alarm plugin does not implement these
+#define ALARMD_SYSTEMUI_BATCH 0
+
+/* If non-zero, recurrence mask scanning moves steps that land on
+ * skipped local time past the gap. mktime() may resolve them
+ * backwards, e.g. in zones where the time before the gap is flagged
+ * as dst, and the scan would then keep stepping into the gap. */
+#define ALARMD_RECUR_GAP_FORWARD 1
+
 /* ------------------------------------------------------------------------- *
  * Various flags originating from Makefile
  * ------------------------------------------------------------------------- */
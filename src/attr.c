@@ -68,6 +68,7 @@ alarm_attr_set_null(alarm_attr_t *self)
   {
   case ALARM_ATTR_STRING:
     free(self->attr_data.sval);
+    self->attr_data.sval = 0;
     break;
   }
   self->attr_type = ALARM_ATTR_NULL;
@@ -31,6 +31,7 @@
 #include "alarm_dbus.h"
 
 #include <stdlib.h>
+#include <string.h>
 
 /* ------------------------------------------------------------------------- *
  * client_make_method_message  --  construct dbus method call message
@@ -191,6 +192,308 @@ client_exec_method_call(DBusMessage *msg, DBusMessage **prsp)
   return res;
 }
 
+/* ========================================================================= *
+ * alarmd_session_t  --  persistent connection to alarmd
+ * ========================================================================= */
+
+struct alarmd_session_t
+{
+  DBusConnection  *as_con;
+
+  /* pending calls in the order they were sent */
+  DBusPendingCall **as_pend;
+  size_t            as_head;
+  size_t            as_tail;
+  size_t            as_size;
+};
+
+/* ------------------------------------------------------------------------- *
+ * alarmd_session_open
+ * ------------------------------------------------------------------------- */
+
+alarmd_session_t *
+alarmd_session_open(void)
+{
+  alarmd_session_t *self = 0;
+  DBusConnection   *con  = 0;
+  DBusError         err  = DBUS_ERROR_INIT;
+
+#if ALARMD_ON_SYSTEM_BUS
+  DBusBusType       type = DBUS_BUS_SYSTEM;
+#else
+  DBusBusType       type = DBUS_BUS_SESSION;
+#endif
+
+#if ALARMD_USE_PRIVATE_BUS
+  if( !(con = dbus_bus_get_private(type, &err)) )
+  {
+    log_error("%s: %s: %s\n", "dbus_bus_get_private", err.name, err.message);
+    goto cleanup;
+  }
+  dbus_connection_set_exit_on_disconnect(con, FALSE);
+#else
+  if( !(con = dbus_bus_get(type, &err)) )
+  {
+    log_error("%s: %s: %s\n", "dbus_bus_get", err.name, err.message);
+    goto cleanup;
+  }
+#endif
+
+  self = calloc(1, sizeof *self);
+  self->as_con  = con, con = 0;
+  self->as_pend = 0;
+  self->as_head = 0;
+  self->as_tail = 0;
+  self->as_size = 0;
+
+  cleanup:
+
+  if( con != 0 ) dbus_connection_unref(con);
+
+  dbus_error_free(&err);
+
+  return self;
+}
+
+/* ------------------------------------------------------------------------- *
+ * alarmd_session_close
+ * ------------------------------------------------------------------------- */
+
+void
+alarmd_session_close(alarmd_session_t *self)
+{
+  if( self != 0 )
+  {
+    for( ; self->as_head < self->as_tail; ++self->as_head )
+    {
+      DBusPendingCall *pc = self->as_pend[self->as_head];
+      dbus_pending_call_cancel(pc);
+      dbus_pending_call_unref(pc);
+    }
+    free(self->as_pend);
+
+#if ALARMD_USE_PRIVATE_BUS
+    dbus_connection_close(self->as_con);
+#endif
+    dbus_connection_unref(self->as_con);
+
+    free(self);
+  }
+}
+
+/* ------------------------------------------------------------------------- *
+ * alarmd_session_pending
+ * ------------------------------------------------------------------------- */
+
+int
+alarmd_session_pending(const alarmd_session_t *self)
+{
+  return (int)(self->as_tail - self->as_head);
+}
+
+/* ------------------------------------------------------------------------- *
+ * alarmd_session_send  --  send method call without waiting for reply
+ * ------------------------------------------------------------------------- */
+
+int
+alarmd_session_send(alarmd_session_t *self, DBusMessage *msg)
+{
+  DBusPendingCall *pc = 0;
+
+  if( !dbus_connection_get_is_connected(self->as_con) )
+  {
+    log_error("%s\n", "not connected");
+    return -1;
+  }
+
+  if( self->as_tail == self->as_size )
+  {
+    // reclaim space used by already received replies
+    size_t cnt = self->as_tail - self->as_head;
+
+    if( self->as_head > 0 )
+    {
+      memmove(self->as_pend, self->as_pend + self->as_head,
+              cnt * sizeof *self->as_pend);
+      self->as_head = 0;
+      self->as_tail = cnt;
+    }
+
+    if( self->as_tail == self->as_size )
+    {
+      size_t size = self->as_size ? self->as_size * 2 : 16;
+      void  *pend = realloc(self->as_pend, size * sizeof *self->as_pend);
+
+      if( pend == 0 )
+      {
+        log_error("%s\n", "out of memory");
+        return -1;
+      }
+      self->as_pend = pend;
+      self->as_size = size;
+    }
+  }
+
+  if( !dbus_connection_send_with_reply(self->as_con, msg, &pc, -1) || !pc )
+  {
+    log_error("%s\n", "dbus_connection_send_with_reply");
+    return -1;
+  }
+
+  self->as_pend[self->as_tail++] = pc;
+  return 0;
+}
+
+/* ------------------------------------------------------------------------- *
+ * alarmd_session_recv  --  wait for reply to oldest pending method call
+ * ------------------------------------------------------------------------- */
+
+DBusMessage *
+alarmd_session_recv(alarmd_session_t *self)
+{
+  DBusMessage     *rsp = 0;
+  DBusPendingCall *pc  = 0;
+
+  if( self->as_head == self->as_tail )
+  {
+    log_error("%s\n", "no pending method calls");
+    goto cleanup;
+  }
+
+  pc = self->as_pend[self->as_head++];
+
+  // make sure all queued calls are on their way
+  dbus_connection_flush(self->as_con);
+  dbus_pending_call_block(pc);
+
+  if( !(rsp = dbus_pending_call_steal_reply(pc)) )
+  {
+    log_error("%s\n", "dbus_pending_call_steal_reply");
+  }
+
+  dbus_pending_call_unref(pc);
+
+  cleanup:
+
+  if( self->as_head == self->as_tail )
+  {
+    self->as_head = self->as_tail = 0;
+  }
+
+  return rsp;
+}
+
+/* ------------------------------------------------------------------------- *
+ * alarmd_session_call  --  send method call & wait for reply
+ * ------------------------------------------------------------------------- */
+
+DBusMessage *
+alarmd_session_call(alarmd_session_t *self, DBusMessage *msg)
+{
+  DBusMessage *rsp = 0;
+  DBusError    err = DBUS_ERROR_INIT;
+
+  if( !(rsp = dbus_connection_send_with_reply_and_block(self->as_con,
+                                                        msg, -1, &err)) )
+  {
+    log_error("%s: %s: %s\n", "dbus_connection_send_with_reply_and_block",
+              err.name, err.message);
+  }
+
+  dbus_error_free(&err);
+
+  return rsp;
+}
+
+/* ------------------------------------------------------------------------- *
+ * alarmd_session_event_add
+ * ------------------------------------------------------------------------- */
+
+cookie_t
+alarmd_session_event_add(alarmd_session_t *self, const alarm_event_t *event)
+{
+  cookie_t     tag = 0;
+  DBusMessage *msg = 0;
+  DBusMessage *rsp = 0;
+
+  if( (msg = alarmd_event_add_encode_req(event)) )
+  {
+    if( (rsp = alarmd_session_call(self, msg)) )
+    {
+      tag = alarmd_event_add_decode_rsp(rsp);
+    }
+  }
+
+  if( rsp != 0 ) dbus_message_unref(rsp);
+  if( msg != 0 ) dbus_message_unref(msg);
+
+  return tag;
+}
+
+/* ------------------------------------------------------------------------- *
+ * alarmd_session_event_add_send
+ * ------------------------------------------------------------------------- */
+
+int
+alarmd_session_event_add_send(alarmd_session_t *self,
+                              const alarm_event_t *event)
+{
+  int          res = -1;
+  DBusMessage *msg = 0;
+
+  if( (msg = alarmd_event_add_encode_req(event)) )
+  {
+    res = alarmd_session_send(self, msg);
+    dbus_message_unref(msg);
+  }
+
+  return res;
+}
+
+/* ------------------------------------------------------------------------- *
+ * alarmd_session_event_add_recv
+ * ------------------------------------------------------------------------- */
+
+cookie_t
+alarmd_session_event_add_recv(alarmd_session_t *self)
+{
+  cookie_t     tag = 0;
+  DBusMessage *rsp = 0;
+
+  if( (rsp = alarmd_session_recv(self)) )
+  {
+    tag = alarmd_event_add_decode_rsp(rsp);
+    dbus_message_unref(rsp);
+  }
+
+  return tag;
+}
+
+/* ------------------------------------------------------------------------- *
+ * alarmd_session_event_del
+ * ------------------------------------------------------------------------- */
+
+int
+alarmd_session_event_del(alarmd_session_t *self, cookie_t cookie)
+{
+  int          res = -1;
+  DBusMessage *msg = 0;
+  DBusMessage *rsp = 0;
+
+  if( (msg = alarmd_event_del_encode_req(cookie)) )
+  {
+    if( (rsp = alarmd_session_call(self, msg)) )
+    {
+      res = alarmd_event_del_decode_rsp(rsp);
+    }
+  }
+
+  if( rsp != 0 ) dbus_message_unref(rsp);
+  if( msg != 0 ) dbus_message_unref(msg);
+
+  return res;
+}
+
 /* ------------------------------------------------------------------------- *
  * alarmd_event_update
  * ------------------------------------------------------------------------- */
@@ -399,6 +702,85 @@ alarmd_event_add(const alarm_event_t *event)
   return alarmd_event_add_with_dbus_params(event, DBUS_TYPE_INVALID);
 }
 
+/* ------------------------------------------------------------------------- *
+ * alarmd_event_query_full
+ * ------------------------------------------------------------------------- */
+
+DBusMessage *
+alarmd_event_query_full_encode_req(const time_t first, const time_t last,
+                                   int32_t flag_mask, int32_t flags,
+                                   const char *appid, unsigned fields)
+{
+  dbus_int32_t  lo  = first;
+  dbus_int32_t  hi  = last;
+  dbus_int32_t  msk = flag_mask;
+  dbus_int32_t  flg = flags;
+  dbus_uint32_t fld = fields;
+
+  if( appid == 0 )
+  {
+    appid = "";
+  }
+
+  return client_make_method_message(ALARMD_EVENT_QUERY_FULL,
+                                    DBUS_TYPE_INT32,  &lo,
+                                    DBUS_TYPE_INT32,  &hi,
+                                    DBUS_TYPE_INT32,  &msk,
+                                    DBUS_TYPE_INT32,  &flg,
+                                    DBUS_TYPE_STRING, &appid,
+                                    DBUS_TYPE_UINT32, &fld,
+                                    DBUS_TYPE_INVALID);
+}
+
+alarm_event_t **
+alarmd_event_query_full_decode_rsp(DBusMessage *rsp)
+{
+  alarm_event_t **vec = 0;
+
+  if( dbus_message_get_type(rsp) == DBUS_MESSAGE_TYPE_ERROR )
+  {
+    // get error from error reply
+    DBusError   err  = DBUS_ERROR_INIT;
+    const char *name = dbus_message_get_error_name(rsp) ?: "noname";
+    const char *mesg = "nomesg";
+    dbus_message_get_args(rsp, &err,
+                          DBUS_TYPE_STRING, &mesg,
+                          DBUS_TYPE_INVALID);
+    log_error_F("%s: %s\n", name, mesg);
+    dbus_error_free(&err);
+  }
+  else
+  {
+    vec = dbusif_decode_events(rsp, 0);
+  }
+  return vec;
+}
+
+alarm_event_t **
+alarmd_event_query_full(const time_t first, const time_t last,
+                        int32_t flag_mask, int32_t flags,
+                        const char *appid, unsigned fields)
+{
+  alarm_event_t **res = 0;
+  DBusMessage    *msg = 0;
+  DBusMessage    *rsp = 0;
+
+  if( (msg = alarmd_event_query_full_encode_req(first, last,
+                                                flag_mask, flags,
+                                                appid, fields)) )
+  {
+    if( client_exec_method_call(msg, &rsp) != -1 )
+    {
+      res = alarmd_event_query_full_decode_rsp(rsp);
+    }
+  }
+
+  if( rsp != 0 ) dbus_message_unref(rsp);
+  if( msg != 0 ) dbus_message_unref(msg);
+
+  return res;
+}
+
 /* ------------------------------------------------------------------------- *
  * alarmd_event_get
  * ------------------------------------------------------------------------- */
@@ -516,6 +898,193 @@ alarmd_event_del(cookie_t cookie)
   return res;
 }
 
+/* ------------------------------------------------------------------------- *
+ * alarmd_event_add_many
+ * ------------------------------------------------------------------------- */
+
+DBusMessage *
+alarmd_event_add_many_encode_req(const alarm_event_t * const *events,
+                                 int count)
+{
+  DBusMessage *msg = 0;
+
+  if( count < 0 )
+  {
+    goto cleanup;
+  }
+
+  for( int i = 0; i < count; ++i )
+  {
+    if( alarm_event_is_sane(events[i]) == -1 )
+    {
+      goto cleanup;
+    }
+  }
+
+  if( (msg = client_make_method_message(ALARMD_EVENTS_ADD, DBUS_TYPE_INVALID)) )
+  {
+    if( !dbusif_encode_events(msg, events, count, ALARM_QUERY_ALL) )
+    {
+      dbus_message_unref(msg), msg = 0;
+    }
+  }
+
+  cleanup:
+
+  return msg;
+}
+
+int
+alarmd_event_add_many_decode_rsp(DBusMessage *rsp, cookie_t *cookies,
+                                 int count)
+{
+  int           res = -1;
+  dbus_int32_t *vec = 0;
+  int           cnt = 0;
+  DBusError     err = DBUS_ERROR_INIT;
+
+  if( client_parse_reply(rsp, &err,
+                         DBUS_TYPE_ARRAY, DBUS_TYPE_INT32, &vec, &cnt,
+                         DBUS_TYPE_INVALID) )
+  {
+    if( cnt != count )
+    {
+      log_error_F("expected %d cookies, got %d\n", count, cnt);
+      goto cleanup;
+    }
+
+    res = 0;
+    for( int i = 0; i < cnt; ++i )
+    {
+      if( cookies != 0 ) cookies[i] = vec[i];
+      if( vec[i] != 0 ) ++res;
+    }
+  }
+
+  cleanup:
+
+  if( dbus_error_is_set(&err) )
+  {
+    log_error_F("%s: %s\n", err.name, err.message);
+  }
+
+  dbus_error_free(&err);
+
+  return res;
+}
+
+int
+alarmd_event_add_many(const alarm_event_t * const *events, int count,
+                      cookie_t *cookies)
+{
+  int            res = -1;
+  DBusMessage   *msg = 0;
+  DBusMessage   *rsp = 0;
+
+  if( (msg = alarmd_event_add_many_encode_req(events, count)) )
+  {
+    if( client_exec_method_call(msg, &rsp) != -1 )
+    {
+      res = alarmd_event_add_many_decode_rsp(rsp, cookies, count);
+    }
+  }
+
+  if( rsp != 0 ) dbus_message_unref(rsp);
+  if( msg != 0 ) dbus_message_unref(msg);
+
+  return res;
+}
+
+/* ------------------------------------------------------------------------- *
+ * alarmd_event_del_many
+ * ------------------------------------------------------------------------- */
+
+DBusMessage *
+alarmd_event_del_many_encode_req(const cookie_t *cookies, int count)
+{
+  DBusMessage  *msg = 0;
+  dbus_int32_t *vec = 0;
+
+  if( count < 0 )
+  {
+    goto cleanup;
+  }
+
+  vec = calloc(count + 1, sizeof *vec);
+  for( int i = 0; i < count; ++i )
+  {
+    vec[i] = cookies[i];
+  }
+
+  msg = client_make_method_message(ALARMD_EVENTS_DEL,
+                                   DBUS_TYPE_ARRAY, DBUS_TYPE_INT32, &vec, count,
+                                   DBUS_TYPE_INVALID);
+  cleanup:
+
+  free(vec);
+
+  return msg;
+}
+
+int
+alarmd_event_del_many_decode_rsp(DBusMessage *rsp, int *deleted, int count)
+{
+  int           res = -1;
+  dbus_bool_t  *vec = 0;
+  int           cnt = 0;
+  DBusError     err = DBUS_ERROR_INIT;
+
+  if( client_parse_reply(rsp, &err,
+                         DBUS_TYPE_ARRAY, DBUS_TYPE_BOOLEAN, &vec, &cnt,
+                         DBUS_TYPE_INVALID) )
+  {
+    if( cnt != count )
+    {
+      log_error_F("expected %d results, got %d\n", count, cnt);
+      goto cleanup;
+    }
+
+    res = 0;
+    for( int i = 0; i < cnt; ++i )
+    {
+      if( deleted != 0 ) deleted[i] = (vec[i] != 0);
+      if( vec[i] != 0 ) ++res;
+    }
+  }
+
+  cleanup:
+
+  if( dbus_error_is_set(&err) )
+  {
+    log_error_F("%s: %s\n", err.name, err.message);
+  }
+
+  dbus_error_free(&err);
+
+  return res;
+}
+
+int
+alarmd_event_del_many(const cookie_t *cookies, int count, int *deleted)
+{
+  int            res = -1;
+  DBusMessage   *msg = 0;
+  DBusMessage   *rsp = 0;
+
+  if( (msg = alarmd_event_del_many_encode_req(cookies, count)) )
+  {
+    if( client_exec_method_call(msg, &rsp) != -1 )
+    {
+      res = alarmd_event_del_many_decode_rsp(rsp, deleted, count);
+    }
+  }
+
+  if( rsp != 0 ) dbus_message_unref(rsp);
+  if( msg != 0 ) dbus_message_unref(msg);
+
+  return res;
+}
+
 /* ------------------------------------------------------------------------- *
  * alarmd_event_query
  * ------------------------------------------------------------------------- */
@@ -596,6 +1165,183 @@ alarmd_event_query(const time_t first, const time_t last,
   return res;
 }
 
+/* ------------------------------------------------------------------------- *
+ * alarmd_event_query_page
+ * ------------------------------------------------------------------------- */
+
+DBusMessage *
+alarmd_event_query_page_encode_req(const time_t first, const time_t last,
+                                   int32_t flag_mask, int32_t flags,
+                                   const char *appid, unsigned limit,
+                                   const char *cursor)
+{
+  dbus_int32_t  lo  = first;
+  dbus_int32_t  hi  = last;
+  dbus_int32_t  msk = flag_mask;
+  dbus_int32_t  flg = flags;
+  dbus_uint32_t lim = limit;
+
+  if( appid == 0 )
+  {
+    appid = "";
+  }
+  if( cursor == 0 )
+  {
+    cursor = "";
+  }
+
+  return client_make_method_message(ALARMD_EVENT_QUERY_PAGE,
+                                    DBUS_TYPE_INT32,  &lo,
+                                    DBUS_TYPE_INT32,  &hi,
+                                    DBUS_TYPE_INT32,  &msk,
+                                    DBUS_TYPE_INT32,  &flg,
+                                    DBUS_TYPE_STRING, &appid,
+                                    DBUS_TYPE_UINT32, &lim,
+                                    DBUS_TYPE_STRING, &cursor,
+                                    DBUS_TYPE_INVALID);
+}
+
+cookie_t *
+alarmd_event_query_page_decode_rsp(DBusMessage *rsp, char **pcursor)
+{
+  cookie_t     *res = 0;
+  dbus_int32_t *vec = 0;
+  int           cnt = 0;
+  const char   *cur = 0;
+  DBusError     err = DBUS_ERROR_INIT;
+
+  if( client_parse_reply(rsp, &err,
+                         DBUS_TYPE_ARRAY, DBUS_TYPE_INT32, &vec, &cnt,
+                         DBUS_TYPE_STRING, &cur,
+                         DBUS_TYPE_INVALID) )
+  {
+    res = calloc(cnt+1, sizeof *res);
+    for( int i = 0; i < cnt; ++i )
+    {
+      res[i] = vec[i];
+    }
+    if( pcursor != 0 )
+    {
+      free(*pcursor);
+      *pcursor = strdup(cur);
+    }
+  }
+
+  if( dbus_error_is_set(&err) )
+  {
+    log_error_F("%s: %s\n", err.name, err.message);
+  }
+
+  dbus_error_free(&err);
+
+  return res;
+}
+
+/* ------------------------------------------------------------------------- *
+ * alarm_query_t  --  state of paged alarm query
+ * ------------------------------------------------------------------------- */
+
+struct alarm_query_t
+{
+  time_t    aq_first;
+  time_t    aq_last;
+  int32_t   aq_flag_mask;
+  int32_t   aq_flags;
+  char     *aq_appid;
+  unsigned  aq_chunk;
+
+  /* continuation token from the previous reply,
+   * NULL after the last page has been received */
+  char     *aq_cursor;
+};
+
+/* ------------------------------------------------------------------------- *
+ * alarmd_event_query_open
+ * ------------------------------------------------------------------------- */
+
+alarm_query_t *
+alarmd_event_query_open(const time_t first, const time_t last,
+                        int32_t flag_mask, int32_t flags,
+                        const char *appid, unsigned chunk)
+{
+  alarm_query_t *self = calloc(1, sizeof *self);
+
+  self->aq_first     = first;
+  self->aq_last      = last;
+  self->aq_flag_mask = flag_mask;
+  self->aq_flags     = flags;
+  self->aq_appid     = strdup(appid ?: "");
+  self->aq_chunk     = chunk ?: ALARM_QUERY_CHUNK_DEFAULT;
+  self->aq_cursor    = strdup("");
+
+  return self;
+}
+
+/* ------------------------------------------------------------------------- *
+ * alarmd_event_query_next
+ * ------------------------------------------------------------------------- */
+
+cookie_t *
+alarmd_event_query_next(alarm_query_t *self)
+{
+  cookie_t    *res = 0;
+  DBusMessage *msg = 0;
+  DBusMessage *rsp = 0;
+
+  if( self == 0 || self->aq_cursor == 0 )
+  {
+    goto cleanup;
+  }
+
+  if( (msg = alarmd_event_query_page_encode_req(self->aq_first,
+                                                self->aq_last,
+                                                self->aq_flag_mask,
+                                                self->aq_flags,
+                                                self->aq_appid,
+                                                self->aq_chunk,
+                                                self->aq_cursor)) )
+  {
+    if( client_exec_method_call(msg, &rsp) != -1 )
+    {
+      res = alarmd_event_query_page_decode_rsp(rsp, &self->aq_cursor);
+    }
+  }
+
+  if( res == 0 || *self->aq_cursor == 0 )
+  {
+    // error or last page: no more requests
+    free(self->aq_cursor), self->aq_cursor = 0;
+  }
+
+  if( res != 0 && *res == 0 )
+  {
+    // do not report empty pages
+    free(res), res = 0;
+  }
+
+  cleanup:
+
+  if( rsp != 0 ) dbus_message_unref(rsp);
+  if( msg != 0 ) dbus_message_unref(msg);
+
+  return res;
+}
+
+/* ------------------------------------------------------------------------- *
+ * alarmd_event_query_close
+ * ------------------------------------------------------------------------- */
+
+void
+alarmd_event_query_close(alarm_query_t *self)
+{
+  if( self != 0 )
+  {
+    free(self->aq_appid);
+    free(self->aq_cursor);
+    free(self);
+  }
+}
+
 /* ------------------------------------------------------------------------- *
  * alarmd_get_default_snooze
  * ------------------------------------------------------------------------- */
@@ -27,6 +27,7 @@
 #include "codec.h"
 
 #include "logging.h"
+#include "unique.h"
 
 #include <stdlib.h>
 #include <string.h>
@@ -249,6 +250,14 @@ decode_dstring(DBusMessageIter *iter, int *err, char **pval)
   *pval = strdup(tmp ?: "");
 }
 
+void
+decode_istring(DBusMessageIter *iter, int *err, char **pval)
+{
+  const char *tmp = 0;
+  decode_string(iter, err, &tmp);
+  unique_strset(pval, tmp ?: "");
+}
+
 void
 encode_size(DBusMessageIter *iter, int *err, const size_t *pval)
 {
@@ -350,10 +359,10 @@ decode_action(DBusMessageIter *iter, int *err, alarm_action_t *act)
   decode_unsigned (iter, err, &act->flags);
   decode_dstring  (iter, err, &act->label);
   decode_dstring  (iter, err, &act->exec_command);
-  decode_dstring  (iter, err, &act->dbus_interface);
-  decode_dstring  (iter, err, &act->dbus_service);
-  decode_dstring  (iter, err, &act->dbus_path);
-  decode_dstring  (iter, err, &act->dbus_name);
+  decode_istring  (iter, err, &act->dbus_interface);
+  decode_istring  (iter, err, &act->dbus_service);
+  decode_istring  (iter, err, &act->dbus_path);
+  decode_istring  (iter, err, &act->dbus_name);
   decode_dstring  (iter, err, &act->dbus_args);
 }
 
@@ -395,9 +404,18 @@ encode_attr(DBusMessageIter *iter, int *err, const alarm_attr_t *att)
 }
 
 void
-decode_attr(DBusMessageIter *iter, int *err, alarm_attr_t *att)
+decode_attr(DBusMessageIter *iter, int *err, alarm_event_t *eve)
 {
-  decode_dstring(iter, err, &att->attr_name);
+  alarm_attr_t *att  = 0;
+  char         *name = 0;
+
+  // attr_tab is kept sorted by name, the name must
+  // be known before the attribute is added
+  decode_dstring(iter, err, &name);
+  att = alarm_event_add_attr(eve, name ?: "");
+  free(name);
+
+  alarm_attr_set_null(att);
   decode_int    (iter, err, &att->attr_type);
 
   switch( att->attr_type )
@@ -450,6 +468,35 @@ encode_event(DBusMessageIter *iter, int *err, const alarm_event_t *eve,
   }
 }
 
+void
+encode_event_fields(DBusMessageIter *iter, int *err, const alarm_event_t *eve,
+                    unsigned fields)
+{
+  /* Omitted field groups are encoded as empty, so that
+   * the result can be parsed with decode_event() */
+
+  alarm_event_t tmp = *eve;
+
+  if( !(fields & ALARM_QUERY_TEXT) )
+  {
+    tmp.title = tmp.message = tmp.sound = tmp.icon = 0;
+  }
+  if( !(fields & ALARM_QUERY_ACTIONS) )
+  {
+    tmp.action_cnt = 0;
+  }
+  if( !(fields & ALARM_QUERY_RECURRENCES) )
+  {
+    tmp.recurrence_cnt = 0;
+  }
+  if( !(fields & ALARM_QUERY_ATTRS) )
+  {
+    tmp.attr_cnt = 0;
+  }
+
+  encode_event(iter, err, &tmp, 0);
+}
+
 static
 int
 decode_eom_p(DBusMessageIter *iter, int *err)
@@ -477,13 +524,13 @@ decode_event(DBusMessageIter *iter, int *err, alarm_event_t *eve)
   decode_time     (iter, err, &eve->ALARMD_PRIVATE(trigger));
   decode_dstring  (iter, err, &eve->title);
   decode_dstring  (iter, err, &eve->message);
-  decode_dstring  (iter, err, &eve->sound);
-  decode_dstring  (iter, err, &eve->icon);
+  decode_istring  (iter, err, &eve->sound);
+  decode_istring  (iter, err, &eve->icon);
   decode_unsigned (iter, err, &eve->flags);
-  decode_dstring  (iter, err, &eve->alarm_appid);
+  decode_istring  (iter, err, &eve->alarm_appid);
   decode_time     (iter, err, &eve->alarm_time);
   decode_tm       (iter, err, &eve->alarm_tm);
-  decode_dstring  (iter, err, &eve->alarm_tz);
+  decode_istring  (iter, err, &eve->alarm_tz);
   decode_time     (iter, err, &eve->recur_secs);
   decode_int      (iter, err, &eve->recur_count);
   decode_time     (iter, err, &eve->snooze_secs);
@@ -522,8 +569,7 @@ decode_event(DBusMessageIter *iter, int *err, alarm_event_t *eve)
     decode_size     (iter, err, &count);
     for( size_t i = 0; i < count; ++i )
     {
-      alarm_attr_t *att = alarm_event_add_attr(eve, "\x7f");
-      decode_attr(iter, err, att);
+      decode_attr(iter, err, eve);
     }
   }
 }
@@ -48,6 +48,7 @@ void encode_time    (DBusMessageIter *iter, int *err, const time_t *pval);
 void encode_tm      (DBusMessageIter *iter, int *err, const struct tm *tm);
 void encode_action  (DBusMessageIter *iter, int *err, const alarm_action_t *act, const char **def_args);
 void encode_event   (DBusMessageIter *iter, int *err, const alarm_event_t *eve, const char **def_args);
+void encode_event_fields(DBusMessageIter *iter, int *err, const alarm_event_t *eve, unsigned fields);
 void encode_uint32  (DBusMessageIter *iter, int *err, const uint32_t *pval);
 void encode_uint64  (DBusMessageIter *iter, int *err, const uint64_t *pval);
 void encode_recur   (DBusMessageIter *iter, int *err, const alarm_recur_t *rec);
@@ -60,6 +61,7 @@ void decode_unsigned(DBusMessageIter *iter, int *err, unsigned *pval);
 void decode_int     (DBusMessageIter *iter, int *err, int *pval);
 void decode_string  (DBusMessageIter *iter, int *err, const char **pval);
 void decode_dstring (DBusMessageIter *iter, int *err, char **pval);
+void decode_istring (DBusMessageIter *iter, int *err, char **pval);
 void decode_size    (DBusMessageIter *iter, int *err, size_t *pval);
 void decode_cookie  (DBusMessageIter *iter, int *err, cookie_t *pval);
 void decode_time    (DBusMessageIter *iter, int *err, time_t *pval);
@@ -69,7 +71,7 @@ void decode_event   (DBusMessageIter *iter, int *err, alarm_event_t *eve);
 void decode_uint32  (DBusMessageIter *iter, int *err, uint32_t *pval);
 void decode_uint64  (DBusMessageIter *iter, int *err, uint64_t *pval);
 void decode_recur   (DBusMessageIter *iter, int *err, alarm_recur_t *rec);
-void decode_attr    (DBusMessageIter *iter, int *err, alarm_attr_t *rec);
+void decode_attr    (DBusMessageIter *iter, int *err, alarm_event_t *eve);
 
 # ifdef __cplusplus
 };
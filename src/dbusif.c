@@ -309,6 +309,86 @@ dbusif_decode_event(DBusMessage *msg)
   return eve;
 }
 
+/* ------------------------------------------------------------------------- *
+ * dbusif_encode_events  --  event count followed by events
+ *
+ * The fields bitmask (alarmqueryfields) selects what parts of the
+ * events are included.
+ * ------------------------------------------------------------------------- */
+
+dbus_bool_t
+dbusif_encode_events(DBusMessage *msg, const alarm_event_t * const *vec,
+                     size_t cnt, unsigned fields)
+{
+  int err = 0;
+
+  DBusMessageIter iter;
+
+  dbus_message_iter_init_append(msg, &iter);
+
+  encode_size(&iter, &err, &cnt);
+
+  for( size_t i = 0; i < cnt && err == 0; ++i )
+  {
+    encode_event_fields(&iter, &err, vec[i], fields);
+  }
+
+  return (err == 0);
+}
+
+/* ------------------------------------------------------------------------- *
+ * dbusif_decode_events  --  NULL terminated array of events
+ * ------------------------------------------------------------------------- */
+
+alarm_event_t **
+dbusif_decode_events(DBusMessage *msg, size_t *pcnt)
+{
+  alarm_event_t **vec = 0;
+  size_t          cnt = 0;
+  size_t          got = 0;
+  size_t          max = 0;
+  int             err = 0;
+  DBusMessageIter iter;
+
+  dbus_message_iter_init(msg, &iter);
+  decode_size(&iter, &err, &cnt);
+
+  /* - - - - - - - - - - - - - - - - - - - *
+   * the count comes from the client, so
+   * the array is grown only as events are
+   * actually decoded
+   * - - - - - - - - - - - - - - - - - - - */
+
+  for( ; got < cnt && err == 0; ++got )
+  {
+    if( got == max )
+    {
+      max = max ? (max * 2) : 32;
+      vec = realloc(vec, (max + 1) * sizeof *vec);
+    }
+    vec[got] = alarm_event_create();
+    decode_event(&iter, &err, vec[got]);
+  }
+
+  if( err != 0 )
+  {
+    for( size_t i = 0; i < got; ++i )
+    {
+      alarm_event_delete(vec[i]);
+    }
+    free(vec), vec = 0, got = 0;
+  }
+  else
+  {
+    vec = realloc(vec, (got + 1) * sizeof *vec);
+    vec[got] = 0;
+  }
+
+  if( pcnt ) *pcnt = got;
+
+  return vec;
+}
+
 /* ========================================================================= *
  * GENERIC DBUS HELPERS
  * ========================================================================= */
@@ -426,6 +506,8 @@ dbusif_send_and_receive(DBusConnection *con, DBusMessage *msg, DBusMessage **prs
 
 /* ------------------------------------------------------------------------- *
  * dbusif_send_async
+ *
+ * The user_data is released with user_free also if sending fails.
  * ------------------------------------------------------------------------- */
 
 #if PENDING_CALL_PARANOIA
@@ -568,10 +650,16 @@ dbusif_send_async(DBusConnection *con, DBusMessage *msg,
 #if PENDING_CALL_PARANOIA
   if( gate != 0 )
   {
-    dbusif_pending_gate_free(gate);
+    // releases also the user_data
+    dbusif_pending_gate_free(gate), user_free = 0;
   }
 #endif
 
+  if( res == -1 && user_free != 0 && user_data != 0 )
+  {
+    user_free(user_data);
+  }
+
   if( pen != 0 )
   {
     dbus_pending_call_unref(pen);
@@ -769,6 +857,8 @@ dbusif_method_call(DBusConnection *con,   DBusMessage **prsp,
 
 /* ------------------------------------------------------------------------- *
  * dbusif_method_call_async
+ *
+ * The user_data is released with user_free also if sending fails.
  * ------------------------------------------------------------------------- */
 
 int
@@ -791,6 +881,10 @@ dbusif_method_call_async(DBusConnection *con,
   {
     res = dbusif_send_async(con, msg, cb, user_data, user_free);
   }
+  else if( user_free != 0 && user_data != 0 )
+  {
+    user_free(user_data);
+  }
 
   if( msg != 0 )
   {
@@ -29,6 +29,7 @@
 #include "logging.h"
 #include "xutil.h"
 #include "ticker.h"
+#include "unique.h"
 
 #include <stdio.h>
 
@@ -99,10 +100,10 @@ alarm_event_dtor(alarm_event_t *self)
 {
   free(self->title);
   free(self->message);
-  free(self->sound);
-  free(self->icon);
-  free(self->alarm_appid);
-  free(self->alarm_tz);
+  unique_release(self->sound);
+  unique_release(self->icon);
+  unique_release(self->alarm_appid);
+  unique_release(self->alarm_tz);
 
   alarm_event_del_actions(self);
   alarm_event_del_recurrences(self);
@@ -418,7 +419,7 @@ alarm_event_get_sound(const alarm_event_t *self)
 void
 alarm_event_set_sound(alarm_event_t *self, const char *sound)
 {
-  xstrset(&self->sound, sound);
+  unique_strset(&self->sound, sound);
 }
 
 /* ------------------------------------------------------------------------- *
@@ -438,7 +439,7 @@ alarm_event_get_icon(const alarm_event_t *self)
 void
 alarm_event_set_icon(alarm_event_t *self, const char *icon)
 {
-  xstrset(&self->icon, icon);
+  unique_strset(&self->icon, icon);
 }
 
 /* ------------------------------------------------------------------------- *
@@ -458,7 +459,7 @@ alarm_event_get_alarm_appid(const alarm_event_t *self)
 void
 alarm_event_set_alarm_appid(alarm_event_t *self, const char *alarm_appid)
 {
-  xstrset(&self->alarm_appid, alarm_appid);
+  unique_strset(&self->alarm_appid, alarm_appid);
 }
 
 /* ------------------------------------------------------------------------- *
@@ -478,7 +479,7 @@ alarm_event_get_alarm_tz(const alarm_event_t *self)
 void
 alarm_event_set_alarm_tz(alarm_event_t *self, const char *alarm_tz)
 {
-  xstrset(&self->alarm_tz, alarm_tz);
+  unique_strset(&self->alarm_tz, alarm_tz);
 }
 
 /* ------------------------------------------------------------------------- *
@@ -855,38 +856,58 @@ alarm_event_del_attrs(alarm_event_t *self)
   self->attr_tab       = 0;
 }
 
-void
-alarm_event_rem_attr(alarm_event_t *self, const char *name)
+/* ------------------------------------------------------------------------- *
+ * alarm_event_find_attr  --  binary search from name sorted attr_tab
+ *
+ * Returns 1 and sets *ppos to index of the attribute if found, or
+ * returns 0 and sets *ppos to index where it should be inserted.
+ * ------------------------------------------------------------------------- */
+
+static int
+alarm_event_find_attr(const alarm_event_t *self, const char *name, size_t *ppos)
 {
-  size_t k = 0;
-  for( size_t i = 0; i < self->attr_cnt; ++i )
+  size_t lo = 0;
+  size_t hi = self->attr_cnt;
+
+  while( lo < hi )
   {
-    alarm_attr_t *att = self->attr_tab[i];
-    if( !strcmp(att->attr_name, name) )
-    {
-      alarm_attr_delete(att);
-    }
-    else
+    size_t i = lo + (hi - lo) / 2;
+    int    r = strcmp(self->attr_tab[i]->attr_name, name);
+
+    if( r == 0 )
     {
-      self->attr_tab[k++] = att;
+      *ppos = i;
+      return 1;
     }
+
+    if( r < 0 ) lo = i + 1; else hi = i;
   }
-  self->attr_cnt = k;
+
+  *ppos = lo;
+  return 0;
 }
 
-alarm_attr_t *
-alarm_event_get_attr(alarm_event_t *self, const char *name)
+void
+alarm_event_rem_attr(alarm_event_t *self, const char *name)
 {
+  size_t i = 0;
 
-  for( size_t i = 0; i < self->attr_cnt; ++i )
+  if( alarm_event_find_attr(self, name, &i) )
   {
-    alarm_attr_t *res = self->attr_tab[i];
-    if( !strcmp(res->attr_name, name) )
-    {
-      return res;
-    }
+    alarm_attr_delete(self->attr_tab[i]);
+
+    self->attr_cnt -= 1;
+    memmove(&self->attr_tab[i], &self->attr_tab[i+1],
+            (self->attr_cnt - i) * sizeof *self->attr_tab);
   }
-  return 0;
+}
+
+alarm_attr_t *
+alarm_event_get_attr(alarm_event_t *self, const char *name)
+{
+  size_t i = 0;
+
+  return alarm_event_find_attr(self, name, &i) ? self->attr_tab[i] : 0;
 }
 
 int
@@ -898,16 +919,24 @@ alarm_event_has_attr(alarm_event_t *self, const char *name)
 alarm_attr_t *
 alarm_event_add_attr(alarm_event_t *self, const char *name)
 {
-  alarm_attr_t *res = alarm_event_get_attr(self, name);
+  size_t        i   = 0;
+  alarm_attr_t *res = 0;
 
-  if( res == 0 )
+  if( alarm_event_find_attr(self, name, &i) )
+  {
+    res = self->attr_tab[i];
+  }
+  else
   {
     res = alarm_attr_create(name);
 
-    self->attr_cnt += 1;
+    // keep the table sorted by name
     self->attr_tab = realloc(self->attr_tab,
-                             self->attr_cnt * sizeof *self->attr_tab);
-    self->attr_tab[self->attr_cnt-1] = res;
+                             (self->attr_cnt + 1) * sizeof *self->attr_tab);
+    memmove(&self->attr_tab[i+1], &self->attr_tab[i],
+            (self->attr_cnt - i) * sizeof *self->attr_tab);
+    self->attr_tab[i] = res;
+    self->attr_cnt += 1;
   }
 
   return res;
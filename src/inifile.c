@@ -112,6 +112,16 @@ inival_compare_cb(const void *self, const void *key)
   return inival_compare(self, key);
 }
 
+/* ------------------------------------------------------------------------- *
+ * inival_key_cb
+ * ------------------------------------------------------------------------- */
+
+const void *
+inival_key_cb(const void *self)
+{
+  return ((const inival_t *)self)->iv_key;
+}
+
 /* ------------------------------------------------------------------------- *
  * inival_delete_cb
  * ------------------------------------------------------------------------- */
@@ -138,6 +148,10 @@ inisec_ctor(inisec_t *self)
   symtab_ctor(&self->is_values,
               inival_delete_cb,
               inival_compare_cb);
+
+  symtab_set_index(&self->is_values,
+                   inival_key_cb,
+                   symtab_hash_string);
 }
 
 /* ------------------------------------------------------------------------- *
@@ -201,6 +215,16 @@ inisec_compare_cb(const void *self, const void *name)
   return inisec_compare(self, name);
 }
 
+/* ------------------------------------------------------------------------- *
+ * inisec_key_cb
+ * ------------------------------------------------------------------------- */
+
+const void *
+inisec_key_cb(const void *self)
+{
+  return ((const inisec_t *)self)->is_name;
+}
+
 /* ------------------------------------------------------------------------- *
  * inisec_delete_cb
  * ------------------------------------------------------------------------- */
@@ -245,13 +269,11 @@ inisec_get(inisec_t *self, const char *key, const char *val)
  * inisec_has
  * ------------------------------------------------------------------------- */
 
-#ifdef DEAD_CODE
 int
 inisec_has(inisec_t *self, const char *key)
 {
   return symtab_lookup(&self->is_values, key) != 0;
 }
-#endif
 
 /* ------------------------------------------------------------------------- *
  * inisec_del
@@ -324,6 +346,10 @@ inifile_ctor(inifile_t *self)
   symtab_ctor(&self->if_sections,
               inisec_delete_cb,
               inisec_compare_cb);
+
+  symtab_set_index(&self->if_sections,
+                   inisec_key_cb,
+                   symtab_hash_string);
 }
 
 /* ------------------------------------------------------------------------- *
@@ -380,13 +406,11 @@ inifile_delete_cb(void *self)
  * inifile_has_section
  * ------------------------------------------------------------------------- */
 
-#ifdef DEAD_CODE
 int
 inifile_has_section(inifile_t *self, const char *sec)
 {
   return symtab_lookup(&self->if_sections, sec) != 0;
 }
-#endif
 
 /* ------------------------------------------------------------------------- *
  * inifile_get_section
@@ -420,13 +444,11 @@ inifile_add_section(inifile_t *self, const char *sec)
  * inifile_del_section
  * ------------------------------------------------------------------------- */
 
-#ifdef DEAD_CODE
 void
 inifile_del_section(inifile_t *self, const char *sec)
 {
   symtab_remove(&self->if_sections, sec);
 }
-#endif
 
 /* ------------------------------------------------------------------------- *
  * inifile_set
@@ -510,14 +532,12 @@ inifile_del(inifile_t *self, const char *sec, const char *key)
  * inifile_has
  * ------------------------------------------------------------------------- */
 
-#ifdef DEAD_CODE
 int
 inifile_has(inifile_t *self, const char *sec, const char *key)
 {
   inisec_t *s = symtab_lookup(&self->if_sections, sec);
   return s ? inisec_has(s, key) : 0;
 }
-#endif
 
 /* ------------------------------------------------------------------------- *
  * inifile_emit
@@ -726,6 +746,113 @@ inifile_load(inifile_t *self, const char *path)
   return err;
 }
 
+/* ------------------------------------------------------------------------- *
+ * inifile_replay_section  --  apply one complete section from journal
+ * ------------------------------------------------------------------------- */
+
+static
+void
+inifile_replay_section(inifile_t *self, inisec_t *sec)
+{
+  inisec_t *old = symtab_lookup(&self->if_sections, sec->is_name);
+
+  if( old != 0 )
+  {
+    // replace values, keep position
+    symtab_t tmp = old->is_values;
+    old->is_values = sec->is_values;
+    sec->is_values = tmp;
+    inisec_delete(sec);
+  }
+  else
+  {
+    symtab_append(&self->if_sections, sec);
+  }
+}
+
+/* ------------------------------------------------------------------------- *
+ * inifile_replay  --  apply section journal on top of loaded data
+ *
+ * The journal uses the same syntax as normal ini files, but each
+ * section terminated by an empty line replaces the section of the
+ * same name as a whole. A section without values marks removal;
+ * it is left in place without values, so that removals are seen
+ * also when the journal is applied on top of partial data.
+ * Sections that are not terminated, i.e. partially written ones,
+ * are ignored.
+ * ------------------------------------------------------------------------- */
+
+int
+inifile_replay(inifile_t *self, const char *path)
+{
+  int     err  = -1;
+  FILE   *file = 0;
+  size_t  size = 0;
+  char   *data = 0;
+
+  inisec_t *sec = 0;
+  char     *key  = 0;
+  char     *val  = 0;
+
+  if( (file = fopen(path, "r")) == 0 )
+  {
+    log_error("can't open '%s' for reading: %s\n", path, strerror(errno));
+    goto cleanup;
+  }
+
+  for( ;; )
+  {
+    ssize_t n = escape_getline(file, &data, &size);
+
+    if( n == -1 ) break;
+
+    if( *data == 0 )
+    {
+      if( sec != 0 )
+      {
+        inifile_replay_section(self, sec), sec = 0;
+      }
+      continue;
+    }
+
+    if( *data == '#' ) continue;
+
+    if( *data == BRA )
+    {
+      char *pos = data;
+      xsplit(&pos, BRA);
+      char *name = xstripall(xsplit(&pos, KET));
+
+      // previous section was not terminated -> ignore it
+      inisec_delete(sec);
+      sec = inisec_create(name);
+      continue;
+    }
+
+    val = data;
+    key = xsplit(&val, SEP);
+    xstripall(key);
+    xstrip(val);
+
+    if( sec && *key )
+    {
+      inisec_set(sec, key, val);
+    }
+  }
+
+  err = 0;
+
+  cleanup:
+
+  inisec_delete(sec);
+
+  free(data);
+
+  if( file != 0 ) fclose(file);
+
+  return err;
+}
+
 /* ------------------------------------------------------------------------- *
  * inifile_scan_sections
  * ------------------------------------------------------------------------- */
@@ -56,13 +56,14 @@ struct inival_t
   char *iv_val;
 };
 
-void      inival_emit      (const inival_t *self, FILE *file);
-void      inival_set       (inival_t *self, const char *val);
-inival_t *inival_create    (const char *key, const char *val);
-void      inival_delete    (inival_t *self);
-int       inival_compare   (const inival_t *self, const char *key);
-int       inival_compare_cb(const void *self, const void *key);
-void      inival_delete_cb (void *self);
+void        inival_emit      (const inival_t *self, FILE *file);
+void        inival_set       (inival_t *self, const char *val);
+inival_t   *inival_create    (const char *key, const char *val);
+void        inival_delete    (inival_t *self);
+int         inival_compare   (const inival_t *self, const char *key);
+int         inival_compare_cb(const void *self, const void *key);
+const void *inival_key_cb    (const void *self);
+void        inival_delete_cb (void *self);
 
 /* ------------------------------------------------------------------------- *
  * inisec_t
@@ -80,6 +81,7 @@ inisec_t   *inisec_create    (const char *name);
 void        inisec_delete    (inisec_t *self);
 int         inisec_compare   (const inisec_t *self, const char *name);
 int         inisec_compare_cb(const void *self, const void *name);
+const void *inisec_key_cb    (const void *self);
 void        inisec_delete_cb (void *self);
 void        inisec_set       (inisec_t *self, const char *key, const char *val);
 const char *inisec_get       (inisec_t *self, const char *key, const char *val);
@@ -127,6 +129,7 @@ int          inifile_has              (inifile_t *self, const char *sec, const c
 void         inifile_emit             (const inifile_t *self, FILE *file);
 int          inifile_save             (const inifile_t *self, const char *path);
 int          inifile_load             (inifile_t *self, const char *path);
+int          inifile_replay           (inifile_t *self, const char *path);
 inisec_t   * inifile_scan_sections    (const inifile_t *self, int (*cb)(const inisec_t*, void*), void *aptr);
 inival_t   * inifile_scan_values      (const inifile_t *self, int (*cb)(const inisec_t *, const inival_t*, void*), void *aptr);
 char       **inifile_get_section_names(const inifile_t *self, size_t *pcount);
@@ -32,10 +32,13 @@
 #include <sys/types.h>
 #include <sys/stat.h>
 #include <sys/wait.h>
+#include <sys/syscall.h>
 
 #include <pwd.h>
 #include <unistd.h>
+#include <stdlib.h>
 #include <string.h>
+#include <dirent.h>
 #include <stdio.h>
 #include <fcntl.h>
 #include <errno.h>
@@ -142,6 +145,267 @@ ipc_exec_get_exec_identity(void)
   }
 }
 
+/* ========================================================================= *
+ * SPAWNING CHILD PROCESSES
+ *
+ * Commands are executed in child processes that are forked directly
+ * from alarmd and reaped via glib child watches, so the mainloop does
+ * not need to wait for anything.
+ *
+ * A child is considered to be "starting" from fork until it has
+ * either made a successful exec or exited. The number of starting
+ * children is limited, commands exceeding the limit are queued and
+ * spawned as earlier children get started.
+ * ========================================================================= */
+
+/** Max number of simultaneously starting children, 0 = no limit */
+static int     ipc_exec_limit    = IPC_EXEC_LIMIT_DEFAULT;
+
+/** Number of children that have not yet made exec */
+static int     ipc_exec_starting = 0;
+
+/** Parsed command lines waiting to be spawned */
+static GQueue *ipc_exec_pending  = 0;
+
+/* ------------------------------------------------------------------------- *
+ * ipc_exec_close_fds  --  close all file descriptors except one
+ * ------------------------------------------------------------------------- */
+
+static
+void
+ipc_exec_close_fds(int keep)
+{
+  DIR           *dir = 0;
+  struct dirent *de  = 0;
+
+#ifdef SYS_close_range
+  if( syscall(SYS_close_range, 0, keep - 1, 0) == 0 &&
+      syscall(SYS_close_range, keep + 1, ~0U, 0) == 0 )
+  {
+    return;
+  }
+#endif
+
+  if( (dir = opendir("/proc/self/fd")) != 0 )
+  {
+    while( (de = readdir(dir)) != 0 )
+    {
+      char *end = 0;
+      int   fd  = strtol(de->d_name, &end, 10);
+
+      if( end > de->d_name && *end == 0 && fd != keep && fd != dirfd(dir) )
+      {
+        close(fd);
+      }
+    }
+    closedir(dir);
+    return;
+  }
+
+  for( int fd = 0, fdmax = sysconf(_SC_OPEN_MAX); fd < fdmax; ++fd )
+  {
+    if( fd != keep ) close(fd);
+  }
+}
+
+/* ------------------------------------------------------------------------- *
+ * ipc_exec_child  --  child process side of spawning, does not return
+ * ------------------------------------------------------------------------- */
+
+static
+void
+ipc_exec_child(char **argv, int status_fd)
+{
+  int err = EPERM;
+
+  setsid();
+
+  if( geteuid() == 0 && ipc_exec_drop_privileges() != 0 )
+  {
+    goto cleanup;
+  }
+
+  if( chdir("/") == -1 )
+  {
+    err = errno;
+    goto cleanup;
+  }
+  umask(0);
+
+  ipc_exec_close_fds(status_fd);
+  open("/dev/null", O_RDONLY);
+  open("/dev/null", O_WRONLY);
+  open("/dev/null", O_WRONLY);
+
+  if( geteuid() > 0 && getuid() > 0 )
+  {
+    execvp(*argv, argv);
+    err = errno;
+  }
+
+  cleanup:
+
+  /* status_fd is close-on-exec: parent gets either errno or eof.
+   * If even that fails, only the exit status is left to tell. */
+  while( write(status_fd, &err, sizeof err) == -1 && errno == EINTR )
+  {
+  }
+  _exit(127);
+}
+
+/* ------------------------------------------------------------------------- *
+ * ipc_exec_reap_cb  --  child process has exited
+ * ------------------------------------------------------------------------- */
+
+static
+void
+ipc_exec_reap_cb(GPid pid, gint status, gpointer data)
+{
+  if( WIFSIGNALED(status) )
+  {
+    log_warning("EXEC: pid %d terminated by signal %d\n",
+                (int)pid, WTERMSIG(status));
+  }
+  else if( WIFEXITED(status) && WEXITSTATUS(status) == 127 )
+  {
+    // could also be failure to exec without status report
+    log_warning("EXEC: pid %d exited with %d\n",
+                (int)pid, WEXITSTATUS(status));
+  }
+  else if( WIFEXITED(status) && WEXITSTATUS(status) != 0 )
+  {
+    log_info("EXEC: pid %d exited with %d\n",
+             (int)pid, WEXITSTATUS(status));
+  }
+
+  g_spawn_close_pid(pid);
+}
+
+static void ipc_exec_dispatch(void);
+
+/* ------------------------------------------------------------------------- *
+ * ipc_exec_started_cb  --  child process has made exec or failed
+ * ------------------------------------------------------------------------- */
+
+static
+gboolean
+ipc_exec_started_cb(GIOChannel *channel, GIOCondition condition, gpointer data)
+{
+  const char *cmd = data;
+  int         err = 0;
+
+  if( read(g_io_channel_unix_get_fd(channel), &err, sizeof err) == sizeof err )
+  {
+    log_error("EXEC: %s: %s\n", cmd, strerror(err));
+  }
+
+  ipc_exec_starting -= 1;
+  ipc_exec_dispatch();
+
+  // remove io watch, closes the pipe
+  return FALSE;
+}
+
+/* ------------------------------------------------------------------------- *
+ * ipc_exec_spawn  --  start command in a child process
+ * ------------------------------------------------------------------------- */
+
+static
+int
+ipc_exec_spawn(char **argv)
+{
+  int         err     = -1;
+  int         pfd[2]  = { -1, -1 };
+  pid_t       child   = -1;
+  GIOChannel *channel = 0;
+
+  if( pipe2(pfd, O_CLOEXEC) == -1 )
+  {
+    log_error("EXEC: pipe: %s\n", strerror(errno));
+    goto cleanup;
+  }
+
+  fflush(0);
+
+  if( (child = fork()) == -1 )
+  {
+    log_error("FORK: %s: %s\n", *argv, strerror(errno));
+    goto cleanup;
+  }
+
+  if( child == 0 )
+  {
+    ipc_exec_child(argv, pfd[1]);
+  }
+
+  log_debug("EXEC: %s: pid %d\n", *argv, (int)child);
+
+  g_child_watch_add(child, ipc_exec_reap_cb, 0);
+
+  close(pfd[1]), pfd[1] = -1;
+
+  if( (channel = g_io_channel_unix_new(pfd[0])) == 0 )
+  {
+    goto cleanup;
+  }
+  g_io_channel_set_close_on_unref(channel, TRUE), pfd[0] = -1;
+
+  g_io_add_watch_full(channel, G_PRIORITY_DEFAULT,
+                      G_IO_IN | G_IO_HUP | G_IO_ERR,
+                      ipc_exec_started_cb, g_strdup(*argv), g_free);
+
+  ipc_exec_starting += 1;
+  err = 0;
+
+  cleanup:
+
+  if( channel != 0 )
+  {
+    g_io_channel_unref(channel);
+  }
+
+  if( pfd[0] != -1 ) close(pfd[0]);
+  if( pfd[1] != -1 ) close(pfd[1]);
+
+  return err;
+}
+
+/* ------------------------------------------------------------------------- *
+ * ipc_exec_dispatch  --  spawn queued commands while within limits
+ * ------------------------------------------------------------------------- */
+
+static
+void
+ipc_exec_dispatch(void)
+{
+  gchar **argv = 0;
+
+  while( ipc_exec_pending != 0 && !g_queue_is_empty(ipc_exec_pending) )
+  {
+    if( ipc_exec_limit > 0 && ipc_exec_starting >= ipc_exec_limit )
+    {
+      log_debug("EXEC: %d starting, %u queued\n", ipc_exec_starting,
+                g_queue_get_length(ipc_exec_pending));
+      break;
+    }
+
+    argv = g_queue_pop_head(ipc_exec_pending);
+    ipc_exec_spawn(argv);
+    g_strfreev(argv);
+  }
+}
+
+/* ------------------------------------------------------------------------- *
+ * ipc_exec_set_limit  --  set max number of simultaneously starting children
+ * ------------------------------------------------------------------------- */
+
+void
+ipc_exec_set_limit(int limit)
+{
+  ipc_exec_limit = (limit < 0) ? 0 : limit;
+  ipc_exec_dispatch();
+}
+
 /* ------------------------------------------------------------------------- *
  * ipc_exec_run_command  --  execute command in detached child process
  * ------------------------------------------------------------------------- */
@@ -150,8 +414,6 @@ int
 ipc_exec_run_command(const char *cmd)
 {
   int     err    = -1;
-  int     child  = -1;
-  int     status = 0;
   gint    argc   = 0;
   gchar **argv   = 0;
   GError *error  = 0;
@@ -174,56 +436,15 @@ ipc_exec_run_command(const char *cmd)
     goto cleanup;
   }
 
-  fflush(0);
-
-  switch( (child = fork()) )
+  if( ipc_exec_pending == 0 )
   {
-  case 0: // child
-    setsid();
-
-    if( geteuid() == 0 && ipc_exec_drop_privileges() != 0 )
-    {
-      log_error("can't drop privileges\n");
-      _exit(1);
-    }
-    switch( fork() )
-    {
-    case 0: // grandchild
-      chdir("/");
-      umask(0);
-
-      for( int fd = 0, fdmax = sysconf(_SC_OPEN_MAX); fd < fdmax; ++fd )
-      {
-        close(fd);
-      }
-      open("/dev/null", O_RDONLY);
-      open("/dev/null", O_WRONLY);
-      open("/dev/null", O_WRONLY);
-
-      if( geteuid() > 0 && getuid() > 0 )
-      {
-        execvp(*argv, argv);
-      }
-      _exit(1);
-
-    case -1: // child @ failure
-      _exit(1);
-    }
-    _exit(0); // child @ success
-
-  case -1: // parent @ error
-    log_error("FORK: %s: %s\n", cmd, strerror(errno));
-    break;
-
-  default: // parent @ success
-    waitpid(child, &status, 0);
-    if( WIFEXITED(status) && !WEXITSTATUS(status) )
-    {
-      err = 0;
-    }
-    break;
+    ipc_exec_pending = g_queue_new();
   }
 
+  g_queue_push_tail(ipc_exec_pending, argv), argv = 0;
+  ipc_exec_dispatch();
+  err = 0;
+
   cleanup:
 
   if( error != 0 )
@@ -257,5 +478,11 @@ ipc_exec_init(void)
 int
 ipc_exec_quit(void)
 {
+  if( ipc_exec_pending != 0 )
+  {
+    g_queue_foreach(ipc_exec_pending, (GFunc)g_strfreev, 0);
+    g_queue_free(ipc_exec_pending);
+    ipc_exec_pending = 0;
+  }
   return 0;
 }
@@ -31,9 +31,13 @@ extern "C" {
 } /* fool JED indentation ... */
 #endif
 
-int ipc_exec_run_command(const char *cmd);
-int ipc_exec_init       (void);
-int ipc_exec_quit       (void);
+/** Default max number of simultaneously starting exec actions */
+enum { IPC_EXEC_LIMIT_DEFAULT = 4 };
+
+int  ipc_exec_run_command(const char *cmd);
+void ipc_exec_set_limit  (int limit);
+int  ipc_exec_init       (void);
+int  ipc_exec_quit       (void);
 
 #ifdef __cplusplus
 };
@@ -31,9 +31,7 @@
 
 #include "systemui_dbus.h"
 
-#ifdef DEAD_CODE
-# include <stdlib.h>
-#endif
+#include <stdlib.h>
 
 static void (*systemui_ack_callback)(dbus_int32_t *vec, int cnt) = 0;
 
@@ -73,105 +71,9 @@ systemui_service_name(void)
   return SYSTEMUI_SERVICE;
 }
 
-#if 0 // NEW SYSTEMUI API - disabled for now
-/* ------------------------------------------------------------------------- *
- * systemui_ack_cb
- * ------------------------------------------------------------------------- */
-
-static void
-systemui_ack_cb(DBusPendingCall *pending, void *user_data)
-{
-  DBusMessage *rsp = dbus_pending_call_steal_reply(pending);
-
-  if( rsp != 0 )
-  {
-    DBusError     err = DBUS_ERROR_INIT;
-    dbus_int32_t *vec = 0;
-    int           cnt = 0;
-
-    switch( dbus_message_get_type(rsp) )
-    {
-    case DBUS_MESSAGE_TYPE_METHOD_RETURN:
-      if( dbus_message_get_args(rsp, &err,
-                                DBUS_TYPE_ARRAY,
-                                DBUS_TYPE_INT32, &vec, &cnt,
-                                DBUS_TYPE_INVALID) )
-      {
-        if( systemui_ack_callback != 0 )
-        {
-          systemui_ack_callback(vec, cnt);
-        }
-      }
-      if( dbus_error_is_set(&err) )
-      {
-        log_error_F("%s: %s\n", err.name, err.message);
-      }
-      break;
-
-    case DBUS_MESSAGE_TYPE_ERROR:
-      // TODO: handle system ui not up
-      break;
-    }
-
-    dbus_error_free(&err);
-    dbus_message_unref(rsp);
-  }
-}
-
-/* ------------------------------------------------------------------------- *
- * ipc_systemui_add_dialog
- * ------------------------------------------------------------------------- */
-
-int
-ipc_systemui_add_dialog(DBusConnection *conn, const cookie_t *cookie, int count)
-{
-  return dbusif_method_call_async(conn,
-                                  systemui_ack_cb, 0, 0,
-                                  systemui_service_name(),
-                                  SYSTEMUI_REQUEST_PATH,
-                                  SYSTEMUI_REQUEST_IF,
-                                  SYSTEMUI_ALARM_ADD,
-                                  DBUS_TYPE_ARRAY,
-                                  DBUS_TYPE_INT32, &cookie, count,
-                                  DBUS_TYPE_INVALID);
-}
-
-/* ------------------------------------------------------------------------- *
- * ipc_systemui_cancel_dialog
- * ------------------------------------------------------------------------- */
-
-int
-ipc_systemui_cancel_dialog(DBusConnection *conn, const cookie_t *cookie, int count)
-{
-  return dbusif_method_call_async(conn,
-                                  systemui_ack_cb, 0, 0,
-                                  systemui_service_name(),
-                                  SYSTEMUI_REQUEST_PATH,
-                                  SYSTEMUI_REQUEST_IF,
-                                  SYSTEMUI_ALARM_DEL,
-                                  DBUS_TYPE_ARRAY,
-                                  DBUS_TYPE_INT32, &cookie, count,
-                                  DBUS_TYPE_INVALID);
-}
-
-/* ------------------------------------------------------------------------- *
- * ipc_systemui_query_dialog
- * ------------------------------------------------------------------------- */
-
-#ifdef DEAD_CODE
-int
-ipc_systemui_query_dialog(DBusConnection *conn)
-{
-  return dbusif_method_call_async(conn,
-                                  systemui_ack_cb, 0, 0,
-                                  systemui_service_name(),
-                                  SYSTEMUI_REQUEST_PATH,
-                                  SYSTEMUI_REQUEST_IF,
-                                  SYSTEMUI_ALARM_QUERY,
-                                  DBUS_TYPE_INVALID);
-}
-#endif
-#else // OLD SYSTEMUI API - back in use for now
+/* ========================================================================= *
+ * PER-COOKIE REQUESTS
+ * ========================================================================= */
 
 /* ------------------------------------------------------------------------- *
  * systemui_ack_open  --  async response callback
@@ -311,11 +213,12 @@ systemui_close_dialog(DBusConnection *conn, cookie_t cookie)
 }
 
 /* ------------------------------------------------------------------------- *
- * ipc_systemui_add_dialog  --  wrapper -> old style request
+ * systemui_open_dialogs  --  old style open requests for all cookies
  * ------------------------------------------------------------------------- */
 
-int
-ipc_systemui_add_dialog(DBusConnection *conn, const cookie_t *cookie, int count)
+static
+void
+systemui_open_dialogs(DBusConnection *conn, const cookie_t *cookie, int count)
 {
   for( int i = 0; i < count; ++i )
   {
@@ -326,15 +229,15 @@ ipc_systemui_add_dialog(DBusConnection *conn, const cookie_t *cookie, int count)
     }
     systemui_open_dialog(conn, c);
   }
-  return 0;
 }
 
 /* ------------------------------------------------------------------------- *
- * ipc_systemui_cancel_dialog  --  wrapper -> old style request
+ * systemui_close_dialogs  --  old style close requests for all cookies
  * ------------------------------------------------------------------------- */
 
-int
-ipc_systemui_cancel_dialog(DBusConnection *conn, const cookie_t *cookie, int count)
+static
+void
+systemui_close_dialogs(DBusConnection *conn, const cookie_t *cookie, int count)
 {
   for( int i = 0; i < count; ++i )
   {
@@ -345,6 +248,229 @@ ipc_systemui_cancel_dialog(DBusConnection *conn, const cookie_t *cookie, int cou
     }
     systemui_close_dialog(conn, c);
   }
+}
+
+/* ========================================================================= *
+ * BATCH REQUESTS
+ * ========================================================================= */
+
+/* With ALARMD_SYSTEMUI_BATCH enabled, dialog requests are sent as
+ * one array method call and the reply acknowledges all of the
+ * cookies at once. If the batch request fails for any reason, it
+ * is resent using the old per-cookie requests. If the systemui
+ * plugin does not implement the array methods, batching is not
+ * attempted again until ipc_systemui_reset_protocol() is called. */
+
+static int systemui_batch_supported = ALARMD_SYSTEMUI_BATCH;
+
+/* ------------------------------------------------------------------------- *
+ * systemui_batch_t  --  batch request state for async response callback
+ * ------------------------------------------------------------------------- */
+
+typedef struct
+{
+  DBusConnection *sb_conn;    // for falling back to old style requests
+  int             sb_open;    // 1 = open request, 0 = close request
+  int             sb_count;
+  cookie_t        sb_cookie[];
+
+} systemui_batch_t;
+
+/* ------------------------------------------------------------------------- *
+ * systemui_batch_create
+ * ------------------------------------------------------------------------- */
+
+static
+systemui_batch_t *
+systemui_batch_create(DBusConnection *conn, int open,
+                      const cookie_t *cookie, int count)
+{
+  systemui_batch_t *self = malloc(sizeof *self + count * sizeof *cookie);
+
+  self->sb_conn  = dbus_connection_ref(conn);
+  self->sb_open  = open;
+  self->sb_count = count;
+
+  for( int i = 0; i < count; ++i )
+  {
+    self->sb_cookie[i] = cookie[i];
+  }
+  return self;
+}
+
+/* ------------------------------------------------------------------------- *
+ * systemui_batch_delete
+ * ------------------------------------------------------------------------- */
+
+static
+void
+systemui_batch_delete(void *self)
+{
+  systemui_batch_t *batch = self;
+
+  if( batch != 0 )
+  {
+    dbus_connection_unref(batch->sb_conn);
+    free(batch);
+  }
+}
+
+/* ------------------------------------------------------------------------- *
+ * systemui_batch_fallback  --  resend batch using old style requests
+ * ------------------------------------------------------------------------- */
+
+static
+void
+systemui_batch_fallback(systemui_batch_t *batch, int unsupported)
+{
+  if( unsupported && systemui_batch_supported )
+  {
+    log_info("systemui does not support batch requests"
+             " - using per-cookie requests\n");
+    systemui_batch_supported = 0;
+  }
+
+  if( batch->sb_open )
+  {
+    systemui_open_dialogs(batch->sb_conn, batch->sb_cookie, batch->sb_count);
+  }
+  else
+  {
+    systemui_close_dialogs(batch->sb_conn, batch->sb_cookie, batch->sb_count);
+  }
+}
+
+/* ------------------------------------------------------------------------- *
+ * systemui_batch_ack  --  async response callback
+ * ------------------------------------------------------------------------- */
+
+static void
+systemui_batch_ack(DBusPendingCall *pending, void *user_data)
+{
+  systemui_batch_t *batch = user_data;
+  int               acked = 0;
+
+  DBusMessage *rsp = dbus_pending_call_steal_reply(pending);
+  if( rsp != 0 )
+  {
+    DBusError     err = DBUS_ERROR_INIT;
+    dbus_int32_t *vec = 0;
+    int           cnt = 0;
+
+    switch( dbus_message_get_type(rsp) )
+    {
+    case DBUS_MESSAGE_TYPE_METHOD_RETURN:
+      if( dbus_message_get_args(rsp, &err,
+                                DBUS_TYPE_ARRAY,
+                                DBUS_TYPE_INT32, &vec, &cnt,
+                                DBUS_TYPE_INVALID) )
+      {
+        log_debug_F("%s: %d/%d -> ACK\n", batch->sb_open ? "open" : "close",
+                    cnt, batch->sb_count);
+
+        if( batch->sb_open && systemui_ack_callback != 0 )
+        {
+          systemui_ack_callback(vec, cnt);
+        }
+        acked = 1;
+      }
+      if( dbus_error_is_set(&err) )
+      {
+        log_error_F("%s: %s\n", err.name, err.message);
+      }
+      break;
+
+    case DBUS_MESSAGE_TYPE_ERROR:
+      log_debug_F("%s\n", dbus_message_get_error_name(rsp));
+      break;
+    }
+
+    /* - - - - - - - - - - - - - - - - - - - *
+     * error or unexpected reply: use the old
+     * style requests for this batch, and for
+     * the rest too if the methods are missing
+     * - - - - - - - - - - - - - - - - - - - */
+
+    if( !acked )
+    {
+      systemui_batch_fallback(batch,
+                              dbus_message_is_error(rsp, DBUS_ERROR_UNKNOWN_METHOD));
+    }
+
+    dbus_error_free(&err);
+    dbus_message_unref(rsp);
+  }
+}
+
+/* ------------------------------------------------------------------------- *
+ * systemui_batch_send  --  new style array request
+ * ------------------------------------------------------------------------- */
+
+static
+int
+systemui_batch_send(DBusConnection *conn, int open,
+                    const cookie_t *cookie, int count)
+{
+  int               res   = -1;
+  dbus_int32_t     *vec   = calloc(count, sizeof *vec);
+  systemui_batch_t *batch = systemui_batch_create(conn, open, cookie, count);
+
+  for( int i = 0; i < count; ++i )
+  {
+    vec[i] = cookie[i];
+  }
+
+  res = dbusif_method_call_async(conn,
+                                 systemui_batch_ack, batch,
+                                 systemui_batch_delete,
+                                 systemui_service_name(),
+                                 SYSTEMUI_REQUEST_PATH,
+                                 SYSTEMUI_REQUEST_IF,
+                                 open ? SYSTEMUI_ALARM_ADD : SYSTEMUI_ALARM_DEL,
+                                 DBUS_TYPE_ARRAY,
+                                 DBUS_TYPE_INT32, &vec, count,
+                                 DBUS_TYPE_INVALID);
+  free(vec);
+  return res;
+}
+
+/* ------------------------------------------------------------------------- *
+ * ipc_systemui_reset_protocol  --  retry batch requests with next call
+ * ------------------------------------------------------------------------- */
+
+void
+ipc_systemui_reset_protocol(void)
+{
+  systemui_batch_supported = ALARMD_SYSTEMUI_BATCH;
+}
+
+/* ------------------------------------------------------------------------- *
+ * ipc_systemui_add_dialog
+ * ------------------------------------------------------------------------- */
+
+int
+ipc_systemui_add_dialog(DBusConnection *conn, const cookie_t *cookie, int count)
+{
+  if( systemui_batch_supported )
+  {
+    return systemui_batch_send(conn, 1, cookie, count);
+  }
+  systemui_open_dialogs(conn, cookie, count);
+  return 0;
+}
+
+/* ------------------------------------------------------------------------- *
+ * ipc_systemui_cancel_dialog
+ * ------------------------------------------------------------------------- */
+
+int
+ipc_systemui_cancel_dialog(DBusConnection *conn, const cookie_t *cookie, int count)
+{
+  if( systemui_batch_supported )
+  {
+    return systemui_batch_send(conn, 0, cookie, count);
+  }
+  systemui_close_dialogs(conn, cookie, count);
   return 0;
 }
 
@@ -360,5 +486,3 @@ ipc_systemui_query_dialog(DBusConnection *conn)
   return 0;
 }
 #endif
-
-#endif
@@ -36,6 +36,7 @@ extern "C" {
 
 void ipc_systemui_set_ack_callback    (void (*fn)(dbus_int32_t *, int));
 void ipc_systemui_set_service_callback(const char *(*fn)(void));
+void ipc_systemui_reset_protocol      (void);
 
 int  ipc_systemui_add_dialog          (DBusConnection *conn, const cookie_t *cookie, int count);
 int  ipc_systemui_cancel_dialog       (DBusConnection *conn, const cookie_t *cookie, int count);
@@ -181,6 +181,52 @@ int alarmd_event_del_decode_rsp (DBusMessage *rsp);
 
 /*@}*/
 
+/** @name Helpers for ALARMD_EVENTS_ADD
+ */
+
+/*@{*/
+
+/** \brief construct batched add method call message
+ *
+ *  @since 1.1.17
+ *
+ *  See #alarmd_event_add_many() for details.
+ */
+DBusMessage *alarmd_event_add_many_encode_req (const alarm_event_t * const *events, int count);
+
+/** \brief parse batched add method reply message
+ *
+ *  @since 1.1.17
+ *
+ *  See #alarmd_event_add_many() for details.
+ */
+int alarmd_event_add_many_decode_rsp (DBusMessage *rsp, cookie_t *cookies, int count);
+
+/*@}*/
+
+/** @name Helpers for ALARMD_EVENTS_DEL
+ */
+
+/*@{*/
+
+/** \brief construct batched del method call message
+ *
+ *  @since 1.1.17
+ *
+ *  See #alarmd_event_del_many() for details.
+ */
+DBusMessage *alarmd_event_del_many_encode_req (const cookie_t *cookies, int count);
+
+/** \brief parse batched del method reply message
+ *
+ *  @since 1.1.17
+ *
+ *  See #alarmd_event_del_many() for details.
+ */
+int alarmd_event_del_many_decode_rsp (DBusMessage *rsp, int *deleted, int count);
+
+/*@}*/
+
 /** @name Helpers for ALARMD_EVENT_QUERY
  */
 
@@ -204,6 +250,58 @@ cookie_t *alarmd_event_query_decode_rsp (DBusMessage *rsp);
 
 /*@}*/
 
+/** @name Helpers for ALARMD_EVENT_QUERY_FULL
+ */
+
+/*@{*/
+
+/** \brief construct full query method call message
+ *
+ *  @since 1.1.17
+ *
+ *  See #alarmd_event_query_full() for details.
+ */
+DBusMessage *alarmd_event_query_full_encode_req (const time_t first, const time_t last, int32_t flag_mask, int32_t flags, const char *appid, unsigned fields);
+
+/** \brief parse full query method reply message
+ *
+ *  @since 1.1.17
+ *
+ *  See #alarmd_event_query_full() for details.
+ */
+alarm_event_t **alarmd_event_query_full_decode_rsp (DBusMessage *rsp);
+
+/*@}*/
+
+/** @name Helpers for ALARMD_EVENT_QUERY_PAGE
+ */
+
+/*@{*/
+
+/** \brief construct paged query method call message
+ *
+ *  @since 1.1.17
+ *
+ *  The cursor is an opaque token from the previous reply,
+ *  or NULL / empty string to get the first page.
+ *
+ *  See #alarmd_event_query_open() for details.
+ */
+DBusMessage *alarmd_event_query_page_encode_req (const time_t first, const time_t last, int32_t flag_mask, int32_t flags, const char *appid, unsigned limit, const char *cursor);
+
+/** \brief parse paged query method reply message
+ *
+ *  @since 1.1.17
+ *
+ *  The continuation token is stored to *pcursor, replacing the
+ *  previous value. An empty token means there are no more pages.
+ *
+ *  See #alarmd_event_query_open() for details.
+ */
+cookie_t *alarmd_event_query_page_decode_rsp (DBusMessage *rsp, char **pcursor);
+
+/*@}*/
+
 /** @name Helpers for ALARMD_SNOOZE_GET
  */
 
@@ -319,6 +417,111 @@ int alarmd_set_debug_decode_rsp (DBusMessage *rsp);
 
 /*@}*/
 
+/** @name Persistent connection to alarmd
+ *
+ * Normal libalarm functions get the bus connection for each method
+ * call; with private bus connections configured this means new socket,
+ * authentication and Hello handshake per call.
+ *
+ * Applications making lots of calls in a row (e.g. calendar sync
+ * adding hundreds of events) can open a session that keeps one
+ * connection open, and pipeline the method calls: send any number of
+ * requests with alarmd_session_send() and then collect the replies,
+ * in the same order, with alarmd_session_recv().
+ *
+ * Example:
+ * <pre>
+ * alarmd_session_t *ses = alarmd_session_open();
+ * for( int i = 0; i < count; ++i )
+ *   alarmd_session_event_add_send(ses, events[i]);
+ * for( int i = 0; i < count; ++i )
+ *   cookies[i] = alarmd_session_event_add_recv(ses);
+ * alarmd_session_close(ses);
+ * </pre>
+ */
+
+/*@{*/
+
+/** \brief opaque session handle */
+typedef struct alarmd_session_t alarmd_session_t;
+
+/** \brief open connection to alarmd
+ *
+ *  @since 1.1.17
+ *
+ *  @return session handle, or NULL on failure
+ */
+alarmd_session_t *alarmd_session_open (void);
+
+/** \brief close connection, pending replies are discarded
+ *
+ *  @since 1.1.17
+ */
+void alarmd_session_close (alarmd_session_t *self);
+
+/** \brief number of method calls waiting for alarmd_session_recv()
+ *
+ *  @since 1.1.17
+ */
+int alarmd_session_pending (const alarmd_session_t *self);
+
+/** \brief send method call made with one of the encode_req helpers
+ *
+ *  @since 1.1.17
+ *
+ *  The message can be released after the call.
+ *
+ *  @return 0 on success, or -1 on failure
+ */
+int alarmd_session_send (alarmd_session_t *self, DBusMessage *msg);
+
+/** \brief wait for reply to the oldest pending method call
+ *
+ *  @since 1.1.17
+ *
+ *  The reply can be parsed with the matching decode_rsp helper
+ *  and must be released by the caller.
+ *
+ *  @return reply or error message, or NULL on failure
+ */
+DBusMessage *alarmd_session_recv (alarmd_session_t *self);
+
+/** \brief send method call and wait for reply
+ *
+ *  @since 1.1.17
+ *
+ *  Replies to pipelined method calls sent earlier are not affected.
+ */
+DBusMessage *alarmd_session_call (alarmd_session_t *self, DBusMessage *msg);
+
+/** \brief #alarmd_event_add() using session connection
+ *
+ *  @since 1.1.17
+ */
+cookie_t alarmd_session_event_add (alarmd_session_t *self, const alarm_event_t *event);
+
+/** \brief send #alarmd_event_add() request without waiting for reply
+ *
+ *  @since 1.1.17
+ */
+int alarmd_session_event_add_send (alarmd_session_t *self, const alarm_event_t *event);
+
+/** \brief cookie from reply to the oldest pending add request
+ *
+ *  @since 1.1.17
+ *
+ *  @return cookie, or 0 on failure
+ */
+cookie_t alarmd_session_event_add_recv (alarmd_session_t *self);
+
+/** \brief #alarmd_event_del() using session connection
+ *
+ *  @since 1.1.17
+ */
+int alarmd_session_event_del (alarmd_session_t *self, cookie_t cookie);
+
+/*@}*/
+
 #pragma GCC visibility pop
 
 #ifdef __cplusplus
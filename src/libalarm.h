@@ -1166,6 +1166,54 @@ typedef enum alarmeventflags
 
 } alarmeventflags;
 
+/** @brief Event field groups for alarmd_event_query_full()
+ *
+ * Cookie, trigger time, flags, application id and the other
+ * fixed size fields are always included. Omitted groups are
+ * left empty in the returned events.
+ **/
+
+typedef enum alarmqueryfields
+{
+  /** Title, message, sound and icon strings.
+   **/
+  ALARM_QUERY_TEXT             = 1 << 0,
+
+  /** Action table.
+   **/
+  ALARM_QUERY_ACTIONS          = 1 << 1,
+
+  /** Recurrence table.
+   **/
+  ALARM_QUERY_RECURRENCES      = 1 << 2,
+
+  /** Custom attributes.
+   **/
+  ALARM_QUERY_ATTRS            = 1 << 3,
+
+  /** Everything, same content as alarmd_event_get() returns.
+   **/
+  ALARM_QUERY_ALL              = (ALARM_QUERY_TEXT |
+                                  ALARM_QUERY_ACTIONS |
+                                  ALARM_QUERY_RECURRENCES |
+                                  ALARM_QUERY_ATTRS),
+
+} alarmqueryfields;
+
+/** \brief Default page size for alarmd_event_query_open()
+ *
+ * @since 1.1.17
+ */
+#define ALARM_QUERY_CHUNK_DEFAULT 256
+
+/** \brief Opaque state of a paged alarm query
+ *
+ * See alarmd_event_query_open().
+ *
+ * @since 1.1.17
+ */
+typedef struct alarm_query_t alarm_query_t;
+
 /** \brief Calculate value for alarm_event::recur_secs specified in seconds */
 #define ALARM_RECURRING_SECONDS(n) (n)
 /** \brief Calculate value for alarm_event::recur_secs specified in minutes */
@@ -2016,6 +2064,44 @@ cookie_t alarmd_event_add_with_dbus_params(const alarm_event_t *event,
  **/
 int alarmd_event_del(cookie_t cookie);
 
+/** \brief Adds several events to the alarm queue.
+ *
+ * Sends all events to alarmd in one dbus transaction. The
+ * queue is re-evaluated and saved once for the whole batch,
+ * which makes this considerably cheaper than calling
+ * alarmd_event_add() in a loop.
+ *
+ * Each event is handled as with alarmd_event_add(); an
+ * event that is rejected by alarmd gets zero cookie. If
+ * any of the events fails local sanity checks, nothing
+ * is sent.
+ *
+ * @param events  : array of alarm_event_t pointers
+ * @param count   : number of events in the array
+ * @param cookies : array for count cookies, or NULL
+ *
+ * @returns count : number of events added, or -1 = error
+ *
+ * @since 1.1.17
+ **/
+int alarmd_event_add_many(const alarm_event_t * const *events, int count,
+                          cookie_t *cookies);
+
+/** \brief Deletes several alarms from the alarm queue.
+ *
+ * As alarmd_event_del(), but uses only one dbus transaction
+ * and queue re-evaluation for all the cookies.
+ *
+ * @param cookies : array of unique alarm event identifiers
+ * @param count   : number of cookies in the array
+ * @param deleted : array for count 1/0 deleted flags, or NULL
+ *
+ * @returns count : number of events deleted, or -1 = error
+ *
+ * @since 1.1.17
+ **/
+int alarmd_event_del_many(const cookie_t *cookies, int count, int *deleted);
+
 /** \brief Updates an event already in the alarm queue.
  *
  * Uses only one dbus transaction, acts bit like doing:
@@ -2068,6 +2154,98 @@ cookie_t *alarmd_event_query(const time_t first, const time_t last,
                              int32_t flag_mask, int32_t flags,
                              const char *appid);
 
+/** \brief Queries alarms and fetches their details in one go.
+ *
+ * Like alarmd_event_query(), but instead of cookies returns
+ * the matching events themselves, as alarmd_event_get() would.
+ * Only one dbus transaction is needed regardless of the
+ * number of alarms.
+ *
+ * The fields parameter selects which parts of the events are
+ * transferred, see #alarmqueryfields. For example listing
+ * titles and trigger times needs only ALARM_QUERY_TEXT.
+ *
+ * Returns NULL terminated array of events. Use
+ * alarm_event_delete() for each event and free() for the
+ * array to release the memory.
+ *
+ * @param first      : start of time span (inclusive)
+ * @param last       : end of time span (inclusive)
+ * @param flag_mask  : Mask describing which flags you're interested in.
+ *                     Pass 0 to get all events.
+ * @param flags      : Values for the flags you're querying.
+ * @param appid      : Name of application, or NULL for all
+ * @param fields     : bitmask of #alarmqueryfields
+ *
+ * @returns events   : NULL terminated array of events, or NULL on error
+ *
+ * @since 1.1.17
+ **/
+alarm_event_t **alarmd_event_query_full(const time_t first, const time_t last,
+                                        int32_t flag_mask, int32_t flags,
+                                        const char *appid, unsigned fields);
+
+/** \brief Starts a query that fetches alarm cookies in chunks.
+ *
+ * Matches alarms like alarmd_event_query(), but the results
+ * are fetched from alarmd at most chunk cookies at a time
+ * with alarmd_event_query_next(), so that a large queue does
+ * not need to be transferred in one message.
+ *
+ * Example:
+ * <pre>
+ * alarm_query_t *qry = alarmd_event_query_open(0,0, 0,0, appid, 0);
+ * cookie_t      *vec;
+ * while( (vec = alarmd_event_query_next(qry)) )
+ * {
+ *   for( int i = 0; vec[i]; ++i ) ... ;
+ *   free(vec);
+ * }
+ * alarmd_event_query_close(qry);
+ * </pre>
+ *
+ * Alarms whose trigger time changes while the query is in
+ * progress might be skipped or reported twice.
+ *
+ * @param first      : start of time span (inclusive)
+ * @param last       : end of time span (inclusive)
+ * @param flag_mask  : Mask describing which flags you're interested in.
+ *                     Pass 0 to get all events.
+ * @param flags      : Values for the flags you're querying.
+ * @param appid      : Name of application, or NULL for all
+ * @param chunk      : Maximum number of cookies per chunk, or 0 for
+ *                     #ALARM_QUERY_CHUNK_DEFAULT
+ *
+ * @returns query    : query state, release with alarmd_event_query_close()
+ *
+ * @since 1.1.17
+ **/
+alarm_query_t *alarmd_event_query_open(const time_t first, const time_t last,
+                                       int32_t flag_mask, int32_t flags,
+                                       const char *appid, unsigned chunk);
+
+/** \brief Fetches next chunk of alarm cookies.
+ *
+ * Returns zero terminated array of at most chunk cookies in
+ * trigger time order. Use free() to release the returned array.
+ *
+ * @param query      : query state from alarmd_event_query_open()
+ *
+ * @returns cookies  : zero terminated array of cookies, or NULL
+ *                     when there are no more alarms or on error
+ *
+ * @since 1.1.17
+ **/
+cookie_t *alarmd_event_query_next(alarm_query_t *query);
+
+/** \brief Releases paged query state.
+ *
+ * @param query      : query state from alarmd_event_query_open()
+ *
+ * @since 1.1.17
+ **/
+void alarmd_event_query_close(alarm_query_t *query);
+
 /** \brief Fetches alarm defails.
  *
  * Finds an alarm with given identifier and returns alarm_event_t struct
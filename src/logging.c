@@ -38,6 +38,11 @@
 #include <unistd.h>
 #include <fcntl.h>
 #include <time.h>
+#include <sys/time.h>
+#include <sys/types.h>
+#include <stdint.h>
+#include <stddef.h>
+#include <errno.h>
 
 #define numof(a) (sizeof(a)/sizeof*(a))
 
@@ -49,6 +54,7 @@ typedef struct log_driver_t
   void      (*open)(void);
   void      (*close)(void);
   void      (*write)(int, const char *, va_list);
+  void      (*flush)(void);
 } log_driver_t;
 
 /* ========================================================================= *
@@ -62,6 +68,23 @@ static int         log_pid      = 0;
 
 static int         log_level    = LOG_WARNING;
 
+static const char *
+log_priority_name(int priority)
+{
+  switch( priority )
+  {
+  case LOG_EMERG:   return "Emergency";
+  case LOG_ALERT:   return "Alert";
+  case LOG_CRIT:    return "Critical";
+  case LOG_ERR:     return "Error";
+  case LOG_WARNING: return "Warning";
+  case LOG_NOTICE:  return "Notice";
+  case LOG_INFO:    return "Info";
+  case LOG_DEBUG:   return "Debug";
+  }
+  return "Unknown";
+}
+
 static void
 dummy_open(void)
 {
@@ -123,22 +146,10 @@ stream_close(void)
 static void
 stream_write(int priority, const char *fmt, va_list va)
 {
-  const char *desc = "Unknown";
+  const char *desc = log_priority_name(priority);
   FILE       *file = log_output ?: stderr;
   char       *mesg = 0;
 
-  switch( priority )
-  {
-  case LOG_EMERG:   desc = "Emergency";break;
-  case LOG_ALERT:   desc = "Alert";    break;
-  case LOG_CRIT:    desc = "Critical"; break;
-  case LOG_ERR:     desc = "Error";    break;
-  case LOG_WARNING: desc = "Warning";  break;
-  case LOG_NOTICE:  desc = "Notice";   break;
-  case LOG_INFO:    desc = "Info";     break;
-  case LOG_DEBUG:   desc = "Debug";    break;
-  }
-
   vasprintf(&mesg, fmt, va);
   if( mesg != 0 )
   {
@@ -153,6 +164,577 @@ stream_write(int priority, const char *fmt, va_list va)
 // QUARANTINE   fflush(file);
 }
 
+/* ========================================================================= *
+ * RING BUFFER
+ *
+ * Messages are not formatted when logged. The priority, time stamp,
+ * format string and arguments are stored in binary form to a fixed
+ * size in-memory ring buffer, overwriting the oldest records when
+ * the buffer gets full. Formatting is done only when the buffer is
+ * flushed to <cachedir>/<ident>.log, which happens on log_flush(),
+ * when the driver is closed and after critical messages.
+ *
+ * The log file lives in the daemon owned cache directory and is
+ * opened without following symlinks, so that other users can not
+ * redirect the output to some other file.
+ *
+ * Format strings are stored by reference and must be string
+ * literals - which they are throughout alarmd.
+ * ========================================================================= */
+
+enum
+{
+  /** Size of the ring buffer in bytes */
+  LOG_RING_SIZE    = 256 << 10,
+
+  /** Max bytes stored from a single %s argument */
+  LOG_RING_STR_MAX = 255,
+
+  /** Max size of a single record */
+  LOG_RING_REC_MAX = 4 << 10,
+};
+
+typedef struct log_ring_rec_t
+{
+  uint32_t        size;  // header + argument bytes
+  int32_t         pri;
+  struct timeval  tv;
+  const char     *fmt;
+} log_ring_rec_t;
+
+typedef struct log_ring_spec_t
+{
+  int stars;  // number of '*' width / precision arguments
+  int prec;   // precision, -1 = none, -2 = from argument
+  int len;    // length modifier, 'H' = hh, 'q' = ll
+  int conv;   // conversion character
+} log_ring_spec_t;
+
+static char     *log_ring_data = 0;
+static size_t    log_ring_head = 0; // offset of the oldest record
+static size_t    log_ring_used = 0; // bytes in use
+static unsigned  log_ring_lost = 0; // records overwritten since flush
+
+/* ------------------------------------------------------------------------- *
+ * log_ring_get  --  copy data out from ring, handling wrap around
+ * ------------------------------------------------------------------------- */
+
+static void
+log_ring_get(size_t pos, void *data, size_t size)
+{
+  size_t n;
+
+  pos %= LOG_RING_SIZE;
+  n = LOG_RING_SIZE - pos;
+  if( n > size ) n = size;
+
+  memcpy(data, log_ring_data + pos, n);
+  memcpy((char *)data + n, log_ring_data, size - n);
+}
+
+/* ------------------------------------------------------------------------- *
+ * log_ring_put  --  copy data in to ring, handling wrap around
+ * ------------------------------------------------------------------------- */
+
+static void
+log_ring_put(size_t pos, const void *data, size_t size)
+{
+  size_t n;
+
+  pos %= LOG_RING_SIZE;
+  n = LOG_RING_SIZE - pos;
+  if( n > size ) n = size;
+
+  memcpy(log_ring_data + pos, data, n);
+  memcpy(log_ring_data, (const char *)data + n, size - n);
+}
+
+/* ------------------------------------------------------------------------- *
+ * log_ring_parse_spec  --  scan printf conversion specification
+ * ------------------------------------------------------------------------- */
+
+static const char *
+log_ring_parse_spec(const char *fmt, log_ring_spec_t *spec)
+{
+  // fmt points to the character following '%'
+
+  spec->stars = spec->len = spec->conv = 0;
+  spec->prec  = -1;
+
+  fmt += strspn(fmt, "-+ #0'I");
+
+  if( *fmt == '*' )
+    ++spec->stars, ++fmt;
+  else
+    fmt += strspn(fmt, "0123456789");
+
+  if( *fmt == '.' )
+  {
+    if( *++fmt == '*' )
+      ++spec->stars, ++fmt, spec->prec = -2;
+    else
+      spec->prec = strtol(fmt, (char **)&fmt, 10);
+  }
+
+  switch( *fmt )
+  {
+  case 'h':
+    spec->len = (*++fmt == 'h') ? (++fmt, 'H') : 'h';
+    break;
+  case 'l':
+    spec->len = (*++fmt == 'l') ? (++fmt, 'q') : 'l';
+    break;
+  case 'q': case 'L': case 'j': case 'z': case 't':
+    spec->len = *fmt++;
+    break;
+  }
+
+  if( *fmt != 0 )
+  {
+    spec->conv = *fmt++;
+  }
+  return fmt;
+}
+
+/* ------------------------------------------------------------------------- *
+ * log_ring_record  --  serialize message arguments to a record
+ * ------------------------------------------------------------------------- */
+
+static size_t
+log_ring_record(char *rec, int pri, const char *fmt, va_list va)
+{
+  log_ring_rec_t   hdr;
+  size_t           pos = sizeof hdr;
+  log_ring_spec_t  spec;
+
+  auto int put(const void *data, size_t size);
+  auto int put_int(long long v);
+
+  auto int put(const void *data, size_t size)
+  {
+    if( pos + size > LOG_RING_REC_MAX ) return -1;
+    memcpy(rec + pos, data, size), pos += size;
+    return 0;
+  }
+  auto int put_int(long long v)
+  {
+    return put(&v, sizeof v);
+  }
+
+  hdr.pri = pri;
+  hdr.fmt = fmt;
+  gettimeofday(&hdr.tv, 0);
+
+  for( int err = 0; !err && (fmt = strchr(fmt, '%')); )
+  {
+    fmt = log_ring_parse_spec(fmt + 1, &spec);
+
+    for( int i = 0; i < spec.stars; ++i )
+    {
+      int v = va_arg(va, int);
+      if( spec.prec == -2 && i == spec.stars - 1 ) spec.prec = v;
+      err |= put_int(v);
+    }
+
+    switch( spec.conv )
+    {
+    case 'd': case 'i': case 'o': case 'u': case 'x': case 'X': case 'c':
+      switch( spec.len )
+      {
+      case 'l': err |= put_int(va_arg(va, long));      break;
+      case 'q':
+      case 'L': err |= put_int(va_arg(va, long long)); break;
+      case 'j': err |= put_int(va_arg(va, intmax_t));  break;
+      case 'z': err |= put_int(va_arg(va, ssize_t));   break;
+      case 't': err |= put_int(va_arg(va, ptrdiff_t)); break;
+      default:  err |= put_int(va_arg(va, int));       break;
+      }
+      break;
+
+    case 'e': case 'E': case 'f': case 'F':
+    case 'g': case 'G': case 'a': case 'A':
+      {
+        double d = ((spec.len == 'L')
+                    ? (double)va_arg(va, long double)
+                    : va_arg(va, double));
+        err |= put(&d, sizeof d);
+      }
+      break;
+
+    case 'p':
+      {
+        void *p = va_arg(va, void *);
+        err |= put(&p, sizeof p);
+      }
+      break;
+
+    case 's':
+      {
+        const char *s = va_arg(va, const char *);
+        uint16_t    n = 0xffff;
+
+        if( s != 0 )
+        {
+          size_t m = LOG_RING_STR_MAX;
+          if( spec.prec >= 0 && spec.prec < m ) m = spec.prec;
+          n = strnlen(s, m);
+        }
+        err |= put(&n, sizeof n);
+        err |= put(s, (s != 0) ? n : 0);
+      }
+      break;
+
+    case 'm':
+      err |= put_int(errno);
+      break;
+
+    case 'n':
+      va_arg(va, void *);
+      break;
+
+    case '%':
+      break;
+
+    default:
+      // unknown conversion, can't store the rest of args
+      err = -1;
+      break;
+    }
+  }
+
+  // rec is plain bytes, the header is not necessarily aligned
+  hdr.size = pos;
+  memcpy(rec, &hdr, sizeof hdr);
+
+  return pos;
+}
+
+/* ------------------------------------------------------------------------- *
+ * log_ring_format  --  format record to string
+ * ------------------------------------------------------------------------- */
+
+static void
+log_ring_format(const char *rec, size_t size, char *buf, size_t len)
+{
+  log_ring_rec_t        hdr;
+  const char           *fmt = 0;
+  size_t                pos = sizeof hdr;
+  size_t                out = 0;
+  log_ring_spec_t       spec;
+  char                  tmp[32];
+  long long             star[2];
+
+  auto int  get(void *data, size_t size);
+  auto void emit(const char *fmt, ...) __attribute__((format(printf,1,2)));
+
+  auto int get(void *data, size_t cnt)
+  {
+    if( pos + cnt > size ) return -1;
+    memcpy(data, rec + pos, cnt), pos += cnt;
+    return 0;
+  }
+
+  auto void emit(const char *fmt, ...)
+  {
+    va_list va;
+    va_start(va, fmt);
+    if( out < len )
+    {
+      int n = vsnprintf(buf + out, len - out, fmt, va);
+      if( n > 0 ) out += n;
+    }
+    va_end(va);
+  }
+
+  /* - - - - - - - - - - - - - - - - - - - *
+   * Format one conversion at a time; the
+   * original specification is used, with
+   * the '*' arguments passed before value
+   * - - - - - - - - - - - - - - - - - - - */
+
+#define EMIT(V) do {\
+  switch( spec.stars ) {\
+  case 0:  emit(tmp, V); break;\
+  case 1:  emit(tmp, (int)star[0], V); break;\
+  default: emit(tmp, (int)star[0], (int)star[1], V); break;\
+  }\
+} while( 0 )
+
+  *buf = 0;
+
+  memcpy(&hdr, rec, sizeof hdr);
+  fmt = hdr.fmt;
+
+  for( ;; )
+  {
+    const char *beg = strchr(fmt, '%');
+    const char *end = 0;
+
+    if( beg == 0 )
+    {
+      emit("%s", fmt);
+      break;
+    }
+
+    emit("%.*s", (int)(beg - fmt), fmt);
+
+    end = log_ring_parse_spec(beg + 1, &spec);
+
+    if( spec.conv == 0 || end - beg >= (int)sizeof tmp )
+    {
+      emit("%s", beg);
+      break;
+    }
+
+    memcpy(tmp, beg, end - beg), tmp[end - beg] = 0;
+
+    int err = 0;
+
+    for( int i = 0; i < spec.stars; ++i )
+    {
+      err |= get(&star[i], sizeof *star);
+    }
+
+    switch( spec.conv )
+    {
+    case 'd': case 'i': case 'o': case 'u': case 'x': case 'X': case 'c':
+      {
+        long long v = 0;
+        if( (err |= get(&v, sizeof v)) ) break;
+
+        switch( spec.len )
+        {
+        case 'l': EMIT((long)v);      break;
+        case 'q':
+        case 'L': EMIT((long long)v); break;
+        case 'j': EMIT((intmax_t)v);  break;
+        case 'z': EMIT((ssize_t)v);   break;
+        case 't': EMIT((ptrdiff_t)v); break;
+        default:  EMIT((int)v);       break;
+        }
+      }
+      break;
+
+    case 'e': case 'E': case 'f': case 'F':
+    case 'g': case 'G': case 'a': case 'A':
+      {
+        double d = 0;
+        if( (err |= get(&d, sizeof d)) ) break;
+
+        if( spec.len == 'L' )
+          EMIT((long double)d);
+        else
+          EMIT(d);
+      }
+      break;
+
+    case 'p':
+      {
+        void *p = 0;
+        if( (err |= get(&p, sizeof p)) ) break;
+        EMIT(p);
+      }
+      break;
+
+    case 's':
+      {
+        uint16_t n = 0;
+        char     s[LOG_RING_STR_MAX + 1];
+
+        if( (err |= get(&n, sizeof n)) ) break;
+
+        if( n == 0xffff )
+        {
+          EMIT((const char *)0);
+        }
+        else if( !(err |= get(s, n)) )
+        {
+          s[n] = 0;
+          EMIT(s);
+        }
+      }
+      break;
+
+    case 'm':
+      {
+        long long e = 0;
+        if( (err |= get(&e, sizeof e)) ) break;
+        errno = (int)e;
+        emit(tmp);
+      }
+      break;
+
+    case 'n':
+      break;
+
+    case '%':
+      emit("%%");
+      break;
+
+    default:
+      err = -1;
+      break;
+    }
+
+    if( err )
+    {
+      emit("%s", beg);
+      break;
+    }
+    fmt = end;
+  }
+
+#undef EMIT
+}
+
+/* ------------------------------------------------------------------------- *
+ * ring_flush  --  format buffered records to <cachedir>/<ident>.log
+ * ------------------------------------------------------------------------- */
+
+static void
+ring_flush(void)
+{
+  char *path = 0;
+  int   fd   = -1;
+  FILE *file = 0;
+  char  rec[LOG_RING_REC_MAX];
+  char  msg[1024];
+  char  stm[32];
+
+  if( log_ring_data == 0 || (log_ring_used == 0 && log_ring_lost == 0) )
+  {
+    goto cleanup;
+  }
+
+  asprintf(&path, "%s/%s.log", ALARMD_CONFIG_CACHEDIR, log_identity);
+
+  if( path == 0 )
+  {
+    goto cleanup;
+  }
+
+  fd = open(path, O_WRONLY | O_APPEND | O_CREAT | O_NOFOLLOW, 0600);
+  if( fd == -1 || (file = fdopen(fd, "a")) == 0 )
+  {
+    goto cleanup;
+  }
+  fd = -1;
+
+  if( log_ring_lost != 0 )
+  {
+    fprintf(file, "%s[%d]: %s: %u messages lost\n", log_identity,
+            log_pid, log_priority_name(LOG_WARNING), log_ring_lost);
+    log_ring_lost = 0;
+  }
+
+  while( log_ring_used > 0 )
+  {
+    log_ring_rec_t  hdr;
+    struct tm       tm;
+
+    log_ring_get(log_ring_head, &hdr, sizeof hdr);
+    log_ring_get(log_ring_head, rec, hdr.size);
+
+    log_ring_head  = (log_ring_head + hdr.size) % LOG_RING_SIZE;
+    log_ring_used -= hdr.size;
+
+    log_ring_format(rec, hdr.size, msg, sizeof msg);
+    xstripall(msg);
+
+    localtime_r(&hdr.tv.tv_sec, &tm);
+    strftime(stm, sizeof stm, "%Y-%m-%d %H:%M:%S", &tm);
+
+    fprintf(file, "%s.%03ld %s[%d]: %s: %s\n", stm,
+            (long)(hdr.tv.tv_usec / 1000), log_identity, log_pid,
+            log_priority_name(hdr.pri), msg);
+  }
+
+  log_ring_head = 0;
+
+cleanup:
+
+  if( file != 0 )
+  {
+    fclose(file);
+  }
+  if( fd != -1 )
+  {
+    close(fd);
+  }
+  free(path);
+}
+
+/* ------------------------------------------------------------------------- *
+ * ring_open
+ * ------------------------------------------------------------------------- */
+
+static void
+ring_open(void)
+{
+  if( log_ring_data == 0 )
+  {
+    log_ring_data = malloc(LOG_RING_SIZE);
+    log_ring_head = log_ring_used = log_ring_lost = 0;
+  }
+}
+
+/* ------------------------------------------------------------------------- *
+ * ring_close
+ * ------------------------------------------------------------------------- */
+
+static void
+ring_close(void)
+{
+  ring_flush();
+  free(log_ring_data);
+  log_ring_data = 0;
+}
+
+/* ------------------------------------------------------------------------- *
+ * ring_write
+ * ------------------------------------------------------------------------- */
+
+static void
+ring_write(int priority, const char *fmt, va_list va)
+{
+  char   rec[LOG_RING_REC_MAX];
+  size_t size;
+
+  if( log_ring_data == 0 )
+  {
+    return;
+  }
+
+  size = log_ring_record(rec, priority, fmt, va);
+
+  /* - - - - - - - - - - - - - - - - - - - *
+   * make room by dropping oldest records
+   * - - - - - - - - - - - - - - - - - - - */
+
+  while( log_ring_used + size > LOG_RING_SIZE )
+  {
+    log_ring_rec_t hdr;
+
+    log_ring_get(log_ring_head, &hdr, sizeof hdr);
+    log_ring_head  = (log_ring_head + hdr.size) % LOG_RING_SIZE;
+    log_ring_used -= hdr.size;
+    log_ring_lost += 1;
+  }
+
+  log_ring_put(log_ring_head + log_ring_used, rec, size);
+  log_ring_used += size;
+
+  /* - - - - - - - - - - - - - - - - - - - *
+   * make sure what lead to critical
+   * errors gets written out
+   * - - - - - - - - - - - - - - - - - - - */
+
+  if( priority <= LOG_CRIT )
+  {
+    ring_flush();
+  }
+}
+
 static void
 stderr_open(void)
 {
@@ -190,6 +772,13 @@ static log_driver_t log_drivers[] =
     .open  = dummy_open,
     .write = dummy_write,
     .close = dummy_close
+  },
+  {
+    .name  = "ring",
+    .open  = ring_open,
+    .write = ring_write,
+    .close = ring_close,
+    .flush = ring_flush
   }
 };
 
@@ -287,6 +876,15 @@ log_close(void)
   log_driver->close();
 }
 
+void
+log_flush(void)
+{
+  if( log_driver->flush != 0 )
+  {
+    log_driver->flush();
+  }
+}
+
 void
 log_critical(const char *fmt, ...)
 {
@@ -347,6 +945,12 @@ log_set_level(int level)
   log_level = level;
 }
 
+int
+log_is_enabled(int pri)
+{
+  return pri <= log_level;
+}
+
 #endif
 
 typedef struct log_lut_t log_lut_t;
@@ -40,6 +40,7 @@ enum
   LOG_TO_TMP    = 1,
   LOG_TO_SYSLOG = 2,
   LOG_TO_DUMMY  = 3,
+  LOG_TO_RING   = 4,
 };
 
 #if ENABLE_LOGGING
@@ -51,7 +52,9 @@ enum
 void log_open       (const char *ident, int driver, int daemon);
 void log_close      (void);
 void log_reopen     (int driver);
+void log_flush      (void);
 void log_set_level  (int level);
+int  log_is_enabled (int pri);
 
 void log_critical   (const char *fmt, ...) __attribute__((format(printf,1,2)));
 void log_error      (const char *fmt, ...) __attribute__((format(printf,1,2)));
@@ -76,6 +79,22 @@ void log_debug      (const char *fmt, ...) __attribute__((format(printf,1,2)));
 #  define log_info_L(FMT, ARG...)     log_info("%s:%d: "FMT, __FILE__, __LINE__, ## ARG)
 #  define log_debug_L(FMT, ARG...)    log_debug("%s:%d: "FMT, __FILE__, __LINE__, ## ARG)
 
+/* log_enabled() tells whether messages of given priority would be
+ * written, so that expensive formatting of arguments can be skipped.
+ * Priorities compiled out via ENABLE_LOGGING are constant false. */
+#if ENABLE_LOGGING >= 3
+#  define log_enabled(PRI)            log_is_enabled(PRI)
+#elif ENABLE_LOGGING >= 2
+#  define log_enabled(PRI)            ((PRI) <= LOG_INFO && log_is_enabled(PRI))
+#else
+#  define log_enabled(PRI)            ((PRI) <= LOG_NOTICE && log_is_enabled(PRI))
+#endif
+
+/* level gated variants: arguments are evaluated only if the
+ * message is going to be written */
+#  define log_info_G(FMT, ARG...)     do { if( log_enabled(LOG_INFO) ) log_info(FMT, ## ARG); } while (0)
+#  define log_debug_G(FMT, ARG...)    do { if( log_enabled(LOG_DEBUG) ) log_debug(FMT, ## ARG); } while (0)
+
 #  define log_critical_F(FMT, ARG...) log_critical("%s: "FMT, __FUNCTION__, ## ARG)
 #  define log_error_F(FMT, ARG...)    log_error("%s: "FMT, __FUNCTION__, ## ARG)
 #  define log_warning_F(FMT, ARG...)  log_warning("%s: "FMT, __FUNCTION__, ## ARG)
@@ -92,6 +111,8 @@ void log_debug      (const char *fmt, ...) __attribute__((format(printf,1,2)));
 #  define log_close()          do {} while (0)
 #  define log_set_level(lev)   do {} while (0)
 #  define log_reopen(dr)       do {} while (0)
+#  define log_flush()          do {} while (0)
+#  define log_enabled(pri)     0
 
 #  define log_critical(...)    do {} while (0)
 #  define log_error(...)       do {} while (0)
@@ -114,6 +135,9 @@ void log_debug      (const char *fmt, ...) __attribute__((format(printf,1,2)));
 #  define log_info_F(...)      do {} while (0)
 #  define log_debug_F(...)     do {} while (0)
 
+#  define log_info_G(...)      do {} while (0)
+#  define log_debug_G(...)     do {} while (0)
+
 # endif
 
 /* ------------------------------------------------------------------------- *
@@ -0,0 +1,248 @@
+/* ========================================================================= *
+ *
+ * This file is part of Alarmd
+ *
+ * Copyright (C) 2008-2009 Nokia Corporation and/or its subsidiary(-ies).
+ *
+ * Contact: Simo Piiroinen <simo.piiroinen@nokia.com>
+ *
+ * Alarmd is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * version 2.1 as published by the Free Software Foundation.
+ *
+ * Alarmd is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with Alarmd; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA
+ * 02110-1301 USA
+ *
+ * ========================================================================= */
+#include "alarmd_config.h"
+
+#include "msgcache.h"
+#include "serialize.h"
+#include "logging.h"
+#include "xutil.h"
+
+#include <dbus/dbus.h>
+
+#include <stdlib.h>
+#include <string.h>
+
+typedef struct msgslot_t msgslot_t;
+
+/* Action flags that affect the message content */
+#define MSGCACHE_FLAGS ALARM_ACTION_DBUS_USE_ACTIVATION
+
+/* ------------------------------------------------------------------------- *
+ * msgslot_t  --  message template for one action table entry
+ * ------------------------------------------------------------------------- */
+
+struct msgslot_t
+{
+  /* key: D-Bus related action fields */
+  unsigned     ms_flags;
+  char        *ms_service;
+  char        *ms_path;
+  char        *ms_interface;
+  char        *ms_name;
+  char        *ms_args;
+
+  /* template message, or NULL if not built yet */
+  DBusMessage *ms_tmpl;
+};
+
+/* ------------------------------------------------------------------------- *
+ * msgcache_t  --  per event cache
+ * ------------------------------------------------------------------------- */
+
+struct msgcache_t
+{
+  /* mc_count slots, one for each action */
+  size_t       mc_count;
+  msgslot_t   *mc_slot;
+};
+
+/* ========================================================================= *
+ * msgslot_t
+ * ========================================================================= */
+
+/* ------------------------------------------------------------------------- *
+ * msgslot_clear  --  release template and key data
+ * ------------------------------------------------------------------------- */
+
+static void
+msgslot_clear(msgslot_t *self)
+{
+  if( self->ms_tmpl != 0 )
+  {
+    dbus_message_unref(self->ms_tmpl);
+  }
+
+  free(self->ms_service);
+  free(self->ms_path);
+  free(self->ms_interface);
+  free(self->ms_name);
+  free(self->ms_args);
+
+  memset(self, 0, sizeof *self);
+}
+
+/* ------------------------------------------------------------------------- *
+ * msgslot_is_valid  --  template was built from the action as it is now
+ * ------------------------------------------------------------------------- */
+
+static int
+msgslot_is_valid(const msgslot_t *self, const alarm_action_t *act)
+{
+  return (self->ms_tmpl != 0 &&
+          self->ms_flags == (act->flags & MSGCACHE_FLAGS) &&
+          xissame(self->ms_service,   act->dbus_service) &&
+          xissame(self->ms_path,      act->dbus_path) &&
+          xissame(self->ms_interface, act->dbus_interface) &&
+          xissame(self->ms_name,      act->dbus_name) &&
+          xissame(self->ms_args,      act->dbus_args));
+}
+
+/* ------------------------------------------------------------------------- *
+ * msgslot_build  --  construct message from action data
+ * ------------------------------------------------------------------------- */
+
+static DBusMessage *
+msgslot_build(const alarm_action_t *act)
+{
+  DBusMessage *msg = 0;
+
+  if( !xisempty(act->dbus_service) )
+  {
+    log_info("DBUS: is method\n");
+    msg = dbus_message_new_method_call(act->dbus_service,
+                                       act->dbus_path,
+                                       act->dbus_interface,
+                                       act->dbus_name);
+    if( msg == 0 )
+    {
+      goto cleanup;
+    }
+
+    if( act->flags & ALARM_ACTION_DBUS_USE_ACTIVATION )
+    {
+      log_info("DBUS: is auto start\n");
+      dbus_message_set_auto_start(msg, TRUE);
+    }
+    dbus_message_set_no_reply(msg, TRUE);
+  }
+  else
+  {
+    log_info("DBUS: is signal\n");
+    msg = dbus_message_new_signal(act->dbus_path,
+                                  act->dbus_interface,
+                                  act->dbus_name);
+    if( msg == 0 )
+    {
+      goto cleanup;
+    }
+  }
+
+  if( !xisempty(act->dbus_args) )
+  {
+    log_info("DBUS: has user args\n");
+    serialize_unpack_to_mesg(act->dbus_args, msg);
+  }
+
+  cleanup:
+
+  return msg;
+}
+
+/* ------------------------------------------------------------------------- *
+ * msgslot_update  --  rebuild template from action data
+ * ------------------------------------------------------------------------- */
+
+static void
+msgslot_update(msgslot_t *self, const alarm_action_t *act)
+{
+  msgslot_clear(self);
+
+  if( (self->ms_tmpl = msgslot_build(act)) != 0 )
+  {
+    self->ms_flags     = act->flags & MSGCACHE_FLAGS;
+    self->ms_service   = act->dbus_service   ? strdup(act->dbus_service)   : 0;
+    self->ms_path      = act->dbus_path      ? strdup(act->dbus_path)      : 0;
+    self->ms_interface = act->dbus_interface ? strdup(act->dbus_interface) : 0;
+    self->ms_name      = act->dbus_name      ? strdup(act->dbus_name)      : 0;
+    self->ms_args      = act->dbus_args      ? strdup(act->dbus_args)      : 0;
+  }
+}
+
+/* ========================================================================= *
+ * msgcache_t
+ * ========================================================================= */
+
+/* ------------------------------------------------------------------------- *
+ * msgcache_create  --  empty cache for event
+ * ------------------------------------------------------------------------- */
+
+static msgcache_t *
+msgcache_create(const alarm_event_t *eve)
+{
+  msgcache_t *self = calloc(1, sizeof *self);
+
+  self->mc_count = eve->action_cnt;
+  self->mc_slot  = calloc(self->mc_count + 1, sizeof *self->mc_slot);
+
+  return self;
+}
+
+/* ------------------------------------------------------------------------- *
+ * msgcache_delete
+ * ------------------------------------------------------------------------- */
+
+void
+msgcache_delete(msgcache_t *self)
+{
+  if( self != 0 )
+  {
+    for( size_t i = 0; i < self->mc_count; ++i )
+    {
+      msgslot_clear(&self->mc_slot[i]);
+    }
+    free(self->mc_slot);
+    free(self);
+  }
+}
+
+/* ------------------------------------------------------------------------- *
+ * msgcache_get_message
+ * ------------------------------------------------------------------------- */
+
+DBusMessage *
+msgcache_get_message(msgcache_t **pcache, const alarm_event_t *eve, size_t i)
+{
+  const alarm_action_t *act = &eve->action_tab[i];
+  msgslot_t            *slot = 0;
+
+  if( pcache == 0 )
+  {
+    return msgslot_build(act);
+  }
+
+  if( *pcache == 0 || (*pcache)->mc_count != eve->action_cnt )
+  {
+    msgcache_delete(*pcache);
+    *pcache = msgcache_create(eve);
+  }
+
+  slot = &(*pcache)->mc_slot[i];
+
+  if( !msgslot_is_valid(slot, act) )
+  {
+    msgslot_update(slot, act);
+  }
+
+  return (slot->ms_tmpl != 0) ? dbus_message_copy(slot->ms_tmpl) : 0;
+}
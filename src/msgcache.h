@@ -0,0 +1,59 @@
+/* ========================================================================= *
+ *
+ * This file is part of Alarmd
+ *
+ * Copyright (C) 2008-2009 Nokia Corporation and/or its subsidiary(-ies).
+ *
+ * Contact: Simo Piiroinen <simo.piiroinen@nokia.com>
+ *
+ * Alarmd is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * version 2.1 as published by the Free Software Foundation.
+ *
+ * Alarmd is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with Alarmd; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA
+ * 02110-1301 USA
+ *
+ * ========================================================================= */
+#ifndef MSGCACHE_H_
+#define MSGCACHE_H_
+
+#include "libalarm.h"
+
+#ifdef __cplusplus
+extern "C" {
+#elif 0
+} /* fool JED indentation ... */
+#endif
+
+typedef struct msgcache_t msgcache_t;
+
+struct DBusMessage;
+
+/* ------------------------------------------------------------------------- *
+ * Cached D-Bus action messages
+ *
+ * msgcache_get_message() returns a new D-Bus method call or signal
+ * message as specified by the i'th action of the event, with the
+ * user arguments from dbus_args already appended.
+ *
+ * The message is copied from a template that is built on first use
+ * and kept in *pcache as long as the D-Bus related action fields stay
+ * the same, so that dbus_args do not need to be parsed again each
+ * time the action is executed. Passing a NULL pcache disables caching.
+ * ------------------------------------------------------------------------- */
+
+void                msgcache_delete     (msgcache_t *self);
+struct DBusMessage *msgcache_get_message(msgcache_t **pcache, const alarm_event_t *eve, size_t i);
+
+#ifdef __cplusplus
+};
+#endif
+
+#endif /* MSGCACHE_H_ */
@@ -25,9 +25,12 @@
 #include "alarmd_config.h"
 
 #include "queue.h"
+#include "alarm_dbus.h"
 #include "logging.h"
 #include "inifile.h"
+#include "queuebin.h"
 #include "ticker.h"
+#include "unique.h"
 
 #include <limits.h>
 #include <unistd.h>
@@ -46,6 +49,10 @@
 #define QUEUE_DATABASE    ALARMD_CONFIG_CACHEDIR"/alarm_queue.ini"
 #define QUEUE_BACKUP      QUEUE_DATABASE".bak"
 #define QUEUE_TEMPSAVE    QUEUE_DATABASE".tmp"
+#define QUEUE_JOURNAL     QUEUE_DATABASE".journal"
+
+#define QUEUE_BINARY      ALARMD_CONFIG_CACHEDIR"/alarm_queue.bin"
+#define QUEUE_BINARY_TEMP QUEUE_BINARY".tmp"
 
 /* ------------------------------------------------------------------------- *
  * default settings
@@ -53,6 +60,10 @@
 
 #define QUEUE_SNOOZE_DEFAULT   (10 * 60) // 10 minutes
 
+/* journal is compacted when it grows larger than this
+ * and the queue file itself */
+#define QUEUE_JOURNAL_MIN      (32 << 10) // 32 kB
+
 /* ------------------------------------------------------------------------- *
  * event state names
  * ------------------------------------------------------------------------- */
@@ -77,34 +88,237 @@ static cookie_t        queue_cookie = 0;
 /* queue out of sync with persistent storage flag */
 static int             queue_dirty  = 0;
 
-/* active events - ordered by event cookie
- *
- * ascending cookie sort: older alarms first */
-static alarm_event_t **queue_by_cookie  = 0;
-
-/* active events - ordered by event trigger
- *
- * descending trigger sort: the first to trigger
- * is the last in the queue -> updating trigger
- * values (due to snooze etc) is more likely to
- * affect only the tail of the queue */
-static alarm_event_t **queue_by_trigger = 0;
-
 /* number of active events */
-static size_t          queue_count      = 0;
-
-/* number of slots available in queue tables */
-static size_t          queue_alloc      = 0;
+static size_t          queue_count  = 0;
 
 /* stats of the queue file - used for detecting whend somebody
  * else than alarmd has modified the queue file since the last
  * load / save operation (mainly restoring backed up alarms). */
 static struct stat     queue_save_stat;
 
+/* write binary copy of the queue file along with snapshots */
+static int             queue_binary = ALARMD_QUEUE_BINARY;
+
 /* callback function: called when queue
  * file modification is detected */
 static void (*queue_modified_cb)(void) = 0;
 
+/* callback function: called when queued event
+ * is added, modified or removed */
+static void (*queue_changed_cb)(alarm_event_t *, int) = 0;
+
+static void queue_indicate_changed(alarm_event_t *eve, int kind);
+
+/* ========================================================================= *
+ * QUEUE NODES
+ * ========================================================================= */
+
+/* ------------------------------------------------------------------------- *
+ * queue_node_t  --  per event bookkeeping data
+ * ------------------------------------------------------------------------- */
+
+typedef struct queue_node_t queue_node_t;
+typedef struct queue_app_t  queue_app_t;
+
+struct queue_node_t
+{
+  /* the event this node belongs to */
+  alarm_event_t *qn_event;
+
+  /* state list the node is currently linked to */
+  unsigned       qn_state;
+
+  /* disabled status accounted in state counters */
+  int            qn_disabled;
+
+  /* event might differ from what was last saved; set whenever
+   * the event is modified via the queue_event_set_xxx() api */
+  int            qn_dirty;
+
+  /* links in per-state list */
+  queue_node_t  *qn_prev;
+  queue_node_t  *qn_next;
+
+  /* links in trigger ordered red-black tree */
+  queue_node_t  *qn_parent;
+  queue_node_t  *qn_left;
+  queue_node_t  *qn_right;
+  int            qn_red;
+
+  /* link in cookie hash chain */
+  queue_node_t  *qn_hash;
+
+  /* appid index entry and links in its event list */
+  queue_app_t   *qn_app;
+  queue_node_t  *qn_app_prev;
+  queue_node_t  *qn_app_next;
+
+  /* memoized recurrence evaluation, owned by the node */
+  recurcache_t  *qn_recurcache;
+
+  /* D-Bus action message templates, owned by the node */
+  msgcache_t    *qn_msgcache;
+
+  /* wakeup heap the node is in and 1-based position
+   * in it, zero position = not in any wakeup heap */
+  int            qn_wake_cls;
+  size_t         qn_wake_pos;
+};
+
+/* ------------------------------------------------------------------------- *
+ * queue_app_t  --  per appid index entry
+ * ------------------------------------------------------------------------- */
+
+struct queue_app_t
+{
+  /* link in appid hash chain */
+  queue_app_t   *qa_hash;
+
+  /* hash of the appid string */
+  unsigned       qa_key;
+
+  /* application identifier, empty string for
+   * events that do not have one */
+  char          *qa_appid;
+
+  /* circular list of events, the head is a
+   * sentinel that does not belong to any event */
+  queue_node_t   qa_head;
+
+  /* number of events in the list */
+  size_t         qa_count;
+};
+
+/* active events - ordered by (trigger, cookie)
+ *
+ * ascending sort: the first to trigger is the leftmost
+ * node, the "oldest" (by cookie) at the same time first */
+static queue_node_t   *queue_tree_root = 0;
+
+/* active events - hashed by event cookie */
+static queue_node_t  **queue_hash_tab  = 0;
+
+/* number of buckets in the cookie hash, power of two */
+static size_t          queue_hash_size = 0;
+
+/* app filtered queries sort the events of the application
+ * unless it owns more than 1/QUEUE_APP_SCAN_RATIO of the queue */
+#define QUEUE_APP_SCAN_RATIO 8
+
+/* active events - indexed by appid */
+static queue_app_t   **queue_app_tab   = 0;
+
+/* number of buckets in the appid hash, power of two */
+static size_t          queue_app_size  = 0;
+
+/* number of entries in the appid hash */
+static size_t          queue_app_count = 0;
+
+/* per-state circular lists of queued events, the heads
+ * are sentinels that do not belong to any event */
+static queue_node_t    queue_state_list[ALARM_STATE_NUMOF];
+
+/* per-state number of events that are not disabled */
+static int             queue_state_count[ALARM_STATE_NUMOF];
+
+/* enabled events in ALARM_STATE_QUEUED - one binary min-heap
+ * per wakeup class, ordered like the trigger tree */
+static queue_node_t  **queue_wake_heap[QUEUE_WAKEUP_NUMOF];
+static size_t          queue_wake_count[QUEUE_WAKEUP_NUMOF];
+static size_t          queue_wake_alloc[QUEUE_WAKEUP_NUMOF];
+
+/* number of events in wakeup heaps that want statusbar icon */
+static int             queue_wake_icons = 0;
+
+/* callback function: classifies events for wakeup heaps */
+static int (*queue_wake_class_cb)(alarm_event_t *) = 0;
+
+static void queue_wake_sync  (queue_node_t *self);
+static void queue_wake_remove(queue_node_t *self);
+
+/* ------------------------------------------------------------------------- *
+ * queue_node_link  --  append node to the list of its current state
+ * ------------------------------------------------------------------------- */
+
+static
+void
+queue_node_link(queue_node_t *self)
+{
+  queue_node_t *head = &queue_state_list[self->qn_state];
+
+  if( head->qn_next == 0 )
+  {
+    head->qn_next = head->qn_prev = head;
+  }
+
+  self->qn_next = head;
+  self->qn_prev = head->qn_prev;
+  self->qn_prev->qn_next = self;
+  self->qn_next->qn_prev = self;
+
+  if( !self->qn_disabled )
+  {
+    queue_state_count[self->qn_state] += 1;
+  }
+
+  queue_wake_sync(self);
+}
+
+/* ------------------------------------------------------------------------- *
+ * queue_node_unlink  --  remove node from the list of its current state
+ * ------------------------------------------------------------------------- */
+
+static
+void
+queue_node_unlink(queue_node_t *self)
+{
+  queue_wake_remove(self);
+
+  self->qn_prev->qn_next = self->qn_next;
+  self->qn_next->qn_prev = self->qn_prev;
+  self->qn_prev = self->qn_next = 0;
+
+  if( !self->qn_disabled )
+  {
+    queue_state_count[self->qn_state] -= 1;
+  }
+}
+
+/* ------------------------------------------------------------------------- *
+ * queue_node_create  --  allocate bookkeeping data for event
+ * ------------------------------------------------------------------------- */
+
+static
+queue_node_t *
+queue_node_create(alarm_event_t *event)
+{
+  queue_node_t *self = calloc(1, sizeof *self);
+
+  self->qn_event    = event;
+  self->qn_state    = queue_event_get_state(event);
+  self->qn_disabled = (event->flags & ALARM_EVENT_DISABLED) != 0;
+  self->qn_dirty    = 1;
+
+  return self;
+}
+
+/* ------------------------------------------------------------------------- *
+ * queue_node_delete  --  release bookkeeping data of event
+ * ------------------------------------------------------------------------- */
+
+static
+void
+queue_node_delete(queue_node_t *self)
+{
+  if( self != 0 )
+  {
+    queue_node_unlink(self);
+    recurcache_delete(self->qn_recurcache);
+    msgcache_delete(self->qn_msgcache);
+    free(self);
+  }
+}
+
 /* ========================================================================= *
  * COMPARE OPERATORS
  * ========================================================================= */
@@ -156,13 +370,13 @@ static
 int
 queue_cmp_event_trigger(const alarm_event_t *a, const alarm_event_t *b)
 {
-  // trigger table in descending order:
-  // - next to trigger last
-  // - "oldest" (by cookie) at the same time last
+  // trigger ordering is ascending:
+  // - next to trigger first
+  // - "oldest" (by cookie) at the same time first
 
   time_t ta = alarm_event_get_trigger(a);
   time_t tb = alarm_event_get_trigger(b);
-  return queue_cmp_trigger(tb, ta) ?: queue_cmp_event_cookie(b,a);
+  return queue_cmp_trigger(ta, tb) ?: queue_cmp_event_cookie(a,b);
 }
 
 #undef CMP
@@ -172,914 +386,2514 @@ queue_cmp_event_trigger(const alarm_event_t *a, const alarm_event_t *b)
  * ========================================================================= */
 
 /* ------------------------------------------------------------------------- *
- * queue_get_trigger_slot  --  find event slot in trigger ordered table
+ * queue_tree_rotate  --  rotate subtree left (dir=0) or right (dir=1)
  * ------------------------------------------------------------------------- */
 
-static size_t queue_get_trigger_slot(alarm_event_t *eve)
+static
+void
+queue_tree_rotate(queue_node_t *x, int dir)
 {
-  size_t l,h,i;
+  queue_node_t *y = dir ? x->qn_left : x->qn_right;
+  queue_node_t *p = x->qn_parent;
 
-  for( l = 0, h = queue_count; l < h; )
+  if( dir )
   {
-    if( queue_cmp_event_trigger(queue_by_trigger[(i = (l+h)/2)], eve) < 0 )
-    {
-      l = i + 1;
-    }
-    else
-    {
-      h = i + 0;
-    }
+    if( (x->qn_left = y->qn_right) != 0 ) x->qn_left->qn_parent = x;
+    y->qn_right = x;
   }
-  assert( l == h );
-  return l;
+  else
+  {
+    if( (x->qn_right = y->qn_left) != 0 ) x->qn_right->qn_parent = x;
+    y->qn_left = x;
+  }
+
+  x->qn_parent = y;
+  y->qn_parent = p;
+
+  if( p == 0 )             queue_tree_root = y;
+  else if( p->qn_left == x ) p->qn_left    = y;
+  else                       p->qn_right   = y;
 }
 
 /* ------------------------------------------------------------------------- *
- * queue_get_cookie_slot  --  find event slot in cookie ordered table
+ * queue_tree_replace  --  put subtree v in place of subtree u
  * ------------------------------------------------------------------------- */
 
-static size_t queue_get_cookie_slot(alarm_event_t *eve)
+static
+void
+queue_tree_replace(queue_node_t *u, queue_node_t *v)
 {
-  size_t l,h,i;
+  queue_node_t *p = u->qn_parent;
 
-  for( l = 0, h = queue_count; l < h; )
-  {
-    if( queue_cmp_event_cookie(queue_by_cookie[(i = (l+h)/2)], eve) < 0 )
-    {
-      l = i + 1;
-    }
-    else
-    {
-      h = i + 0;
-    }
-  }
-  assert( l == h );
-  return l;
+  if( p == 0 )               queue_tree_root = v;
+  else if( p->qn_left == u ) p->qn_left      = v;
+  else                       p->qn_right     = v;
+
+  if( v != 0 ) v->qn_parent = p;
 }
 
 /* ------------------------------------------------------------------------- *
- * queue_insert_event
+ * queue_tree_first  --  leftmost node in subtree
  * ------------------------------------------------------------------------- */
 
 static
-void
-queue_insert_event(alarm_event_t *eve)
+queue_node_t *
+queue_tree_first(queue_node_t *self)
 {
-  if( queue_count == queue_alloc )
+  if( self != 0 )
   {
-    queue_alloc += 32;
-
-    queue_by_cookie  = realloc(queue_by_cookie,
-                               queue_alloc * sizeof *queue_by_cookie);
-    queue_by_trigger = realloc(queue_by_trigger,
-                               queue_alloc * sizeof *queue_by_trigger);
+    while( self->qn_left != 0 ) self = self->qn_left;
   }
+  return self;
+}
 
-  size_t t = queue_get_trigger_slot(eve);
-  size_t c = queue_get_cookie_slot(eve);
-
-  assert( (t == queue_count) || (queue_by_trigger[t] != eve) );
-  assert( (c == queue_count) || (queue_by_cookie[c]  != eve) );
+/* ------------------------------------------------------------------------- *
+ * queue_tree_next  --  in-order successor of node
+ * ------------------------------------------------------------------------- */
 
-  for( size_t i = queue_count; i > t; --i )
+static
+queue_node_t *
+queue_tree_next(queue_node_t *self)
+{
+  if( self->qn_right != 0 )
   {
-    queue_by_trigger[i] = queue_by_trigger[i-1];
+    return queue_tree_first(self->qn_right);
   }
 
-  for( size_t i = queue_count; i > c; --i )
+  queue_node_t *p;
+
+  while( (p = self->qn_parent) != 0 && p->qn_right == self )
   {
-    queue_by_cookie[i] = queue_by_cookie[i-1];
+    self = p;
   }
-
-  queue_by_trigger[t] = eve;
-  queue_by_cookie[c]  = eve;
-  queue_count += 1;
-
-  queue_set_dirty();
+  return p;
 }
 
-/* ========================================================================= *
- * INDICATION INTERFACE
- * ========================================================================= */
-
 /* ------------------------------------------------------------------------- *
- * queue_set_modified_cb
+ * queue_tree_seek  --  first node triggering at or after given time
  * ------------------------------------------------------------------------- */
 
-void queue_set_modified_cb(void (*cb)(void))
+static
+queue_node_t *
+queue_tree_seek(time_t lo)
 {
-  queue_modified_cb = cb;
+  queue_node_t *res = 0;
+
+  for( queue_node_t *x = queue_tree_root; x != 0; )
+  {
+    if( x->qn_event->ALARMD_PRIVATE(trigger) >= lo )
+    {
+      res = x;
+      x   = x->qn_left;
+    }
+    else
+    {
+      x = x->qn_right;
+    }
+  }
+  return res;
 }
 
 /* ------------------------------------------------------------------------- *
- * queue_indicate_modified
+ * queue_tree_insert  --  add node to trigger ordered tree
  * ------------------------------------------------------------------------- */
 
-static void queue_indicate_modified(void)
+static
+void
+queue_tree_insert(queue_node_t *z)
 {
-  if( queue_modified_cb != 0 )
+  queue_node_t  *p    = 0;
+  queue_node_t **slot = &queue_tree_root;
+
+  while( *slot != 0 )
   {
-    queue_modified_cb();
+    p = *slot;
+    if( queue_cmp_event_trigger(z->qn_event, p->qn_event) < 0 )
+    {
+      slot = &p->qn_left;
+    }
+    else
+    {
+      slot = &p->qn_right;
+    }
   }
-}
 
-/* ========================================================================= *
- * SETTINGS INTERFACE
- * ========================================================================= */
+  z->qn_parent = p;
+  z->qn_left   = 0;
+  z->qn_right  = 0;
+  z->qn_red    = 1;
+  *slot = z;
 
-/* ------------------------------------------------------------------------- *
- * queue_get_snooze
- * ------------------------------------------------------------------------- */
+  /* - - - - - - - - - - - - - - - - - - - *
+   * restore red-black properties
+   * - - - - - - - - - - - - - - - - - - - */
 
-unsigned
-queue_get_snooze(void)
-{
-  return queue_snooze;
-}
+  while( (p = z->qn_parent) != 0 && p->qn_red )
+  {
+    queue_node_t *g = p->qn_parent;
+    int           d = (p == g->qn_left);  // rotate dir for uncle side
+    queue_node_t *u = d ? g->qn_right : g->qn_left;
 
-/* ------------------------------------------------------------------------- *
- * queue_set_snooze
- * ------------------------------------------------------------------------- */
+    if( u != 0 && u->qn_red )
+    {
+      p->qn_red = u->qn_red = 0;
+      g->qn_red = 1;
+      z = g;
+      continue;
+    }
 
-void
-queue_set_snooze(unsigned snooze)
-{
-  if( snooze < 1 || snooze > 24*60*60 )
-  {
-    snooze = QUEUE_SNOOZE_DEFAULT;
+    if( z == (d ? p->qn_right : p->qn_left) )
+    {
+      queue_tree_rotate(p, !d);
+      z = p;
+      p = z->qn_parent;
+    }
+
+    p->qn_red = 0;
+    g->qn_red = 1;
+    queue_tree_rotate(g, d);
   }
-  queue_snooze = snooze;
-  queue_set_dirty();
-}
 
-/* ========================================================================= *
- * EVENT INTERFACE
- * ========================================================================= */
+  queue_tree_root->qn_red = 0;
+}
 
 /* ------------------------------------------------------------------------- *
- * queue_event_set_trigger
+ * queue_tree_remove  --  remove node from trigger ordered tree
  * ------------------------------------------------------------------------- */
 
+static
 void
-queue_event_set_trigger(alarm_event_t *event, time_t trigger)
+queue_tree_remove(queue_node_t *z)
 {
-  log_info("[%ld] SET TRIGGER: %s (T%s)\n",
-           (long)alarm_event_get_cookie(event),
-           ticker_date_format_long(0,0,trigger),
-           ticker_secs_format(0,0,ticker_get_time()-trigger));
+  queue_node_t *x, *xp;
+  int           red = z->qn_red;
+
+  if( z->qn_left == 0 )
+  {
+    x  = z->qn_right;
+    xp = z->qn_parent;
+    queue_tree_replace(z, x);
+  }
+  else if( z->qn_right == 0 )
+  {
+    x  = z->qn_left;
+    xp = z->qn_parent;
+    queue_tree_replace(z, x);
+  }
+  else
+  {
+    queue_node_t *y = queue_tree_first(z->qn_right);
 
-  size_t ti, to;
+    red = y->qn_red;
+    x   = y->qn_right;
 
-  /* - - - - - - - - - - - - - - - - - - - *
-   * get slot indices for old and updated
-   * trigger values
-   * - - - - - - - - - - - - - - - - - - - */
+    if( y->qn_parent == z )
+    {
+      xp = y;
+    }
+    else
+    {
+      xp = y->qn_parent;
+      queue_tree_replace(y, x);
+      y->qn_right = z->qn_right;
+      y->qn_right->qn_parent = y;
+    }
 
-  alarm_event_t temp = {
-    .ALARMD_PRIVATE(cookie) = event->ALARMD_PRIVATE(cookie),
-    .ALARMD_PRIVATE(trigger) = trigger,
-  };
+    queue_tree_replace(z, y);
+    y->qn_left = z->qn_left;
+    y->qn_left->qn_parent = y;
+    y->qn_red = z->qn_red;
+  }
 
-  ti = queue_get_trigger_slot(event);
-  to = queue_get_trigger_slot(&temp);
+  z->qn_parent = z->qn_left = z->qn_right = 0;
 
-  event->ALARMD_PRIVATE(trigger) = trigger;
+  if( red )
+  {
+    return;
+  }
 
   /* - - - - - - - - - - - - - - - - - - - *
-   * how queue will be shifted depends on
-   * whether the updated position is before
-   * or after the original
+   * removed a black node -> restore
+   * red-black properties
    * - - - - - - - - - - - - - - - - - - - */
 
-  if( to <= ti )
+  while( x != queue_tree_root && (x == 0 || !x->qn_red) )
   {
-    //  +---+---+---+---+---+---+---+---+
-    //  | A | B | C | X | D | E | F | G |
-    //  +---+---+---+---+---+---+---+---+
-    //      |to     |ti
-    //  +---+---+---+---+---+---+---+---+
-    //  | A | - | B | C | D | E | F | G |
-    //  +---+---+---+---+---+---+---+---+
-    //      |to     |ti
+    int           d = (x == xp->qn_left);  // rotate dir towards x
+    queue_node_t *w = d ? xp->qn_right : xp->qn_left;
 
-    for( ; ti > to; --ti )
+    if( w->qn_red )
     {
-      queue_by_trigger[ti] = queue_by_trigger[ti-1];
+      w->qn_red  = 0;
+      xp->qn_red = 1;
+      queue_tree_rotate(xp, !d);
+      w = d ? xp->qn_right : xp->qn_left;
+    }
+
+    queue_node_t *wn = d ? w->qn_left  : w->qn_right; // near nephew
+    queue_node_t *wf = d ? w->qn_right : w->qn_left;  // far nephew
+
+    if( (wn == 0 || !wn->qn_red) && (wf == 0 || !wf->qn_red) )
+    {
+      w->qn_red = 1;
+      x  = xp;
+      xp = x->qn_parent;
+      continue;
     }
-  }
-  else
-  {
-    //  +---+---+---+---+---+---+---+---+
-    //  | A | B | C | X | D | E | F | G |
-    //  +---+---+---+---+---+---+---+---+
-    //              |ti         |to
-    //  +---+---+---+---+---+---+---+---+
-    //  | A | B | C | D | E | - | F | G |
-    //  +---+---+---+---+---+---+---+---+
-    //              |ti     |to
 
-    for( --to; ti < to; ++ti )
+    if( wf == 0 || !wf->qn_red )
     {
-      queue_by_trigger[ti] = queue_by_trigger[ti+1];
+      wn->qn_red = 0;
+      w->qn_red  = 1;
+      queue_tree_rotate(w, d);
+      w  = d ? xp->qn_right : xp->qn_left;
+      wf = d ? w->qn_right  : w->qn_left;
     }
+
+    w->qn_red  = xp->qn_red;
+    xp->qn_red = 0;
+    wf->qn_red = 0;
+    queue_tree_rotate(xp, !d);
+    x = queue_tree_root;
   }
-  queue_by_trigger[to] = event;
 
-  queue_set_dirty();
+  if( x != 0 )
+  {
+    x->qn_red = 0;
+  }
 }
 
 /* ------------------------------------------------------------------------- *
- * queue_event_get_state
+ * queue_wake_place  --  store node to wakeup heap slot
  * ------------------------------------------------------------------------- */
 
-unsigned
-queue_event_get_state(const alarm_event_t *self)
+static
+void
+queue_wake_place(queue_node_t *self, size_t pos)
 {
-  return self->flags >> ALARM_EVENT_CLIENT_BITS;
+  queue_wake_heap[self->qn_wake_cls][pos] = self;
+  self->qn_wake_pos = pos;
 }
 
 /* ------------------------------------------------------------------------- *
- * queue_event_set_state
+ * queue_wake_sift  --  restore heap order around node
  * ------------------------------------------------------------------------- */
 
+static
 void
-queue_event_set_state(alarm_event_t *self, unsigned state)
+queue_wake_sift(queue_node_t *self)
 {
-  unsigned previous = queue_event_get_state(self);
-  unsigned current  = previous;
+  queue_node_t **heap = queue_wake_heap[self->qn_wake_cls];
+  size_t         size = queue_wake_count[self->qn_wake_cls];
+  size_t         pos  = self->qn_wake_pos;
 
-  /* - - - - - - - - - - - - - - - - - - - *
-   * do some filtering for state transitions
-   * occuring due to external events
-   * - - - - - - - - - - - - - - - - - - - */
+  // towards the root
+  while( pos > 1 && queue_cmp_event_trigger(self->qn_event,
+                                            heap[pos/2]->qn_event) < 0 )
+  {
+    queue_wake_place(heap[pos/2], pos), pos /= 2;
+  }
 
-  switch( state )
+  // towards the leaves
+  for( size_t kid; (kid = pos * 2) <= size; pos = kid )
   {
-  default:
-    log_debug("UNKNOWN TRANSITION: %s -> %s\n",
-              queue_event_state_names[previous],
-              queue_event_state_names[state]);
-    break;
-
-  case ALARM_STATE_NEW:
-  case ALARM_STATE_WAITCONN:
-  case ALARM_STATE_QUEUED:
-  case ALARM_STATE_MISSED:
-  case ALARM_STATE_POSTPONED:
-
-  case ALARM_STATE_LIMBO:
-  case ALARM_STATE_TRIGGERED:
-  case ALARM_STATE_WAITSYSUI:
-  case ALARM_STATE_SYSUI_REQ:
-
-  case ALARM_STATE_SNOOZED:
-  case ALARM_STATE_SERVED:
-  case ALARM_STATE_RECURRING:
-  case ALARM_STATE_DELETED:
-  case ALARM_STATE_FINALIZED:
-    current = state;
-    break;
-
-  case ALARM_STATE_SYSUI_ACK:
-    switch( previous )
+    if( kid < size && queue_cmp_event_trigger(heap[kid+1]->qn_event,
+                                              heap[kid]->qn_event) < 0 )
     {
-    case ALARM_STATE_SYSUI_REQ:
-      current = state;
-      break;
+      kid += 1;
     }
-    break;
-
-  case ALARM_STATE_SYSUI_RSP:
-    switch( previous )
+    if( queue_cmp_event_trigger(heap[kid]->qn_event, self->qn_event) >= 0 )
     {
-    case ALARM_STATE_SYSUI_REQ:
-    case ALARM_STATE_SYSUI_ACK:
-      current = state;
       break;
     }
-    break;
-  }
-
-  if( previous != current )
-  {
-    log_info("[%ld] TRANS: %s -> %s\n",
-             self->ALARMD_PRIVATE(cookie),
-             queue_event_state_names[previous],
-             queue_event_state_names[current]);
-
-    if( (current == ALARM_STATE_NEW) || (current < previous) )
-    {
-      queue_set_dirty();
-    }
-  }
-  else if( current != state )
-  {
-    log_warning("[%ld] TRANS: %s -> %s - BLOCKED\n",
-              self->ALARMD_PRIVATE(cookie),
-              queue_event_state_names[previous],
-              queue_event_state_names[state]);
-  }
-  else if( current == ALARM_STATE_NEW )
-  {
-    log_info("[%ld] TRANS: %s -> %s\n",
-             self->ALARMD_PRIVATE(cookie),
-             queue_event_state_names[previous],
-             queue_event_state_names[current]);
+    queue_wake_place(heap[kid], pos);
   }
 
-  self->flags &= ALARM_EVENT_CLIENT_MASK;
-  self->flags |= (current << ALARM_EVENT_CLIENT_BITS);
+  queue_wake_place(self, pos);
 }
 
-/* ========================================================================= *
- * QUEUE INTERFACE
- * ========================================================================= */
-
 /* ------------------------------------------------------------------------- *
- * queue_add_event
+ * queue_wake_insert  --  add node to wakeup heap of its class
  * ------------------------------------------------------------------------- */
 
-cookie_t
-queue_add_event(alarm_event_t *event)
+static
+void
+queue_wake_insert(queue_node_t *self)
 {
-  if( event->ALARMD_PRIVATE(cookie) == 0 )
+  int cls = QUEUE_WAKEUP_NO_BOOT;
+
+  if( queue_wake_class_cb != 0 )
   {
-    event->ALARMD_PRIVATE(cookie) = ++queue_cookie;
+    cls = queue_wake_class_cb(self->qn_event);
   }
-  else if( queue_cookie < event->ALARMD_PRIVATE(cookie) )
+
+  if( queue_wake_count[cls] + 1 >= queue_wake_alloc[cls] )
   {
-    queue_cookie = event->ALARMD_PRIVATE(cookie);
+    queue_wake_alloc[cls] = queue_wake_alloc[cls] ? (queue_wake_alloc[cls] * 2) : 32;
+    queue_wake_heap[cls]  = realloc(queue_wake_heap[cls],
+                                    queue_wake_alloc[cls] * sizeof **queue_wake_heap);
   }
 
-  queue_insert_event(event);
+  self->qn_wake_cls = cls;
+  self->qn_wake_pos = ++queue_wake_count[cls];
+  queue_wake_sift(self);
 
-  return event->ALARMD_PRIVATE(cookie);
+  if( self->qn_event->flags & ALARM_EVENT_SHOW_ICON )
+  {
+    queue_wake_icons += 1;
+  }
 }
 
 /* ------------------------------------------------------------------------- *
- * queue_get_event
+ * queue_wake_remove  --  remove node from wakeup heap, if it is in one
  * ------------------------------------------------------------------------- */
 
-alarm_event_t *
-queue_get_event(cookie_t cookie)
+static
+void
+queue_wake_remove(queue_node_t *self)
 {
-  size_t l,h,i;
-
-  for( l = 0, h = queue_count; l < h; )
+  if( self->qn_wake_pos != 0 )
   {
-    alarm_event_t *event = queue_by_cookie[(i = (l+h)/2)];
-
-    int r = queue_cmp_cookie(event->ALARMD_PRIVATE(cookie), cookie);
+    int           cls  = self->qn_wake_cls;
+    queue_node_t *last = queue_wake_heap[cls][queue_wake_count[cls]--];
 
-    if( r < 0 ) { l = i + 1; continue; }
-    if( r > 0 ) { h = i + 0; continue; }
+    if( last != self )
+    {
+      last->qn_wake_pos = self->qn_wake_pos;
+      queue_wake_sift(last);
+    }
+    self->qn_wake_pos = 0;
 
-    return event;
+    if( self->qn_event->flags & ALARM_EVENT_SHOW_ICON )
+    {
+      queue_wake_icons -= 1;
+    }
   }
-  return 0;
 }
 
 /* ------------------------------------------------------------------------- *
- * queue_del_event
+ * queue_wake_sync  --  wakeup heaps hold enabled events in queued state
  * ------------------------------------------------------------------------- */
 
-int
-queue_del_event(cookie_t cookie)
+static
+void
+queue_wake_sync(queue_node_t *self)
 {
-  int            error = -1;
-  alarm_event_t *event = queue_get_event(cookie);
+  int want = (self->qn_state == ALARM_STATE_QUEUED && !self->qn_disabled);
 
-  if( event != 0 )
+  if( !want )
   {
-    error = 0;
-    queue_event_set_state(event, ALARM_STATE_DELETED);
+    queue_wake_remove(self);
+  }
+  else if( self->qn_wake_pos == 0 )
+  {
+    queue_wake_insert(self);
   }
-  return (error != -1);
 }
 
 /* ------------------------------------------------------------------------- *
- * queue_query_events
+ * queue_hash_slot  --  cookie hash chain head
  * ------------------------------------------------------------------------- */
 
-cookie_t *
-queue_query_events(int *pcnt, time_t lo, time_t hi, unsigned mask, unsigned flag, const char *app)
+static
+queue_node_t **
+queue_hash_slot(cookie_t cookie)
 {
-  cookie_t *res = calloc(queue_count+1, sizeof *res);
-  size_t    cnt = 0;
+  unsigned long h = (unsigned long)cookie * 2654435761ul;
+  return &queue_hash_tab[(h ^ (h >> 16)) & (queue_hash_size - 1)];
+}
 
-  if( hi <= 0 )
-  {
-    hi = INT_MAX;
-  }
-  if( lo <= 0 )
-  {
-    lo = INT_MIN;
-  }
+/* ------------------------------------------------------------------------- *
+ * queue_hash_insert  --  add node to cookie hash
+ * ------------------------------------------------------------------------- */
 
-  for( size_t i = queue_count; i--; )
+static
+void
+queue_hash_insert(queue_node_t *self)
+{
+  if( queue_count >= queue_hash_size )
   {
-    alarm_event_t *eve = queue_by_trigger[i];
-
-    /* Because alarms are no longer removed from queue
-     * immediately after "del_event" method call, we
-     * need to filter them out from client query results */
-
-    if( queue_event_get_state(eve) == ALARM_STATE_DELETED )
-    {
-      continue;
-    }
-
-    if( eve->ALARMD_PRIVATE(trigger) < lo ) continue;
-
-    if( eve->ALARMD_PRIVATE(trigger) > hi ) break;
+    /* keep load factor below one */
+    queue_node_t **tab  = queue_hash_tab;
+    size_t         size = queue_hash_size;
 
-    if( (eve->flags & mask) != flag )
-    {
-      continue;
-    }
+    queue_hash_size = size ? (size * 2) : 32;
+    queue_hash_tab  = calloc(queue_hash_size, sizeof *queue_hash_tab);
 
-    if( !xisempty(app) )
+    for( size_t i = 0; i < size; ++i )
     {
-      if( (eve->alarm_appid == 0) || strcmp(eve->alarm_appid, app) )
+      for( queue_node_t *next; tab[i] != 0; tab[i] = next )
       {
-        continue;
+        queue_node_t **slot = queue_hash_slot(tab[i]->qn_event->ALARMD_PRIVATE(cookie));
+
+        next = tab[i]->qn_hash;
+        tab[i]->qn_hash = *slot;
+        *slot = tab[i];
       }
     }
-
-    res[cnt++] = eve->ALARMD_PRIVATE(cookie);
+    free(tab);
   }
-  res[cnt] = 0;
 
-  if( pcnt ) *pcnt = cnt;
+  queue_node_t **slot = queue_hash_slot(self->qn_event->ALARMD_PRIVATE(cookie));
 
-  return res;
+  self->qn_hash = *slot;
+  *slot = self;
 }
 
 /* ------------------------------------------------------------------------- *
- * queue_query_by_state
+ * queue_hash_remove  --  remove node from cookie hash
  * ------------------------------------------------------------------------- */
 
-cookie_t *
-queue_query_by_state(int *pcnt, unsigned state)
+static
+void
+queue_hash_remove(queue_node_t *self)
 {
-  cookie_t *res = calloc(queue_count+1, sizeof *res);
-  size_t    cnt = 0;
+  queue_node_t **slot = queue_hash_slot(self->qn_event->ALARMD_PRIVATE(cookie));
 
-  for( size_t i = queue_count; i--; )
+  for( ; *slot != 0; slot = &(*slot)->qn_hash )
   {
-    alarm_event_t *eve = queue_by_trigger[i];
-
-    if( eve->flags & ALARM_EVENT_DISABLED )
-    {
-      continue;
-    }
-
-    if( queue_event_get_state(eve) == state )
+    if( *slot == self )
     {
-      res[cnt++] = eve->ALARMD_PRIVATE(cookie);
+      *slot = self->qn_hash;
+      break;
     }
   }
-  res[cnt] = 0;
-
-  if( pcnt ) *pcnt = cnt;
-
-  return res;
+  self->qn_hash = 0;
 }
 
 /* ------------------------------------------------------------------------- *
- * queue_count_by_state
+ * queue_event_node  --  bookkeeping data of queued event
+ *
+ * Returns NULL for events that are not in the queue, including
+ * copies of queued events that share the cookie.
  * ------------------------------------------------------------------------- */
 
-int
-queue_count_by_state(unsigned state)
+static
+queue_node_t *
+queue_event_node(const alarm_event_t *event)
 {
-  int cnt = 0;
-
-  for( size_t i = queue_count; i--; )
+  if( queue_hash_size != 0 )
   {
-    alarm_event_t *eve = queue_by_trigger[i];
-
-    if( eve->flags & ALARM_EVENT_DISABLED )
-    {
-      continue;
-    }
+    cookie_t cookie = event->ALARMD_PRIVATE(cookie);
 
-    if( queue_event_get_state(eve) == state )
+    for( queue_node_t *node = *queue_hash_slot(cookie); node; node = node->qn_hash )
     {
-      cnt += 1;
+      if( node->qn_event == event )
+      {
+        return node;
+      }
     }
   }
-
-  return cnt;
+  return 0;
 }
 
 /* ------------------------------------------------------------------------- *
- * queue_count_by_state_and_flag
+ * queue_app_hash  --  hash value for appid string
  * ------------------------------------------------------------------------- */
 
-int
-queue_count_by_state_and_flag   (unsigned state, unsigned flag)
+static
+unsigned
+queue_app_hash(const char *appid)
 {
-  int cnt = 0;
-
-  for( size_t i = queue_count; i--; )
+  unsigned h = 2166136261u;
+  for( ; *appid; ++appid )
   {
-    alarm_event_t *eve = queue_by_trigger[i];
-
-    if( eve->flags & ALARM_EVENT_DISABLED )
-    {
-      continue;
-    }
-
-    if( queue_event_get_state(eve) == state && eve->flags & flag )
-    {
-      cnt += 1;
-    }
+    h ^= (unsigned char)*appid;
+    h *= 16777619u;
   }
-
-  return cnt;
+  return h;
 }
 
 /* ------------------------------------------------------------------------- *
- * queue_cleanup_deleted
+ * queue_app_lookup  --  find appid index entry, optionally create it
  * ------------------------------------------------------------------------- */
 
-void
-queue_cleanup_deleted(void)
+static
+queue_app_t *
+queue_app_lookup(const char *appid, int create)
 {
-  size_t t = 0;
-  size_t c = 0;
+  unsigned     key = queue_app_hash(appid);
+  queue_app_t *app = 0;
 
-  for( size_t i = 0; i < queue_count; ++i )
+  if( queue_app_size != 0 )
   {
-    alarm_event_t *eve = queue_by_trigger[i];
-
-    switch( queue_event_get_state(eve) )
+    for( app = queue_app_tab[key & (queue_app_size - 1)]; app; app = app->qa_hash )
     {
-    case ALARM_STATE_DELETED:
-    case ALARM_STATE_FINALIZED:
-      //log_debug("T:%03Zd\t%ld\n", i, (long)eve->ALARMD_PRIVATE(cookie));
-      queue_event_set_state(eve, ALARM_STATE_FINALIZED);
-      break;
-
-    default:
-      queue_by_trigger[t++] = eve;
-      break;
+      if( app->qa_key == key && !strcmp(app->qa_appid, appid) )
+      {
+        return app;
+      }
     }
   }
 
-  for( size_t i = 0; i < queue_count; ++i )
+  if( !create )
+  {
+    return 0;
+  }
+
+  if( queue_app_count >= queue_app_size )
   {
-    alarm_event_t *eve = queue_by_cookie[i];
-    switch( queue_event_get_state(eve) )
+    /* keep load factor below one */
+    queue_app_t **tab  = queue_app_tab;
+    size_t        size = queue_app_size;
+
+    queue_app_size = size ? (size * 2) : 16;
+    queue_app_tab  = calloc(queue_app_size, sizeof *queue_app_tab);
+
+    for( size_t i = 0; i < size; ++i )
     {
-    case ALARM_STATE_DELETED:
-    case ALARM_STATE_FINALIZED:
-      //log_debug("C:%03Zd\t%ld\n", i, (long)eve->ALARMD_PRIVATE(cookie));
-      alarm_event_delete(eve);
-      break;
+      for( queue_app_t *next; tab[i] != 0; tab[i] = next )
+      {
+        queue_app_t **slot = &queue_app_tab[tab[i]->qa_key & (queue_app_size - 1)];
 
-    default:
-      queue_by_cookie[c++] = eve;
-      break;
+        next = tab[i]->qa_hash;
+        tab[i]->qa_hash = *slot;
+        *slot = tab[i];
+      }
     }
+    free(tab);
   }
 
-  assert( c == t );
+  queue_app_t **slot = &queue_app_tab[key & (queue_app_size - 1)];
+
+  app = calloc(1, sizeof *app);
+  app->qa_key   = key;
+  app->qa_appid = unique_intern(appid);
+  app->qa_head.qn_app_next = app->qa_head.qn_app_prev = &app->qa_head;
+  app->qa_hash  = *slot;
+  *slot = app;
 
-  queue_count = c;
+  queue_app_count += 1;
+  return app;
 }
 
 /* ------------------------------------------------------------------------- *
- * queue_flush_events  --  delete all events without performing actions
+ * queue_app_insert  --  add node to appid index
  * ------------------------------------------------------------------------- */
 
-static void
-queue_flush_events(void)
+static
+void
+queue_app_insert(queue_node_t *self)
 {
-  // delete events directly, without state
-  // transitions and action execution
-  for( size_t i = 0; i < queue_count; ++i )
-  {
-    alarm_event_delete(queue_by_cookie[i]);
-  }
+  queue_app_t  *app  = queue_app_lookup(self->qn_event->alarm_appid ?: "", 1);
+  queue_node_t *head = &app->qa_head;
 
-  // free event tables
-  free(queue_by_cookie);
-  free(queue_by_trigger);
+  self->qn_app      = app;
+  self->qn_app_next = head;
+  self->qn_app_prev = head->qn_app_prev;
+  self->qn_app_prev->qn_app_next = self;
+  self->qn_app_next->qn_app_prev = self;
 
-  // clear related values
-  queue_by_cookie  = 0;
-  queue_by_trigger = 0;
-  queue_count      = 0;
-  queue_alloc      = 0;
+  app->qa_count += 1;
 }
 
-/* ========================================================================= *
- * persistent storage functionality
- * ========================================================================= */
-
 /* ------------------------------------------------------------------------- *
- * queue_save_to_memory
+ * queue_app_remove  --  remove node from appid index
  * ------------------------------------------------------------------------- */
 
 static
-int
-queue_save_to_memory(char **pdata, size_t *psize)
+void
+queue_app_remove(queue_node_t *self)
 {
-  int        err = -1;
-  inifile_t *ini = inifile_create();
-
-  inifile_setfmt(ini, "config", "snooze", "%u", queue_snooze);
+  queue_app_t *app = self->qn_app;
 
-  auto void xu(unsigned           v, const char *s, const char *f, ...);
-  auto void xq(unsigned long long v, const char *s, const char *f, ...);
-  auto void xi(int                v, const char *s, const char *f, ...);
-  auto void xs(const char        *v, const char *s, const char *f, ...);
+  self->qn_app_prev->qn_app_next = self->qn_app_next;
+  self->qn_app_next->qn_app_prev = self->qn_app_prev;
+  self->qn_app_prev = self->qn_app_next = 0;
+  self->qn_app      = 0;
 
-  auto void xu(unsigned v, const char *s, const char *f, ...)
+  if( --app->qa_count == 0 )
   {
-    if( v != 0 )
+    /* last event from the application, drop the entry */
+    queue_app_t **slot = &queue_app_tab[app->qa_key & (queue_app_size - 1)];
+
+    for( ; *slot != 0; slot = &(*slot)->qa_hash )
     {
-      va_list va;
-      char k[64];
-      va_start(va, f);
-      vsnprintf(k, sizeof k, f, va);
-      va_end(va);
-      inifile_setfmt(ini, s, k, "%u", v);
+      if( *slot == app )
+      {
+        *slot = app->qa_hash;
+        break;
+      }
     }
+
+    unique_release(app->qa_appid);
+    free(app);
+    queue_app_count -= 1;
   }
+}
+
+/* ------------------------------------------------------------------------- *
+ * queue_get_events_by_cookie  --  active events in ascending cookie order
+ * ------------------------------------------------------------------------- */
+
+static
+alarm_event_t **
+queue_get_events_by_cookie(void)
+{
+  alarm_event_t **res = calloc(queue_count + 1, sizeof *res);
+  size_t          cnt = 0;
 
-  auto void xq(unsigned long long v, const char *s, const char *f, ...)
+  for( size_t i = 0; i < queue_hash_size; ++i )
   {
-    if( v != 0 )
+    for( queue_node_t *node = queue_hash_tab[i]; node; node = node->qn_hash )
     {
-      va_list va;
-      char k[64];
-      va_start(va, f);
-      vsnprintf(k, sizeof k, f, va);
-      va_end(va);
-      inifile_setfmt(ini, s, k, "%llu", v);
+      res[cnt++] = node->qn_event;
     }
   }
-  auto void xi(int v, const char *s, const char *f, ...)
+  assert( cnt == queue_count );
+
+  auto int cmp(const void *a, const void *b);
+  auto int cmp(const void *a, const void *b)
   {
-    if( v != 0 )
+    return queue_cmp_event_cookie(*(alarm_event_t **)a,
+                                  *(alarm_event_t **)b);
+  }
+  qsort(res, cnt, sizeof *res, cmp);
+
+  res[cnt] = 0;
+  return res;
+}
+
+/* ------------------------------------------------------------------------- *
+ * queue_insert_event
+ * ------------------------------------------------------------------------- */
+
+static
+void
+queue_insert_event(alarm_event_t *eve)
+{
+  queue_node_t *node = queue_node_create(eve);
+
+  assert( queue_get_event(eve->ALARMD_PRIVATE(cookie)) == 0 );
+
+  queue_hash_insert(node);
+  queue_tree_insert(node);
+  queue_app_insert(node);
+  queue_node_link(node);
+  queue_count += 1;
+
+  queue_set_dirty();
+
+  queue_indicate_changed(eve, ALARMD_QUEUE_CHANGE_ADDED);
+}
+
+/* ------------------------------------------------------------------------- *
+ * queue_remove_event
+ * ------------------------------------------------------------------------- */
+
+static
+void
+queue_remove_event(alarm_event_t *eve)
+{
+  queue_node_t *node = queue_event_node(eve);
+
+  queue_indicate_changed(eve, ALARMD_QUEUE_CHANGE_DELETED);
+
+  queue_tree_remove(node);
+  queue_hash_remove(node);
+  queue_app_remove(node);
+  queue_node_delete(node);
+  queue_count -= 1;
+}
+
+/* ========================================================================= *
+ * INDICATION INTERFACE
+ * ========================================================================= */
+
+/* ------------------------------------------------------------------------- *
+ * queue_set_modified_cb
+ * ------------------------------------------------------------------------- */
+
+void queue_set_modified_cb(void (*cb)(void))
+{
+  queue_modified_cb = cb;
+}
+
+/* ------------------------------------------------------------------------- *
+ * queue_set_changed_cb
+ * ------------------------------------------------------------------------- */
+
+void queue_set_changed_cb(void (*cb)(alarm_event_t *, int))
+{
+  queue_changed_cb = cb;
+}
+
+/* ------------------------------------------------------------------------- *
+ * queue_set_wakeup_class_cb
+ * ------------------------------------------------------------------------- */
+
+void queue_set_wakeup_class_cb(int (*cb)(alarm_event_t *))
+{
+  queue_wake_class_cb = cb;
+
+  /* - - - - - - - - - - - - - - - - - - - *
+   * reclassify already queued events
+   * - - - - - - - - - - - - - - - - - - - */
+
+  queue_node_t *head = &queue_state_list[ALARM_STATE_QUEUED];
+
+  if( head->qn_next != 0 )
+  {
+    for( queue_node_t *node = head->qn_next; node != head; node = node->qn_next )
+    {
+      queue_wake_remove(node);
+      queue_wake_sync(node);
+    }
+  }
+}
+
+/* ------------------------------------------------------------------------- *
+ * queue_indicate_modified
+ * ------------------------------------------------------------------------- */
+
+static void queue_indicate_modified(void)
+{
+  if( queue_modified_cb != 0 )
+  {
+    queue_modified_cb();
+  }
+}
+
+/* ------------------------------------------------------------------------- *
+ * queue_indicate_changed
+ * ------------------------------------------------------------------------- */
+
+static void queue_indicate_changed(alarm_event_t *eve, int kind)
+{
+  if( queue_changed_cb != 0 )
+  {
+    queue_changed_cb(eve, kind);
+  }
+}
+
+/* ========================================================================= *
+ * SETTINGS INTERFACE
+ * ========================================================================= */
+
+/* ------------------------------------------------------------------------- *
+ * queue_get_snooze
+ * ------------------------------------------------------------------------- */
+
+unsigned
+queue_get_snooze(void)
+{
+  return queue_snooze;
+}
+
+/* ------------------------------------------------------------------------- *
+ * queue_set_snooze
+ * ------------------------------------------------------------------------- */
+
+void
+queue_set_snooze(unsigned snooze)
+{
+  if( snooze < 1 || snooze > 24*60*60 )
+  {
+    snooze = QUEUE_SNOOZE_DEFAULT;
+  }
+  queue_snooze = snooze;
+  queue_set_dirty();
+}
+
+/* ========================================================================= *
+ * EVENT INTERFACE
+ * ========================================================================= */
+
+/* ------------------------------------------------------------------------- *
+ * queue_event_set_trigger
+ * ------------------------------------------------------------------------- */
+
+void
+queue_event_set_trigger(alarm_event_t *event, time_t trigger)
+{
+  log_info_G("[%ld] SET TRIGGER: %s (T%s)\n",
+             (long)alarm_event_get_cookie(event),
+             ticker_date_format_long(0,0,trigger),
+             ticker_secs_format(0,0,ticker_get_time()-trigger));
+
+  /* - - - - - - - - - - - - - - - - - - - *
+   * reposition the event in trigger order
+   * - - - - - - - - - - - - - - - - - - - */
+
+  queue_node_t *node = queue_event_node(event);
+
+  if( node != 0 )
+  {
+    time_t previous = event->ALARMD_PRIVATE(trigger);
+
+    node->qn_dirty = 1;
+
+    queue_tree_remove(node);
+    event->ALARMD_PRIVATE(trigger) = trigger;
+    queue_tree_insert(node);
+
+    if( node->qn_wake_pos != 0 )
+    {
+      queue_wake_sift(node);
+    }
+
+    if( previous != trigger )
+    {
+      queue_indicate_changed(event, ALARMD_QUEUE_CHANGE_MODIFIED);
+    }
+  }
+  else
+  {
+    event->ALARMD_PRIVATE(trigger) = trigger;
+  }
+
+  queue_set_dirty();
+}
+
+/* ------------------------------------------------------------------------- *
+ * queue_event_get_state
+ * ------------------------------------------------------------------------- */
+
+unsigned
+queue_event_get_state(const alarm_event_t *self)
+{
+  return self->flags >> ALARM_EVENT_CLIENT_BITS;
+}
+
+/* ------------------------------------------------------------------------- *
+ * queue_event_set_state
+ * ------------------------------------------------------------------------- */
+
+void
+queue_event_set_state(alarm_event_t *self, unsigned state)
+{
+  unsigned previous = queue_event_get_state(self);
+  unsigned current  = previous;
+
+  /* - - - - - - - - - - - - - - - - - - - *
+   * do some filtering for state transitions
+   * occuring due to external events
+   * - - - - - - - - - - - - - - - - - - - */
+
+  switch( state )
+  {
+  default:
+    log_debug("UNKNOWN TRANSITION: %s -> %s\n",
+              queue_event_state_names[previous],
+              queue_event_state_names[state]);
+    break;
+
+  case ALARM_STATE_NEW:
+  case ALARM_STATE_WAITCONN:
+  case ALARM_STATE_QUEUED:
+  case ALARM_STATE_MISSED:
+  case ALARM_STATE_POSTPONED:
+
+  case ALARM_STATE_LIMBO:
+  case ALARM_STATE_TRIGGERED:
+  case ALARM_STATE_WAITSYSUI:
+  case ALARM_STATE_SYSUI_REQ:
+
+  case ALARM_STATE_SNOOZED:
+  case ALARM_STATE_SERVED:
+  case ALARM_STATE_RECURRING:
+  case ALARM_STATE_DELETED:
+  case ALARM_STATE_FINALIZED:
+    current = state;
+    break;
+
+  case ALARM_STATE_SYSUI_ACK:
+    switch( previous )
+    {
+    case ALARM_STATE_SYSUI_REQ:
+      current = state;
+      break;
+    }
+    break;
+
+  case ALARM_STATE_SYSUI_RSP:
+    switch( previous )
+    {
+    case ALARM_STATE_SYSUI_REQ:
+    case ALARM_STATE_SYSUI_ACK:
+      current = state;
+      break;
+    }
+    break;
+  }
+
+  if( previous != current )
+  {
+    log_info("[%ld] TRANS: %s -> %s\n",
+             self->ALARMD_PRIVATE(cookie),
+             queue_event_state_names[previous],
+             queue_event_state_names[current]);
+
+    if( (current == ALARM_STATE_NEW) || (current < previous) )
+    {
+      queue_set_dirty();
+    }
+  }
+  else if( current != state )
+  {
+    log_warning("[%ld] TRANS: %s -> %s - BLOCKED\n",
+              self->ALARMD_PRIVATE(cookie),
+              queue_event_state_names[previous],
+              queue_event_state_names[state]);
+  }
+  else if( current == ALARM_STATE_NEW )
+  {
+    log_info("[%ld] TRANS: %s -> %s\n",
+             self->ALARMD_PRIVATE(cookie),
+             queue_event_state_names[previous],
+             queue_event_state_names[current]);
+  }
+
+  self->flags &= ALARM_EVENT_CLIENT_MASK;
+  self->flags |= (current << ALARM_EVENT_CLIENT_BITS);
+
+  /* - - - - - - - - - - - - - - - - - - - *
+   * events that are not in the queue yet
+   * do not have state list linkage
+   * - - - - - - - - - - - - - - - - - - - */
+
+  queue_node_t *node = queue_event_node(self);
+
+  if( node != 0 )
+  {
+    node->qn_dirty = 1;
+  }
+
+  if( node != 0 && node->qn_state != current )
+  {
+    queue_node_unlink(node);
+    node->qn_state = current;
+    queue_node_link(node);
+
+    switch( current )
+    {
+    case ALARM_STATE_DELETED:
+    case ALARM_STATE_FINALIZED:
+      queue_indicate_changed(self, ALARMD_QUEUE_CHANGE_DELETED);
+      break;
+
+    default:
+      queue_indicate_changed(self, ALARMD_QUEUE_CHANGE_MODIFIED);
+      break;
+    }
+  }
+}
+
+/* ------------------------------------------------------------------------- *
+ * queue_event_set_disabled
+ * ------------------------------------------------------------------------- */
+
+void
+queue_event_set_disabled(alarm_event_t *self)
+{
+  queue_node_t *node = queue_event_node(self);
+
+  self->flags |= ALARM_EVENT_DISABLED;
+
+  if( node != 0 )
+  {
+    node->qn_dirty = 1;
+  }
+
+  if( node != 0 && !node->qn_disabled )
+  {
+    node->qn_disabled = 1;
+    queue_state_count[node->qn_state] -= 1;
+    queue_wake_sync(node);
+
+    queue_indicate_changed(self, ALARMD_QUEUE_CHANGE_MODIFIED);
+  }
+}
+
+/* ------------------------------------------------------------------------- *
+ * queue_event_get_recurcache  --  recurrence cache slot for queued event
+ * ------------------------------------------------------------------------- */
+
+recurcache_t **
+queue_event_get_recurcache(alarm_event_t *self)
+{
+  queue_node_t *node = queue_event_node(self);
+
+  return (node != 0) ? &node->qn_recurcache : 0;
+}
+
+/* ------------------------------------------------------------------------- *
+ * queue_event_get_msgcache  --  action message cache slot for queued event
+ * ------------------------------------------------------------------------- */
+
+msgcache_t **
+queue_event_get_msgcache(alarm_event_t *self)
+{
+  queue_node_t *node = queue_event_node(self);
+
+  return (node != 0) ? &node->qn_msgcache : 0;
+}
+
+/* ========================================================================= *
+ * QUEUE INTERFACE
+ * ========================================================================= */
+
+/* ------------------------------------------------------------------------- *
+ * queue_event_intern  --  make repeated event strings share pooled copies
+ *
+ * Strings decoded from dbus or loaded from disk are interned
+ * already, this catches the ones set via plain setters.
+ * ------------------------------------------------------------------------- */
+
+static void
+queue_event_intern(alarm_event_t *self)
+{
+  unique_strset(&self->sound,       self->sound);
+  unique_strset(&self->icon,        self->icon);
+  unique_strset(&self->alarm_appid, self->alarm_appid);
+  unique_strset(&self->alarm_tz,    self->alarm_tz);
+
+  for( size_t i = 0; i < self->action_cnt; ++i )
+  {
+    alarm_action_t *act = &self->action_tab[i];
+
+    unique_strset(&act->dbus_interface, act->dbus_interface);
+    unique_strset(&act->dbus_service,   act->dbus_service);
+    unique_strset(&act->dbus_path,      act->dbus_path);
+    unique_strset(&act->dbus_name,      act->dbus_name);
+  }
+}
+
+/* ------------------------------------------------------------------------- *
+ * queue_add_event
+ * ------------------------------------------------------------------------- */
+
+cookie_t
+queue_add_event(alarm_event_t *event)
+{
+  if( event->ALARMD_PRIVATE(cookie) == 0 )
+  {
+    event->ALARMD_PRIVATE(cookie) = ++queue_cookie;
+  }
+  else if( queue_cookie < event->ALARMD_PRIVATE(cookie) )
+  {
+    queue_cookie = event->ALARMD_PRIVATE(cookie);
+  }
+
+  if( unique_pool_enabled() )
+  {
+    queue_event_intern(event);
+  }
+
+  queue_insert_event(event);
+
+  return event->ALARMD_PRIVATE(cookie);
+}
+
+/* ------------------------------------------------------------------------- *
+ * queue_get_event
+ * ------------------------------------------------------------------------- */
+
+alarm_event_t *
+queue_get_event(cookie_t cookie)
+{
+  if( queue_hash_size != 0 )
+  {
+    for( queue_node_t *node = *queue_hash_slot(cookie); node; node = node->qn_hash )
+    {
+      alarm_event_t *event = node->qn_event;
+
+      if( queue_cmp_cookie(event->ALARMD_PRIVATE(cookie), cookie) == 0 )
+      {
+        return event;
+      }
+    }
+  }
+  return 0;
+}
+
+/* ------------------------------------------------------------------------- *
+ * queue_del_event
+ * ------------------------------------------------------------------------- */
+
+int
+queue_del_event(cookie_t cookie)
+{
+  int            error = -1;
+  alarm_event_t *event = queue_get_event(cookie);
+
+  if( event != 0 )
+  {
+    error = 0;
+    queue_event_set_state(event, ALARM_STATE_DELETED);
+  }
+  return (error != -1);
+}
+
+/* ------------------------------------------------------------------------- *
+ * queue_query_events_page  --  query events in bounded chunks
+ *
+ * Like queue_query_events(), but returns at most limit cookies
+ * (zero = no limit) that come after position (*ptrigger, *pcookie)
+ * in trigger order. Zero *pcookie starts from the beginning.
+ *
+ * On return the position is updated to the last reported event
+ * if the limit was reached, or *pcookie is set to zero if there
+ * are no more events to report.
+ * ------------------------------------------------------------------------- */
+
+cookie_t *
+queue_query_events_page(int *pcnt, time_t lo, time_t hi, unsigned mask, unsigned flag, const char *app,
+                        size_t limit, time_t *ptrigger, cookie_t *pcookie)
+{
+  cookie_t *res = 0;
+  size_t    cnt = 0;
+  time_t    pos = (pcookie && *pcookie) ? *ptrigger : INT_MIN;
+  cookie_t  ref = (pcookie && *pcookie) ? *pcookie  : 0;
+
+  if( hi <= 0 )
+  {
+    hi = INT_MAX;
+  }
+  if( lo <= 0 )
+  {
+    lo = INT_MIN;
+  }
+  int paged = (limit != 0 && limit < queue_count);
+
+  if( !paged )
+  {
+    limit = queue_count;
+  }
+
+  auto int match(const alarm_event_t *eve);
+  auto int match(const alarm_event_t *eve)
+  {
+    /* Because alarms are no longer removed from queue
+     * immediately after "del_event" method call, we
+     * need to filter them out from client query results */
+
+    if( queue_event_get_state(eve) == ALARM_STATE_DELETED )
+    {
+      return 0;
+    }
+
+    if( eve->ALARMD_PRIVATE(trigger) < lo ) return 0;
+    if( eve->ALARMD_PRIVATE(trigger) > hi ) return 0;
+
+    /* skip events reported on previous pages */
+    if( eve->ALARMD_PRIVATE(trigger) < pos ) return 0;
+    if( eve->ALARMD_PRIVATE(trigger) == pos &&
+        eve->ALARMD_PRIVATE(cookie) <= ref ) return 0;
+
+    return (eve->flags & mask) == flag;
+  }
+
+  queue_app_t *ent = 0;
+
+  if( !xisempty(app) && (ent = queue_app_lookup(app, 0)) == 0 )
+  {
+    /* - - - - - - - - - - - - - - - - - - - *
+     * no events from the application
+     * - - - - - - - - - - - - - - - - - - - */
+
+    res = calloc(1, sizeof *res);
+  }
+  else if( ent != 0 && ent->qa_count * QUEUE_APP_SCAN_RATIO < queue_count )
+  {
+    /* - - - - - - - - - - - - - - - - - - - *
+     * scan only the events of the application
+     * and report them in trigger order
+     * - - - - - - - - - - - - - - - - - - - */
+
+    queue_node_t   *head = &ent->qa_head;
+    alarm_event_t **tmp  = calloc(ent->qa_count + 1, sizeof *tmp);
+
+    for( queue_node_t *node = head->qn_app_next; node != head;
+         node = node->qn_app_next )
+    {
+      if( match(node->qn_event) )
+      {
+        tmp[cnt++] = node->qn_event;
+      }
+    }
+
+    auto int cmp(const void *a, const void *b);
+    auto int cmp(const void *a, const void *b)
+    {
+      return queue_cmp_event_trigger(*(alarm_event_t **)a,
+                                     *(alarm_event_t **)b);
+    }
+    qsort(tmp, cnt, sizeof *tmp, cmp);
+
+    if( cnt > limit )
+    {
+      cnt = limit;
+    }
+
+    res = calloc(cnt + 1, sizeof *res);
+
+    for( size_t i = 0; i < cnt; ++i )
+    {
+      res[i] = tmp[i]->ALARMD_PRIVATE(cookie);
+    }
+    free(tmp);
+  }
+  else
+  {
+    /* - - - - - - - - - - - - - - - - - - - *
+     * walk the trigger tree from the start
+     * of the time window to its end; used
+     * also when the application owns a large
+     * share of the queue and sorting its
+     * events would cost more than skipping
+     * the others
+     * - - - - - - - - - - - - - - - - - - - */
+
+    res = calloc(limit + 1, sizeof *res);
+
+    for( queue_node_t *node = queue_tree_seek(lo > pos ? lo : pos);
+         node != 0 && cnt < limit; node = queue_tree_next(node) )
+    {
+      alarm_event_t *eve = node->qn_event;
+
+      if( eve->ALARMD_PRIVATE(trigger) > hi ) break;
+
+      if( ent != 0 && node->qn_app != ent ) continue;
+
+      if( match(eve) )
+      {
+        res[cnt++] = eve->ALARMD_PRIVATE(cookie);
+      }
+    }
+  }
+  res[cnt] = 0;
+
+  if( pcookie != 0 )
+  {
+    if( paged && cnt == limit )
+    {
+      alarm_event_t *eve = queue_get_event(res[cnt-1]);
+      *ptrigger = eve->ALARMD_PRIVATE(trigger);
+      *pcookie  = eve->ALARMD_PRIVATE(cookie);
+    }
+    else
+    {
+      *ptrigger = 0;
+      *pcookie  = 0;
+    }
+  }
+
+  if( pcnt ) *pcnt = cnt;
+
+  return res;
+}
+
+/* ------------------------------------------------------------------------- *
+ * queue_query_events
+ * ------------------------------------------------------------------------- */
+
+cookie_t *
+queue_query_events(int *pcnt, time_t lo, time_t hi, unsigned mask, unsigned flag, const char *app)
+{
+  return queue_query_events_page(pcnt, lo, hi, mask, flag, app, 0, 0, 0);
+}
+
+/* ------------------------------------------------------------------------- *
+ * queue_query_by_state
+ * ------------------------------------------------------------------------- */
+
+cookie_t *
+queue_query_by_state(int *pcnt, unsigned state)
+{
+  queue_node_t   *head = &queue_state_list[state];
+  size_t          cnt  = 0;
+  alarm_event_t **tmp = calloc(queue_state_count[state]+1, sizeof *tmp);
+  cookie_t       *res = calloc(queue_state_count[state]+1, sizeof *res);
+
+  /* - - - - - - - - - - - - - - - - - - - *
+   * collect enabled events from state list
+   * - - - - - - - - - - - - - - - - - - - */
+
+  if( head->qn_next != 0 )
+  {
+    for( queue_node_t *node = head->qn_next; node != head; node = node->qn_next )
+    {
+      if( !node->qn_disabled )
+      {
+        tmp[cnt++] = node->qn_event;
+      }
+    }
+  }
+  assert( cnt == queue_state_count[state] );
+
+  /* - - - - - - - - - - - - - - - - - - - *
+   * report in trigger order, first to
+   * trigger first, like the queue scan
+   * used to do
+   * - - - - - - - - - - - - - - - - - - - */
+
+  auto int cmp(const void *a, const void *b);
+  auto int cmp(const void *a, const void *b)
+  {
+    return queue_cmp_event_trigger(*(alarm_event_t **)a,
+                                   *(alarm_event_t **)b);
+  }
+  qsort(tmp, cnt, sizeof *tmp, cmp);
+
+  for( size_t i = 0; i < cnt; ++i )
+  {
+    res[i] = tmp[i]->ALARMD_PRIVATE(cookie);
+  }
+  res[cnt] = 0;
+
+  if( pcnt ) *pcnt = cnt;
+
+  free(tmp);
+  return res;
+}
+
+/* ------------------------------------------------------------------------- *
+ * queue_count_by_state
+ * ------------------------------------------------------------------------- */
+
+int
+queue_count_by_state(unsigned state)
+{
+  return queue_state_count[state];
+}
+
+/* ------------------------------------------------------------------------- *
+ * queue_count_by_state_and_flag
+ * ------------------------------------------------------------------------- */
+
+int
+queue_count_by_state_and_flag   (unsigned state, unsigned flag)
+{
+  queue_node_t *head = &queue_state_list[state];
+  int           cnt  = 0;
+
+  if( head->qn_next != 0 )
+  {
+    for( queue_node_t *node = head->qn_next; node != head; node = node->qn_next )
+    {
+      if( !node->qn_disabled && (node->qn_event->flags & flag) )
+      {
+        cnt += 1;
+      }
+    }
+  }
+
+  return cnt;
+}
+
+/* ------------------------------------------------------------------------- *
+ * queue_get_next_queued  --  first to trigger of queued events in class
+ * ------------------------------------------------------------------------- */
+
+alarm_event_t *
+queue_get_next_queued(int cls)
+{
+  if( queue_wake_count[cls] != 0 )
+  {
+    return queue_wake_heap[cls][1]->qn_event;
+  }
+  return 0;
+}
+
+/* ------------------------------------------------------------------------- *
+ * queue_count_queued_icons  --  queued events with statusbar icon flag
+ * ------------------------------------------------------------------------- */
+
+int
+queue_count_queued_icons(void)
+{
+  return queue_wake_icons;
+}
+
+/* ------------------------------------------------------------------------- *
+ * queue_cleanup_deleted
+ * ------------------------------------------------------------------------- */
+
+void
+queue_cleanup_deleted(void)
+{
+  queue_node_t *head;
+
+  head = &queue_state_list[ALARM_STATE_DELETED];
+  while( head->qn_next != 0 && head->qn_next != head )
+  {
+    queue_event_set_state(head->qn_next->qn_event, ALARM_STATE_FINALIZED);
+  }
+
+  head = &queue_state_list[ALARM_STATE_FINALIZED];
+  while( head->qn_next != 0 && head->qn_next != head )
+  {
+    alarm_event_t *eve = head->qn_next->qn_event;
+    //log_debug("F:\t%ld\n", (long)eve->ALARMD_PRIVATE(cookie));
+    queue_remove_event(eve);
+    alarm_event_delete(eve);
+  }
+}
+
+/* ------------------------------------------------------------------------- *
+ * queue_flush_events  --  delete all events without performing actions
+ * ------------------------------------------------------------------------- */
+
+static void
+queue_flush_events(void)
+{
+  // delete events directly, without state
+  // transitions and action execution
+  while( queue_tree_root != 0 )
+  {
+    alarm_event_t *eve = queue_tree_root->qn_event;
+    queue_remove_event(eve);
+    alarm_event_delete(eve);
+  }
+
+  // free event tables
+  free(queue_hash_tab);
+  free(queue_app_tab);
+
+  // clear related values
+  queue_hash_tab  = 0;
+  queue_hash_size = 0;
+  queue_app_tab   = 0;
+  queue_app_size  = 0;
+  queue_count     = 0;
+}
+
+/* ========================================================================= *
+ * persistent storage functionality
+ * ========================================================================= */
+
+/* ------------------------------------------------------------------------- *
+ * The queue file is a snapshot of the whole queue. Changes made after
+ * the snapshot was written are appended to a journal file, one section
+ * per added / modified / deleted event. When the journal grows too
+ * large, the queue file is rewritten and the journal started afresh.
+ *
+ * The snapshot and the journal are paired via the "journal" value in
+ * the config section of the queue file and the "id" value in the
+ * "journal" section at the start of the journal file. Journals that
+ * do not match the queue file are ignored on load.
+ *
+ * What has been saved is tracked via hashes of the event sections,
+ * so that changes made directly to event data get noticed too.
+ * ------------------------------------------------------------------------- */
+
+typedef struct
+{
+  cookie_t qs_cookie;
+  uint64_t qs_hash;
+} queue_saved_t;
+
+/* id of the current queue file / journal pair */
+static unsigned        queue_journal_id    = 0;
+
+/* bytes written to journal, zero = create a new one */
+static size_t          queue_journal_size  = 0;
+
+/* size of the queue file the journal is applied to */
+static size_t          queue_journal_base  = 0;
+
+/* saved event sections, sorted by cookie */
+static queue_saved_t  *queue_saved_tab     = 0;
+static size_t          queue_saved_cnt     = 0;
+static uint64_t        queue_saved_config  = 0;
+
+/* the above reflect what is on disk: journaling possible */
+static int             queue_saved_valid   = 0;
+
+/* ------------------------------------------------------------------------- *
+ * queue_savebuf_t  --  growable output buffer for queue_save_to_memory()
+ *
+ * The database is written directly in the format produced by
+ * inifile_save_to_memory(), without building an inifile_t first.
+ * Section headers are emitted lazily so that sections without
+ * any values are left out just like the inifile code does.
+ * ------------------------------------------------------------------------- */
+
+typedef struct
+{
+  char       *sb_data;
+  size_t      sb_size;
+  size_t      sb_used;
+  int         sb_error;
+
+  /* section header to emit before the next value */
+  const char *sb_sec;
+  int         sb_open;
+} queue_savebuf_t;
+
+/* ------------------------------------------------------------------------- *
+ * queue_savebuf_reserve
+ * ------------------------------------------------------------------------- */
+
+static int
+queue_savebuf_reserve(queue_savebuf_t *self, size_t n)
+{
+  if( self->sb_error )
+  {
+    return -1;
+  }
+
+  if( self->sb_size - self->sb_used < n + 1 )
+  {
+    size_t size = self->sb_size ? self->sb_size : 4096;
+    char  *data = 0;
+
+    while( size - self->sb_used < n + 1 )
+    {
+      size *= 2;
+    }
+
+    if( (data = realloc(self->sb_data, size)) == 0 )
+    {
+      self->sb_error = 1;
+      return -1;
+    }
+    self->sb_data = data;
+    self->sb_size = size;
+  }
+  return 0;
+}
+
+/* ------------------------------------------------------------------------- *
+ * queue_savebuf_put
+ * ------------------------------------------------------------------------- */
+
+static void
+queue_savebuf_put(queue_savebuf_t *self, const char *s, size_t n)
+{
+  if( queue_savebuf_reserve(self, n) == 0 )
+  {
+    memcpy(self->sb_data + self->sb_used, s, n);
+    self->sb_used += n;
+    self->sb_data[self->sb_used] = 0;
+  }
+}
+
+/* ------------------------------------------------------------------------- *
+ * queue_savebuf_puts
+ * ------------------------------------------------------------------------- */
+
+static void
+queue_savebuf_puts(queue_savebuf_t *self, const char *s)
+{
+  queue_savebuf_put(self, s, strlen(s));
+}
+
+/* ------------------------------------------------------------------------- *
+ * queue_savebuf_putesc  --  string escaped like escape_putline() does
+ * ------------------------------------------------------------------------- */
+
+static void
+queue_savebuf_putesc(queue_savebuf_t *self, const char *s)
+{
+  static const char hex[] = "0123456789abcdef";
+
+  const char *beg = s;
+
+  for( ; *s; ++s )
+  {
+    unsigned char c = *s;
+    char          esc[4];
+
+    if( c >= 32 && c <= 126 && c != '\\' )
+    {
+      continue;
+    }
+
+    queue_savebuf_put(self, beg, s - beg), beg = s + 1;
+
+    switch( c )
+    {
+    case '\\': queue_savebuf_put(self, "\\\\", 2); break;
+    case '\b': queue_savebuf_put(self, "\\b",  2); break;
+    case '\n': queue_savebuf_put(self, "\\n",  2); break;
+    case '\r': queue_savebuf_put(self, "\\r",  2); break;
+    case '\t': queue_savebuf_put(self, "\\t",  2); break;
+    default:
+      esc[0] = '\\';
+      esc[1] = 'x';
+      esc[2] = hex[(c >> 4) & 15];
+      esc[3] = hex[(c >> 0) & 15];
+      queue_savebuf_put(self, esc, 4);
+      break;
+    }
+  }
+  queue_savebuf_put(self, beg, s - beg);
+}
+
+/* ------------------------------------------------------------------------- *
+ * queue_savebuf_putull  --  unsigned decimal number
+ * ------------------------------------------------------------------------- */
+
+static void
+queue_savebuf_putull(queue_savebuf_t *self, unsigned long long v)
+{
+  char  tmp[32];
+  char *pos = tmp + sizeof tmp;
+
+  do
+  {
+    *--pos = '0' + (v % 10);
+  } while( (v /= 10) != 0 );
+
+  queue_savebuf_put(self, pos, tmp + sizeof tmp - pos);
+}
+
+/* ------------------------------------------------------------------------- *
+ * queue_savebuf_putll  --  signed decimal number
+ * ------------------------------------------------------------------------- */
+
+static void
+queue_savebuf_putll(queue_savebuf_t *self, long long v)
+{
+  if( v < 0 )
+  {
+    queue_savebuf_put(self, "-", 1);
+    queue_savebuf_putull(self, -(unsigned long long)v);
+  }
+  else
+  {
+    queue_savebuf_putull(self, v);
+  }
+}
+
+/* ------------------------------------------------------------------------- *
+ * queue_savebuf_trunc  --  discard data written after given offset
+ * ------------------------------------------------------------------------- */
+
+static void
+queue_savebuf_trunc(queue_savebuf_t *self, size_t pos)
+{
+  if( pos < self->sb_used )
+  {
+    self->sb_used = pos;
+    self->sb_data[pos] = 0;
+  }
+}
+
+/* ------------------------------------------------------------------------- *
+ * queue_savebuf_begin_sec  --  start a section, header is written lazily
+ * ------------------------------------------------------------------------- */
+
+static void
+queue_savebuf_begin_sec(queue_savebuf_t *self, const char *sec)
+{
+  self->sb_sec  = sec;
+  self->sb_open = 0;
+}
+
+/* ------------------------------------------------------------------------- *
+ * queue_savebuf_open_sec  --  write section header if not done yet
+ * ------------------------------------------------------------------------- */
+
+static void
+queue_savebuf_open_sec(queue_savebuf_t *self)
+{
+  if( !self->sb_open )
+  {
+    char bra = BRA, ket = KET;
+
+    queue_savebuf_put(self, &bra, 1);
+    queue_savebuf_putesc(self, self->sb_sec);
+    queue_savebuf_put(self, &ket, 1);
+    queue_savebuf_put(self, "\n", 1);
+    self->sb_open = 1;
+  }
+}
+
+/* ------------------------------------------------------------------------- *
+ * queue_savebuf_end_sec  --  terminate section if anything was written
+ * ------------------------------------------------------------------------- */
+
+static void
+queue_savebuf_end_sec(queue_savebuf_t *self)
+{
+  if( self->sb_open )
+  {
+    queue_savebuf_put(self, "\n", 1);
+  }
+  self->sb_sec  = 0;
+  self->sb_open = 0;
+}
+
+/* ------------------------------------------------------------------------- *
+ * queue_savebuf_key  --  start "[prefix<index>.]key: " value line
+ * ------------------------------------------------------------------------- */
+
+static void
+queue_savebuf_key(queue_savebuf_t *self, const char *pfx, size_t idx,
+                  const char *key)
+{
+  static const char sep[2] = { SEP, ' ' };
+
+  queue_savebuf_open_sec(self);
+
+  if( pfx != 0 )
+  {
+    queue_savebuf_puts(self, pfx);
+    queue_savebuf_putull(self, idx);
+    queue_savebuf_put(self, ".", 1);
+  }
+  queue_savebuf_puts(self, key);
+  queue_savebuf_put(self, sep, sizeof sep);
+}
+
+/* ------------------------------------------------------------------------- *
+ * queue_save_hash  --  FNV-1a hash of saved section data
+ * ------------------------------------------------------------------------- */
+
+static uint64_t
+queue_save_hash(const char *data, size_t size)
+{
+  uint64_t h = 0xcbf29ce484222325ull;
+
+  for( size_t i = 0; i < size; ++i )
+  {
+    h ^= (unsigned char)data[i];
+    h *= 0x100000001b3ull;
+  }
+  return h;
+}
+
+/* ------------------------------------------------------------------------- *
+ * queue_save_config  --  write the config section
+ * ------------------------------------------------------------------------- */
+
+static void
+queue_save_config(queue_savebuf_t *buf, unsigned journal)
+{
+  queue_savebuf_begin_sec(buf, "config");
+
+  queue_savebuf_key(buf, 0, 0, "snooze");
+  queue_savebuf_putull(buf, queue_snooze);
+  queue_savebuf_put(buf, "\n", 1);
+
+  if( journal != 0 )
+  {
+    queue_savebuf_key(buf, 0, 0, "journal");
+    queue_savebuf_putull(buf, journal);
+    queue_savebuf_put(buf, "\n", 1);
+  }
+
+  queue_savebuf_end_sec(buf);
+}
+
+/* ------------------------------------------------------------------------- *
+ * queue_save_event  --  write "#cookie" section for one event
+ * ------------------------------------------------------------------------- */
+
+static void
+queue_save_event(queue_savebuf_t *buf, const alarm_event_t *e)
+{
+  auto void xu(unsigned           v, const char *p, size_t i, const char *k);
+  auto void xq(unsigned long long v, const char *p, size_t i, const char *k);
+  auto void xi(int                v, const char *p, size_t i, const char *k);
+  auto void xs(const char        *v, const char *p, size_t i, const char *k);
+
+  auto void xu(unsigned v, const char *p, size_t i, const char *k)
+  {
+    if( v != 0 )
     {
-      va_list va;
-      char k[64];
-      va_start(va, f);
-      vsnprintf(k, sizeof k, f, va);
-      va_end(va);
-      inifile_setfmt(ini, s, k, "%d", v);
+      queue_savebuf_key(buf, p, i, k);
+      queue_savebuf_putull(buf, v);
+      queue_savebuf_put(buf, "\n", 1);
     }
   }
-  auto void xs(const char *v, const char *s, const char *f, ...)
+
+  auto void xq(unsigned long long v, const char *p, size_t i, const char *k)
   {
-    if( v && *v )
+    if( v != 0 )
     {
-      va_list va;
-      char k[64];
-      va_start(va, f);
-      vsnprintf(k, sizeof k, f, va);
-      va_end(va);
-      inifile_setfmt(ini, s, k, "%s", v);
+      queue_savebuf_key(buf, p, i, k);
+      queue_savebuf_putull(buf, v);
+      queue_savebuf_put(buf, "\n", 1);
     }
   }
-
-  for( size_t i = 0; i < queue_count; ++i )
+  auto void xi(int v, const char *p, size_t i, const char *k)
   {
-    alarm_event_t *e = queue_by_cookie[i];
+    if( v != 0 )
+    {
+      queue_savebuf_key(buf, p, i, k);
+      queue_savebuf_putll(buf, v);
+      queue_savebuf_put(buf, "\n", 1);
+    }
+  }
+  auto void xs(const char *v, const char *p, size_t i, const char *k)
+  {
+    if( v && *v )
+    {
+      queue_savebuf_key(buf, p, i, k);
+      queue_savebuf_putesc(buf, v);
+      queue_savebuf_put(buf, "\n", 1);
+    }
+  }
 
-    char sec[32];
+  char sec[32];
 
-    snprintf(sec, sizeof sec, "#%08x", (unsigned)e->ALARMD_PRIVATE(cookie));
+  snprintf(sec, sizeof sec, "#%08x", (unsigned)e->ALARMD_PRIVATE(cookie));
+  queue_savebuf_begin_sec(buf, sec);
 
-#define Xu2(n,v) xu(e->v, sec, #n)
-#define Xi2(n,v) xi(e->v, sec, #n)
-#define Xs2(n,v) xs(e->v, sec, #n)
+#define Xu2(n,v) xu(e->v, 0, 0, #n)
+#define Xi2(n,v) xi(e->v, 0, 0, #n)
+#define Xs2(n,v) xs(e->v, 0, 0, #n)
 
 #define Xu(v) Xu2(v,v)
 #define Xi(v) Xi2(v,v)
 #define Xs(v) Xs2(v,v)
 
-    Xu2(cookie,  ALARMD_PRIVATE(cookie));
-    Xi2(trigger, ALARMD_PRIVATE(trigger));
+  Xu2(cookie,  ALARMD_PRIVATE(cookie));
+  Xi2(trigger, ALARMD_PRIVATE(trigger));
+
+  Xs(title);
+  Xs(message);
+  Xs(sound);
+  Xs(icon);
+  Xu(flags);
+
+  Xs(alarm_appid);
+
+  Xi(alarm_time);
+
+  Xi(alarm_tm.tm_year);
+  Xi(alarm_tm.tm_mon);
+  Xi(alarm_tm.tm_mday);
+  Xi(alarm_tm.tm_hour);
+  Xi(alarm_tm.tm_min);
+  Xi(alarm_tm.tm_sec);
+  Xi(alarm_tm.tm_wday);
+  Xi(alarm_tm.tm_yday);
+  Xi(alarm_tm.tm_isdst);
+
+  Xs(alarm_tz);
+
+  Xi(recur_secs);
+  Xi(recur_count);
+
+  Xi(snooze_secs);
+  Xi(snooze_total);
+
+  Xu(action_cnt);
+  Xu(recurrence_cnt);
+  Xu(attr_cnt);
+
+#undef Xu
+#undef Xi
+#undef Xs
+
+#undef Xu2
+#undef Xi2
+#undef Xs2
+
+  for( size_t i = 0; i < e->action_cnt; ++i )
+  {
+    alarm_action_t  *a= &e->action_tab[i];
+
+#define Xu(v) xu(a->v, "action", i, #v)
+#define Xs(v) xs(a->v, "action", i, #v)
 
-    Xs(title);
-    Xs(message);
-    Xs(sound);
-    Xs(icon);
     Xu(flags);
+    Xs(label);
+    Xs(exec_command);
+    Xs(dbus_interface);
+    Xs(dbus_service);
+    Xs(dbus_path);
+    Xs(dbus_name);
+    Xs(dbus_args);
+
+#undef Xu
+#undef Xs
+  }
+
+  for( size_t i = 0; i < e->recurrence_cnt; ++i )
+  {
+    alarm_recur_t  *r= &e->recurrence_tab[i];
+
+#define Xu(v) xu(r->v, "recurrence_tab", i, #v)
+#define Xq(v) xq(r->v, "recurrence_tab", i, #v)
+
+    Xq(mask_min);
+    Xu(mask_hour);
+    Xu(mask_mday);
+    Xu(mask_wday);
+    Xu(mask_mon);
+    Xu(special);
+
+#undef Xu
+#undef Xq
+  }
+
+  for( size_t i = 0; i < e->attr_cnt; ++i )
+  {
+    alarm_attr_t  *a= e->attr_tab[i];
+
+#define Xi(v) xi(a->v, "attr", i, #v)
+#define Xs(v) xs(a->v, "attr", i, #v)
+
+    Xs(attr_name);
+    Xi(attr_type);
+    switch( a->attr_type )
+    {
+    case ALARM_ATTR_NULL:
+      break;
+    case ALARM_ATTR_INT:
+      Xi(attr_data.ival);
+      break;
+    case ALARM_ATTR_TIME:
+      Xi(attr_data.tval);
+      break;
+    case ALARM_ATTR_STRING:
+      Xs(attr_data.sval);
+      break;
+    }
+#undef Xi
+#undef Xs
+  }
+
+  queue_savebuf_end_sec(buf);
+}
+
+/* ------------------------------------------------------------------------- *
+ * queue_save_finish  --  hand over buffer contents, check for errors
+ * ------------------------------------------------------------------------- */
+
+static int
+queue_save_finish(queue_savebuf_t *buf, char **pdata, size_t *psize)
+{
+  int err = -1;
+
+  if( queue_savebuf_reserve(buf, 0) == -1 )
+  {
+    log_warning("%s: write: %s\n", "<ram>", strerror(ENOMEM));
+    free(buf->sb_data), buf->sb_data = 0, buf->sb_used = 0;
+  }
+  else
+  {
+    err = 0;
+  }
+
+  *pdata = buf->sb_data;
+  *psize = buf->sb_used;
+
+  return err;
+}
+
+/* ------------------------------------------------------------------------- *
+ * queue_save_to_memory  --  generate full queue file contents
+ *
+ * The per event section hashes are stored in the given table
+ * (allocated by the caller for queue_count entries).
+ * ------------------------------------------------------------------------- */
+
+static
+int
+queue_save_to_memory(char **pdata, size_t *psize, queue_saved_t *tab)
+{
+  queue_savebuf_t buf = { .sb_data = 0, };
+  alarm_event_t **vec = queue_get_events_by_cookie();
+
+  queue_save_config(&buf, queue_journal_id);
+
+  for( size_t i = 0; vec[i] != 0; ++i )
+  {
+    size_t pos = buf.sb_used;
+
+    queue_save_event(&buf, vec[i]);
+
+    tab[i].qs_cookie = vec[i]->ALARMD_PRIVATE(cookie);
+    tab[i].qs_hash   = queue_save_hash(buf.sb_data + pos, buf.sb_used - pos);
+  }
+  free(vec);
+
+  return queue_save_finish(&buf, pdata, psize);
+}
+
+/* ------------------------------------------------------------------------- *
+ * queue_save_config_hash  --  hash of config section as journaled
+ * ------------------------------------------------------------------------- */
+
+static uint64_t
+queue_save_config_hash(void)
+{
+  queue_savebuf_t buf = { .sb_data = 0, };
+
+  queue_save_config(&buf, 0);
+
+  uint64_t res = queue_save_hash(buf.sb_data, buf.sb_used);
+
+  free(buf.sb_data);
+  return res;
+}
+
+/* ------------------------------------------------------------------------- *
+ * queue_saved_cmp_cb  --  sort saved sections by cookie
+ * ------------------------------------------------------------------------- */
+
+static int
+queue_saved_cmp_cb(const void *a, const void *b)
+{
+  const queue_saved_t *x = a;
+  const queue_saved_t *y = b;
+
+  return (x->qs_cookie > y->qs_cookie) - (x->qs_cookie < y->qs_cookie);
+}
 
-    Xs(alarm_appid);
+/* ------------------------------------------------------------------------- *
+ * queue_saved_set  --  update bookkeeping of what is on disk
+ * ------------------------------------------------------------------------- */
+
+static void
+queue_saved_set(queue_saved_t *tab, size_t cnt, uint64_t config)
+{
+  free(queue_saved_tab);
+
+  queue_saved_tab    = tab;
+  queue_saved_cnt    = cnt;
+  queue_saved_config = config;
+  queue_saved_valid  = 1;
+}
+
+/* ------------------------------------------------------------------------- *
+ * queue_saved_clear
+ * ------------------------------------------------------------------------- */
+
+static void
+queue_saved_clear(void)
+{
+  free(queue_saved_tab);
+
+  queue_saved_tab    = 0;
+  queue_saved_cnt    = 0;
+  queue_saved_config = 0;
+  queue_saved_valid  = 0;
+}
+
+/* ------------------------------------------------------------------------- *
+ * queue_saved_mark_clean  --  all queued events are now as saved
+ * ------------------------------------------------------------------------- */
+
+static void
+queue_saved_mark_clean(void)
+{
+  for( queue_node_t *node = queue_tree_first(queue_tree_root); node;
+       node = queue_tree_next(node) )
+  {
+    node->qn_dirty = 0;
+  }
+}
+
+/* ------------------------------------------------------------------------- *
+ * queue_save_journal_header  --  "journal" section starting new journal
+ * ------------------------------------------------------------------------- */
+
+static void
+queue_save_journal_header(queue_savebuf_t *buf)
+{
+  queue_savebuf_begin_sec(buf, "journal");
+  queue_savebuf_key(buf, 0, 0, "id");
+  queue_savebuf_putull(buf, queue_journal_id);
+  queue_savebuf_put(buf, "\n", 1);
+  queue_savebuf_end_sec(buf);
+}
+
+/* ------------------------------------------------------------------------- *
+ * queue_save_journal  --  append changed sections to journal
+ *
+ * Only events marked dirty since the previous save are formatted
+ * and hashed, the saved hash is reused for the rest.
+ *
+ * Returns 1 if something was written, 0 if there were no changes
+ * and -1 on failure.
+ * ------------------------------------------------------------------------- */
+
+static
+int
+queue_save_journal(void)
+{
+  int              res  = -1;
+  queue_savebuf_t  buf  = { .sb_data = 0, };
+  alarm_event_t  **vec  = queue_get_events_by_cookie();
+  queue_saved_t   *tab  = calloc(queue_count + 1, sizeof *tab);
+  size_t           cnt  = 0;
+  size_t           old  = 0;
+  size_t           hdr  = 0;
+  uint64_t         cfg  = 0;
+  char            *data = 0;
+  size_t           size = 0;
+
+  auto void removed(cookie_t cookie);
+
+  auto void removed(cookie_t cookie)
+  {
+    char sec[32];
+
+    snprintf(sec, sizeof sec, "#%08x", (unsigned)cookie);
+    queue_savebuf_begin_sec(&buf, sec);
+    queue_savebuf_open_sec(&buf);
+    queue_savebuf_end_sec(&buf);
+  }
+
+  /* - - - - - - - - - - - - - - - - - - - *
+   * new journals start with id matching
+   * the current queue file
+   * - - - - - - - - - - - - - - - - - - - */
+
+  if( queue_journal_size == 0 )
+  {
+    queue_save_journal_header(&buf);
+  }
+  hdr = buf.sb_used;
+
+  /* - - - - - - - - - - - - - - - - - - - *
+   * config section
+   * - - - - - - - - - - - - - - - - - - - */
+
+  queue_save_config(&buf, 0);
+  cfg = queue_save_hash(buf.sb_data + hdr, buf.sb_used - hdr);
+
+  if( cfg == queue_saved_config )
+  {
+    queue_savebuf_trunc(&buf, hdr);
+  }
+
+  /* - - - - - - - - - - - - - - - - - - - *
+   * merge current events with the saved
+   * ones, both are sorted by cookie
+   * - - - - - - - - - - - - - - - - - - - */
+
+  for( size_t i = 0; vec[i] != 0; ++i )
+  {
+    cookie_t cookie = vec[i]->ALARMD_PRIVATE(cookie);
+    size_t   pos    = buf.sb_used;
+    int      known  = 0;
+    uint64_t hash   = 0;
+
+    for( ; old < queue_saved_cnt; ++old )
+    {
+      if( queue_saved_tab[old].qs_cookie >= cookie ) break;
+      removed(queue_saved_tab[old].qs_cookie);
+    }
+
+    if( old < queue_saved_cnt && queue_saved_tab[old].qs_cookie == cookie )
+    {
+      known = 1, hash = queue_saved_tab[old++].qs_hash;
+    }
+
+    tab[cnt].qs_cookie = cookie;
+
+    if( known )
+    {
+      queue_node_t *node = queue_event_node(vec[i]);
+
+      if( node != 0 && !node->qn_dirty )
+      {
+        // not modified since saved
+        tab[cnt++].qs_hash = hash;
+        continue;
+      }
+    }
+
+    queue_save_event(&buf, vec[i]);
+
+    tab[cnt].qs_hash = queue_save_hash(buf.sb_data + pos, buf.sb_used - pos);
+
+    if( known && tab[cnt].qs_hash == hash )
+    {
+      // unchanged
+      queue_savebuf_trunc(&buf, pos);
+    }
+    else if( known && buf.sb_used == pos )
+    {
+      // nothing to save -> not in queue file either
+      removed(cookie);
+    }
+    ++cnt;
+  }
+
+  for( ; old < queue_saved_cnt; ++old )
+  {
+    removed(queue_saved_tab[old].qs_cookie);
+  }
+
+  /* - - - - - - - - - - - - - - - - - - - *
+   * write changes, if any
+   * - - - - - - - - - - - - - - - - - - - */
+
+  if( queue_save_finish(&buf, &data, &size) == -1 )
+  {
+    goto cleanup;
+  }
+
+  if( size == hdr )
+  {
+    res = 0;
+  }
+  else if( queue_journal_size == 0 )
+  {
+    if( xsavefile(QUEUE_JOURNAL, 0666, data, size) == 0 ) res = 1;
+  }
+  else
+  {
+    if( xappendfile(QUEUE_JOURNAL, 0666, data, size) == 0 ) res = 1;
+  }
+
+  cleanup:
+
+  if( res == -1 )
+  {
+    // journal might be corrupted -> rewrite queue file on next save
+    queue_saved_clear();
+  }
+  else
+  {
+    queue_journal_size += (res == 1) ? size : 0;
+    queue_saved_set(tab, cnt, cfg), tab = 0;
+    queue_saved_mark_clean();
+  }
+
+  free(tab);
+  free(vec);
+  free(data);
+
+  return res;
+}
+
+/* ------------------------------------------------------------------------- *
+ * queue_save_binary  --  write binary copy of the queue file
+ *
+ * Must be called right after the queue file has been written;
+ * the copy is valid only as long as the queue file stays as is.
+ * The section hashes are taken from the saved sections table.
+ * ------------------------------------------------------------------------- */
+
+static
+int
+queue_save_binary(void)
+{
+  int             err  = -1;
+  alarm_event_t **vec  = queue_get_events_by_cookie();
+  uint64_t       *hash = calloc(queue_saved_cnt + 1, sizeof *hash);
+  char           *data = 0;
+  size_t          size = 0;
+  struct stat     st;
+
+  for( size_t i = 0; i < queue_saved_cnt; ++i )
+  {
+    hash[i] = queue_saved_tab[i].qs_hash;
+  }
+
+  if( stat(QUEUE_DATABASE, &st) == -1 )
+  {
+    log_warning("%s: stat: %s\n", QUEUE_DATABASE, strerror(errno));
+    goto cleanup;
+  }
 
-    Xi(alarm_time);
+  if( queuebin_encode(&data, &size, queue_snooze, queue_journal_id,
+                      &st, vec, hash) == -1 )
+  {
+    goto cleanup;
+  }
 
-    Xi(alarm_tm.tm_year);
-    Xi(alarm_tm.tm_mon);
-    Xi(alarm_tm.tm_mday);
-    Xi(alarm_tm.tm_hour);
-    Xi(alarm_tm.tm_min);
-    Xi(alarm_tm.tm_sec);
-    Xi(alarm_tm.tm_wday);
-    Xi(alarm_tm.tm_yday);
-    Xi(alarm_tm.tm_isdst);
+  if( xsavefile(QUEUE_BINARY_TEMP, 0666, data, size) == -1 )
+  {
+    goto cleanup;
+  }
 
-    Xs(alarm_tz);
+  if( rename(QUEUE_BINARY_TEMP, QUEUE_BINARY) == -1 )
+  {
+    log_warning("%s: rename: %s\n", QUEUE_BINARY_TEMP, strerror(errno));
+    goto cleanup;
+  }
 
-    Xi(recur_secs);
-    Xi(recur_count);
+  err = 0;
 
-    Xi(snooze_secs);
-    Xi(snooze_total);
+  cleanup:
 
-    Xu(action_cnt);
-    Xu(recurrence_cnt);
-    Xu(attr_cnt);
+  free(data);
+  free(hash);
+  free(vec);
 
-#undef Xu
-#undef Xi
-#undef Xs
+  return err;
+}
 
-#undef Xu2
-#undef Xi2
-#undef Xs2
+/* ------------------------------------------------------------------------- *
+ * queue_save_snapshot  --  write full queue file and start new journal
+ *
+ * Returns 1 if the queue file was written and -1 on failure.
+ * ------------------------------------------------------------------------- */
 
-    for( size_t i = 0; i < e->action_cnt; ++i )
-    {
-      alarm_action_t  *a= &e->action_tab[i];
+static
+int
+queue_save_snapshot(void)
+{
+  int              res  = -1;
+  queue_saved_t   *tab  = calloc(queue_count + 1, sizeof *tab);
+  queue_savebuf_t  buf  = { .sb_data = 0, };
+  char            *data = 0;
+  size_t           size = 0;
 
-#define Xu(v) xu(a->v, sec, "action%d."#v, (int)i)
-#define Xs(v) xs(a->v, sec, "action%d."#v, (int)i)
+  /* - - - - - - - - - - - - - - - - - - - *
+   * new id -> whatever is in the current
+   * journal does not apply to new file
+   * - - - - - - - - - - - - - - - - - - - */
 
-      Xu(flags);
-      Xs(label);
-      Xs(exec_command);
-      Xs(dbus_interface);
-      Xs(dbus_service);
-      Xs(dbus_path);
-      Xs(dbus_name);
-      Xs(dbus_args);
+  queue_journal_id  += 1;
+  queue_journal_size = 0;
+  queue_saved_clear();
 
-#undef Xu
-#undef Xs
-    }
+  if( queue_save_to_memory(&data, &size, tab) == -1 )
+  {
+    goto cleanup;
+  }
 
-    for( size_t i = 0; i < e->recurrence_cnt; ++i )
-    {
-      alarm_recur_t  *r= &e->recurrence_tab[i];
+  // binary copy is about to become stale
+  if( remove(QUEUE_BINARY) == -1 && errno != ENOENT )
+  {
+    log_warning("%s: remove: %s\n", QUEUE_BINARY, strerror(errno));
+  }
 
-#define Xu(v) xu(r->v, sec, "recurrence_tab%d."#v, (int)i)
-#define Xq(v) xq(r->v, sec, "recurrence_tab%d."#v, (int)i)
+  if( xsavefile(QUEUE_TEMPSAVE, 0666, data, size) == -1 ||
+      xcyclefiles(QUEUE_TEMPSAVE, QUEUE_DATABASE, QUEUE_BACKUP) == -1 )
+  {
+    goto cleanup;
+  }
 
-      Xq(mask_min);
-      Xu(mask_hour);
-      Xu(mask_mday);
-      Xu(mask_wday);
-      Xu(mask_mon);
-      Xu(special);
+  res = 1;
 
-#undef Xu
-#undef Xq
-    }
+  queue_journal_base = size;
+  queue_saved_set(tab, queue_count, queue_save_config_hash()), tab = 0;
+  queue_saved_mark_clean();
 
-    for( size_t i = 0; i < e->attr_cnt; ++i )
-    {
-      alarm_attr_t  *a= e->attr_tab[i];
+  if( queue_binary != 0 )
+  {
+    queue_save_binary();
+  }
 
-#define Xi(v) xi(a->v, sec, "attr%d."#v, (int)i)
-#define Xs(v) xs(a->v, sec, "attr%d."#v, (int)i)
+  /* - - - - - - - - - - - - - - - - - - - *
+   * start the journal right away so that
+   * it gets backed up with the queue file
+   * - - - - - - - - - - - - - - - - - - - */
 
-      Xs(attr_name);
-      Xi(attr_type);
-      switch( a->attr_type )
-      {
-      case ALARM_ATTR_NULL:
-        break;
-      case ALARM_ATTR_INT:
-        Xi(attr_data.ival);
-        break;
-      case ALARM_ATTR_TIME:
-        Xi(attr_data.tval);
-        break;
-      case ALARM_ATTR_STRING:
-        Xs(attr_data.sval);
-        break;
-      }
-#undef Xi
-#undef Xs
-    }
+  queue_save_journal_header(&buf);
+  free(data), data = 0;
 
+  if( queue_save_finish(&buf, &data, &size) == 0 &&
+      xsavefile(QUEUE_JOURNAL, 0666, data, size) == 0 )
+  {
+    queue_journal_size = size;
   }
 
-  err = inifile_save_to_memory(ini, pdata, psize);
-  inifile_delete(ini);
+  cleanup:
 
-  return err;
+  free(tab);
+  free(data);
+
+  return res;
 }
 
 /* ------------------------------------------------------------------------- *
- * queue_load_from_path
+ * queue_journal_is_complete  --  last journal section is terminated
  * ------------------------------------------------------------------------- */
 
-static
-void
-queue_load_from_path(const char *path)
+static int
+queue_journal_is_complete(const char *path)
 {
-  char      **secs = 0;
-  inifile_t  *ini  = inifile_create();
-  unsigned    snooze = 0;
+  int  res  = 0;
+  int  file = -1;
+  char tail[2];
 
-  if( inifile_load(ini, path) == -1 )
+  if( (file = open(path, O_RDONLY)) != -1 &&
+      lseek(file, -2, SEEK_END) != -1 &&
+      read(file, tail, 2) == 2 )
   {
-    log_warning("%s: load failed\n", path);
-    goto cleanup;
+    res = (tail[0] == '\n' && tail[1] == '\n');
   }
 
-  /* - - - - - - - - - - - - - - - - - - - *
-   * parse data from save file
-   * - - - - - - - - - - - - - - - - - - - */
-
-  inifile_getfmt(ini, "config", "snooze", "%u", &snooze);
-  queue_set_snooze(snooze);
+  if( file != -1 ) close(file);
 
-  if( (secs = inifile_get_section_names(ini, 0)) != 0 )
-  {
-    for( size_t i = 0; secs[i]; ++i )
-    {
-      const char *sec = secs[i];
+  return res;
+}
 
-      if( *sec != '#' ) continue;
+/* ------------------------------------------------------------------------- *
+ * queue_parse_section  --  event from "#cookie" section of queue file
+ * ------------------------------------------------------------------------- */
 
-      alarm_event_t *e = alarm_event_create();
+static
+alarm_event_t *
+queue_parse_section(inifile_t *ini, const char *sec)
+{
+  alarm_event_t *e = alarm_event_create();
 
-      size_t cnt;
+  size_t cnt;
 
-      if( inifile_getfmt(ini, sec, "action_cnt", "%zi", &cnt) == 1 )
-      {
-        alarm_event_add_actions(e, cnt);
-      }
-      if( inifile_getfmt(ini, sec, "recurrence_cnt", "%zi", &cnt) == 1 )
-      {
-        alarm_event_add_recurrences(e, cnt);
-      }
+  if( inifile_getfmt(ini, sec, "action_cnt", "%zi", &cnt) == 1 )
+  {
+    alarm_event_add_actions(e, cnt);
+  }
+  if( inifile_getfmt(ini, sec, "recurrence_cnt", "%zi", &cnt) == 1 )
+  {
+    alarm_event_add_recurrences(e, cnt);
+  }
 
 #define Xu2(n,v) e->v = strtoul(inifile_get(ini, sec, #n, ""),0,0)
 #define Xi2(n,v) e->v = strtol(inifile_get(ini, sec, #n, ""),0,0)
 #define Xs2(n,v) xstrset(&(e->v), inifile_get(ini, sec, #n, ""))
+#define Xp2(n,v) unique_strset(&(e->v), inifile_get(ini, sec, #n, ""))
 
 #define Xu(v) Xu2(v,v)
 #define Xi(v) Xi2(v,v)
 #define Xs(v) Xs2(v,v)
+#define Xp(v) Xp2(v,v)
 
-      Xu2(cookie,  ALARMD_PRIVATE(cookie));
-      Xi2(trigger, ALARMD_PRIVATE(trigger));
+  Xu2(cookie,  ALARMD_PRIVATE(cookie));
+  Xi2(trigger, ALARMD_PRIVATE(trigger));
 
-      Xs(title);
-      Xs(message);
-      Xs(sound);
-      Xs(icon);
-      Xu(flags);
+  Xs(title);
+  Xs(message);
+  Xp(sound);
+  Xp(icon);
+  Xu(flags);
 
-      Xs(alarm_appid);
+  Xp(alarm_appid);
 
-      Xi(alarm_time);
+  Xi(alarm_time);
 
-      Xi(alarm_tm.tm_year);
-      Xi(alarm_tm.tm_mon);
-      Xi(alarm_tm.tm_mday);
-      Xi(alarm_tm.tm_hour);
-      Xi(alarm_tm.tm_min);
-      Xi(alarm_tm.tm_sec);
-      Xi(alarm_tm.tm_wday);
-      Xi(alarm_tm.tm_yday);
-      Xi(alarm_tm.tm_isdst);
+  Xi(alarm_tm.tm_year);
+  Xi(alarm_tm.tm_mon);
+  Xi(alarm_tm.tm_mday);
+  Xi(alarm_tm.tm_hour);
+  Xi(alarm_tm.tm_min);
+  Xi(alarm_tm.tm_sec);
+  Xi(alarm_tm.tm_wday);
+  Xi(alarm_tm.tm_yday);
+  Xi(alarm_tm.tm_isdst);
 
-      Xs(alarm_tz);
+  Xp(alarm_tz);
 
-      Xi(recur_secs);
-      Xi(recur_count);
+  Xi(recur_secs);
+  Xi(recur_count);
 
-      Xi(snooze_secs);
-      Xi(snooze_total);
+  Xi(snooze_secs);
+  Xi(snooze_total);
 
 #undef Xu
 #undef Xi
 #undef Xs
+#undef Xp
 
 #undef Xu2
 #undef Xi2
 #undef Xs2
+#undef Xp2
 
-      /* - - - - - - - - - - - - - - - - - - - *
-       * action table
-       * - - - - - - - - - - - - - - - - - - - */
+  /* - - - - - - - - - - - - - - - - - - - *
+   * action table
+   * - - - - - - - - - - - - - - - - - - - */
 
-      for( size_t k = 0; k < e->action_cnt; ++k )
-      {
-        alarm_action_t  *a = &e->action_tab[k];
-        char key[64];
+  for( size_t k = 0; k < e->action_cnt; ++k )
+  {
+    alarm_action_t  *a = &e->action_tab[k];
+    char key[64];
 
 #define Xu(v) \
   snprintf(key, sizeof key, "action%d.%s", (int)k, #v);\
@@ -1089,27 +2903,32 @@ queue_load_from_path(const char *path)
   snprintf(key, sizeof key, "action%d.%s", (int)k, #v);\
   xstrset(&a->v, inifile_get(ini, sec, key, ""))
 
-        Xu(flags);
-        Xs(label);
-        Xs(exec_command);
-        Xs(dbus_interface);
-        Xs(dbus_service);
-        Xs(dbus_path);
-        Xs(dbus_name);
-        Xs(dbus_args);
+#define Xp(v)\
+  snprintf(key, sizeof key, "action%d.%s", (int)k, #v);\
+  unique_strset(&a->v, inifile_get(ini, sec, key, ""))
+
+    Xu(flags);
+    Xs(label);
+    Xs(exec_command);
+    Xp(dbus_interface);
+    Xp(dbus_service);
+    Xp(dbus_path);
+    Xp(dbus_name);
+    Xs(dbus_args);
 
 #undef Xu
 #undef Xs
-      }
+#undef Xp
+  }
 
-      /* - - - - - - - - - - - - - - - - - - - *
-       * recurrence table
-       * - - - - - - - - - - - - - - - - - - - */
+  /* - - - - - - - - - - - - - - - - - - - *
+   * recurrence table
+   * - - - - - - - - - - - - - - - - - - - */
 
-      for( size_t k = 0; k < e->recurrence_cnt; ++k )
-      {
-        alarm_recur_t  *r = &e->recurrence_tab[k];
-        char key[64];
+  for( size_t k = 0; k < e->recurrence_cnt; ++k )
+  {
+    alarm_recur_t  *r = &e->recurrence_tab[k];
+    char key[64];
 
 #define Xu(v) \
   snprintf(key, sizeof key, "recurrence_tab%d.%s", (int)k, #v);\
@@ -1119,30 +2938,34 @@ queue_load_from_path(const char *path)
   snprintf(key, sizeof key, "recurrence_tab%d.%s", (int)k, #v);\
   r->v = strtoull(inifile_get(ini, sec, key,  ""),0,0)
 
-        Xq(mask_min);
-        Xu(mask_hour);
-        Xu(mask_mday);
-        Xu(mask_wday);
-        Xu(mask_mon);
-        Xu(special);
+    Xq(mask_min);
+    Xu(mask_hour);
+    Xu(mask_mday);
+    Xu(mask_wday);
+    Xu(mask_mon);
+    Xu(special);
 
 #undef Xu
 #undef Xq
-      }
+  }
 
-      /* - - - - - - - - - - - - - - - - - - - *
-       * attribute table
-       * - - - - - - - - - - - - - - - - - - - */
+  /* - - - - - - - - - - - - - - - - - - - *
+   * attribute table
+   * - - - - - - - - - - - - - - - - - - - */
 
-      if( inifile_getfmt(ini, sec, "attr_cnt", "%zi", &cnt) != 1 )
-      {
-        cnt = 0;
-      }
+  if( inifile_getfmt(ini, sec, "attr_cnt", "%zi", &cnt) != 1 )
+  {
+    cnt = 0;
+  }
 
-      for( size_t k = 0; k < cnt; ++k )
-      {
-        alarm_attr_t  *a = alarm_event_add_attr(e, "\x7f");
-        char key[64];
+  for( size_t k = 0; k < cnt; ++k )
+  {
+    alarm_attr_t  *a = 0;
+    char key[64];
+
+    snprintf(key, sizeof key, "attr%d.attr_name", (int)k);
+    a = alarm_event_add_attr(e, inifile_get(ini, sec, key, ""));
+    alarm_attr_set_null(a);
 
 #define Xi(v) \
   snprintf(key, sizeof key, "attr%d.%s", (int)k, #v);\
@@ -1152,68 +2975,244 @@ queue_load_from_path(const char *path)
   snprintf(key, sizeof key, "attr%d.%s", (int)k, #v);\
   xstrset(&a->v, inifile_get(ini, sec, key, ""))
 
-        Xs(attr_name);
-        Xi(attr_type);
-
-        switch( a->attr_type )
-        {
-        case ALARM_ATTR_NULL:
-          break;
-        case ALARM_ATTR_INT:
-          Xi(attr_data.ival);
-          break;
-        case ALARM_ATTR_TIME:
-          Xi(attr_data.tval);
-          break;
-        case ALARM_ATTR_STRING:
-          Xs(attr_data.sval);
-          break;
-        }
+    Xi(attr_type);
+
+    switch( a->attr_type )
+    {
+    case ALARM_ATTR_NULL:
+      break;
+    case ALARM_ATTR_INT:
+      Xi(attr_data.ival);
+      break;
+    case ALARM_ATTR_TIME:
+      Xi(attr_data.tval);
+      break;
+    case ALARM_ATTR_STRING:
+      Xs(attr_data.sval);
+      break;
+    }
 #undef Xi
 #undef Xs
-      }
+  }
 
-      /* - - - - - - - - - - - - - - - - - - - *
-       * add to queue
-       * - - - - - - - - - - - - - - - - - - - */
+  return e;
+}
 
-      switch( queue_event_get_state(e) )
-      {
-      case ALARM_STATE_LIMBO:
-      case ALARM_STATE_TRIGGERED:
-      case ALARM_STATE_WAITSYSUI:
-      case ALARM_STATE_SYSUI_REQ:
-      case ALARM_STATE_SYSUI_ACK:
-      case ALARM_STATE_SYSUI_RSP:
-        // put alarms that were in triggered state
-        // back to limbo so that we have a chance
-        // to evaluate conditions and perform actions
-        // again
-        queue_event_set_state(e, ALARM_STATE_LIMBO);
-        break;
+/* ------------------------------------------------------------------------- *
+ * queue_load_event  --  add event read from queue file to the queue
+ * ------------------------------------------------------------------------- */
 
-      default:
-        queue_event_set_state(e, ALARM_STATE_NEW);
-        break;
-      }
+static
+void
+queue_load_event(alarm_event_t *e)
+{
+  switch( queue_event_get_state(e) )
+  {
+  case ALARM_STATE_LIMBO:
+  case ALARM_STATE_TRIGGERED:
+  case ALARM_STATE_WAITSYSUI:
+  case ALARM_STATE_SYSUI_REQ:
+  case ALARM_STATE_SYSUI_ACK:
+  case ALARM_STATE_SYSUI_RSP:
+    // put alarms that were in triggered state
+    // back to limbo so that we have a chance
+    // to evaluate conditions and perform actions
+    // again
+    queue_event_set_state(e, ALARM_STATE_LIMBO);
+    break;
+
+  default:
+    queue_event_set_state(e, ALARM_STATE_NEW);
+    break;
+  }
 
 #if 0 // disabled: rejecting events on load might cause regression
-      if( alarm_event_is_sane(e) != -1 )
-      {
-        queue_add_event(e), e = 0;
-      }
-      alarm_event_delete(e);
+  if( alarm_event_is_sane(e) != -1 )
+  {
+    queue_add_event(e), e = 0;
+  }
+  alarm_event_delete(e);
 #else
-      //alarm_event_is_sane(e);
-      queue_add_event(e);
+  //alarm_event_is_sane(e);
+  queue_add_event(e);
 #endif
+}
+
+/* ------------------------------------------------------------------------- *
+ * queue_load_from_path
+ *
+ * If up to date binary copy is available, the queue file is not read
+ * at all; the journal is replayed on an empty inifile and the events
+ * it does not mention are taken from the binary copy as is.
+ * ------------------------------------------------------------------------- */
+
+static
+void
+queue_load_from_path(const char *path, const char *journal, const char *binary)
+{
+  char          **secs = 0;
+  inifile_t      *ini  = inifile_create();
+  queuebin_t     *bin  = 0;
+  unsigned        snooze = 0;
+  unsigned        id   = 0;
+  size_t          cnt  = 0;
+  queue_saved_t  *tab  = 0;
+  size_t          used = 0;
+  queue_savebuf_t buf  = { .sb_data = 0, };
+  struct stat     st;
+
+  queue_saved_clear();
+  queue_journal_id   = 0;
+  queue_journal_size = 0;
+  queue_journal_base = 0;
+
+  xfetchstats(path, &st);
+  queue_journal_base = st.st_size;
+
+  /* - - - - - - - - - - - - - - - - - - - *
+   * use binary copy only if it was made
+   * from the queue file as it is now
+   * - - - - - - - - - - - - - - - - - - - */
+
+  if( binary != 0 && (bin = queuebin_open(binary)) != 0 &&
+      !queuebin_is_copy_of(bin, &st) )
+  {
+    log_warning("%s: does not match %s - ignored\n", binary, path);
+    queuebin_close(bin), bin = 0;
+  }
+
+  if( bin != 0 )
+  {
+    snooze           = queuebin_get_snooze(bin);
+    queue_journal_id = queuebin_get_journal(bin);
+  }
+  else if( inifile_load(ini, path) == -1 )
+  {
+    log_warning("%s: load failed\n", path);
+    goto cleanup;
+  }
+  else
+  {
+    inifile_getfmt(ini, "config", "journal", "%u", &queue_journal_id);
+  }
+
+  /* - - - - - - - - - - - - - - - - - - - *
+   * apply journal if it belongs to the
+   * queue file that was loaded
+   * - - - - - - - - - - - - - - - - - - - */
+
+  if( journal != 0 && xexists(journal) )
+  {
+    if( inifile_replay(ini, journal) == -1 ||
+        inifile_getfmt(ini, "journal", "id", "%u", &id) != 1 ||
+        id != queue_journal_id )
+    {
+      log_warning("%s: does not match %s - ignored\n", journal, path);
+      inifile_delete(ini), ini = inifile_create();
+      if( bin == 0 ) inifile_load(ini, path);
+    }
+    else
+    {
+      xfetchstats(journal, &st);
+      queue_journal_size = st.st_size;
+    }
+  }
+
+  /* - - - - - - - - - - - - - - - - - - - *
+   * parse data from save file
+   * - - - - - - - - - - - - - - - - - - - */
+
+  inifile_getfmt(ini, "config", "snooze", "%u", &snooze);
+  queue_set_snooze(snooze);
+
+  secs = inifile_get_section_names(ini, &cnt);
+  tab  = calloc(cnt + (bin ? queuebin_get_count(bin) : 0) + 1, sizeof *tab);
+
+  /* - - - - - - - - - - - - - - - - - - - *
+   * events from binary copy, skipping the
+   * ones changed or removed in journal
+   * - - - - - - - - - - - - - - - - - - - */
+
+  for( size_t i = 0, n = bin ? queuebin_get_count(bin) : 0; i < n; ++i )
+  {
+    char sec[32];
+
+    snprintf(sec, sizeof sec, "#%08x", (unsigned)queuebin_get_cookie(bin, i));
+
+    if( inifile_has_section(ini, sec) ) continue;
+
+    alarm_event_t *e = queuebin_get_event(bin, i);
+
+    if( e == 0 )
+    {
+      log_warning("%s: [%s] could not be loaded\n", binary, sec);
+      continue;
+    }
+
+    // hash of the section as it is in the queue file
+    tab[used].qs_cookie = e->ALARMD_PRIVATE(cookie);
+    tab[used].qs_hash   = queuebin_get_hash(bin, i);
+    ++used;
+
+    queue_load_event(e);
+  }
+
+  /* - - - - - - - - - - - - - - - - - - - *
+   * events from queue file and journal
+   * - - - - - - - - - - - - - - - - - - - */
+
+  for( size_t i = 0; secs && secs[i]; ++i )
+  {
+    const char *sec = secs[i];
+
+    if( *sec != '#' ) continue;
+
+    // removed in journal
+    if( !inifile_has(ini, sec, "cookie") ) continue;
+
+    alarm_event_t *e = queue_parse_section(ini, sec);
+
+    if( e == 0 )
+    {
+      log_warning("%s: [%s] could not be loaded\n", path, sec);
+      continue;
     }
+
+    /* - - - - - - - - - - - - - - - - - - - *
+     * remember what was loaded so that only
+     * changes need to be journaled
+     * - - - - - - - - - - - - - - - - - - - */
+
+    queue_savebuf_trunc(&buf, 0);
+    queue_save_event(&buf, e);
+
+    tab[used].qs_cookie = e->ALARMD_PRIVATE(cookie);
+    tab[used].qs_hash   = queue_save_hash(buf.sb_data, buf.sb_used);
+    ++used;
+
+    queue_load_event(e);
+  }
+
+  /* - - - - - - - - - - - - - - - - - - - *
+   * journaling can continue if the data
+   * came from the actual queue file and
+   * the journal was not cut short
+   * - - - - - - - - - - - - - - - - - - - */
+
+  if( journal != 0 && !buf.sb_error &&
+      (queue_journal_size == 0 || queue_journal_is_complete(journal)) )
+  {
+    qsort(tab, used, sizeof *tab, queue_saved_cmp_cb);
+    queue_saved_set(tab, used, queue_save_config_hash()), tab = 0;
   }
 
   cleanup:
 
+  free(buf.sb_data);
+  free(tab);
   xfreev(secs);
   inifile_delete(ini);
+  queuebin_close(bin);
 }
 
 /* ------------------------------------------------------------------------- *
@@ -1231,10 +3230,6 @@ queue_save_internal(int forced)
   static int fail_cnt = 0;
 
   int        result   = -1;
-  char      *old_data = 0;
-  char      *new_data = 0;
-  size_t     old_size = 0;
-  size_t     new_size = 0;
 
   /* - - - - - - - - - - - - - - - - - - - *
    * try to deal with osso-backup restoring
@@ -1271,25 +3266,21 @@ queue_save_internal(int forced)
    * try really hard to avoid writing to
    * flash file system
    *
-   * 1) load previous contents to RAM
-   * 2) generate current contents in RAM
-   * 3) write only if the two differ
+   * 1) append changed events to journal
+   * 2) rewrite the whole queue file only
+   *    if the journal grows too large, or
+   *    we do not know what is on disk
    * - - - - - - - - - - - - - - - - - - - */
 
-  xloadfile(QUEUE_DATABASE, &old_data, &old_size);
-  queue_save_to_memory(&new_data, &new_size);
-
-  if( old_size != new_size || memcmp(old_data, new_data, new_size) )
+  if( forced != 0 || !queue_saved_valid ||
+      (queue_journal_size > QUEUE_JOURNAL_MIN &&
+       queue_journal_size > queue_journal_base) )
   {
-    if( xsavefile(QUEUE_TEMPSAVE, 0666, new_data, new_size) == 0 &&
-        xcyclefiles(QUEUE_TEMPSAVE, QUEUE_DATABASE, QUEUE_BACKUP) == 0 )
-    {
-      result = 1;
-    }
+    result = queue_save_snapshot();
   }
   else
   {
-    result = 0;
+    result = queue_save_journal();
   }
 
   /* - - - - - - - - - - - - - - - - - - - *
@@ -1314,14 +3305,6 @@ queue_save_internal(int forced)
   log_info("queue save: %s -> saved=%d, skipped=%d, failed=%d\n",
            (result==0) ? "SKIP" : (result==1) ? "SAVE" : "FAIL",
            save_cnt, skip_cnt, fail_cnt);
-
-  /* - - - - - - - - - - - - - - - - - - - *
-   * release buffers
-   * - - - - - - - - - - - - - - - - - - - */
-
-  free(old_data);
-  free(new_data);
-
 }
 
 /* ------------------------------------------------------------------------- *
@@ -1372,8 +3355,10 @@ queue_load(void)
   {
     if( access(order[i], F_OK) == 0 )
     {
-      queue_load_from_path(order[i]);
       first = (i == 0);
+      queue_load_from_path(order[i],
+                           first ? QUEUE_JOURNAL : 0,
+                           first ? QUEUE_BINARY  : 0);
       break;
     }
   }
@@ -1395,6 +3380,29 @@ queue_load(void)
   }
 }
 
+/* ------------------------------------------------------------------------- *
+ * queue_convert  --  rewrite queue file with or without binary copy
+ *
+ * Folds the journal into the queue file. Meant to be used
+ * from command line while alarmd itself is not running.
+ * ------------------------------------------------------------------------- */
+
+int
+queue_convert(int binary)
+{
+  int res = -1;
+
+  queue_binary = binary;
+
+  queue_load();
+  res = queue_save_snapshot();
+
+  queue_flush_events();
+  queue_saved_clear();
+
+  return (res == 1) ? 0 : -1;
+}
+
 /* ========================================================================= *
  * DIRTY STATE CONTROL
  * ========================================================================= */
@@ -1440,6 +3448,7 @@ queue_is_dirty(void)
 int
 queue_init(void)
 {
+  unique_pool_enable(1);
   queue_load();
   return 0;
 }
@@ -1453,4 +3462,13 @@ queue_quit(void)
 {
   queue_save();
   queue_flush_events();
+  queue_saved_clear();
+
+  for( int cls = 0; cls < QUEUE_WAKEUP_NUMOF; ++cls )
+  {
+    free(queue_wake_heap[cls]);
+    queue_wake_heap[cls]  = 0;
+    queue_wake_count[cls] = 0;
+    queue_wake_alloc[cls] = 0;
+  }
 }
@@ -26,6 +26,8 @@
 #define QUEUE_H_
 
 #include "libalarm.h"
+#include "recurcache.h"
+#include "msgcache.h"
 
 #ifdef __cplusplus
 extern "C" {
@@ -38,22 +40,31 @@ extern "C" {
  * ========================================================================= */
 
 void           queue_set_modified_cb  (void (*cb)(void));
+void           queue_set_changed_cb   (void (*cb)(alarm_event_t *, int));
+void           queue_set_wakeup_class_cb(int (*cb)(alarm_event_t *));
 unsigned       queue_get_snooze       (void);
 void           queue_set_snooze       (unsigned snooze);
 void           queue_event_set_trigger(alarm_event_t *event, time_t trigger);
 unsigned       queue_event_get_state  (const alarm_event_t *self);
 void           queue_event_set_state  (alarm_event_t *self, unsigned state);
+void           queue_event_set_disabled(alarm_event_t *self);
+recurcache_t **queue_event_get_recurcache(alarm_event_t *self);
+msgcache_t   **queue_event_get_msgcache(alarm_event_t *self);
 cookie_t       queue_add_event        (alarm_event_t *event);
 alarm_event_t *queue_get_event        (cookie_t cookie);
 int            queue_del_event        (cookie_t cookie);
 cookie_t      *queue_query_events     (int *pcnt, time_t lo, time_t hi, unsigned mask, unsigned flag, const char *app);
+cookie_t      *queue_query_events_page(int *pcnt, time_t lo, time_t hi, unsigned mask, unsigned flag, const char *app, size_t limit, time_t *ptrigger, cookie_t *pcookie);
 cookie_t      *queue_query_by_state   (int *pcnt, unsigned state);
 int            queue_count_by_state_and_flag   (unsigned state, unsigned flag);
 int            queue_count_by_state   (unsigned state);
+alarm_event_t *queue_get_next_queued  (int cls);
+int            queue_count_queued_icons(void);
 void           queue_cleanup_deleted  (void);
 void           queue_save             (void);
 void           queue_load             (void);
 void           queue_save_forced      (void);
+int            queue_convert          (int binary);
 void           queue_set_dirty        (void);
 void           queue_clr_dirty        (void);
 int            queue_is_dirty         (void);
@@ -68,8 +79,21 @@ typedef enum alarmeventstates
 {
 #define ALARM_STATE(name) ALARM_STATE_##name,
 #include "states.inc"
+  ALARM_STATE_NUMOF
 } alarmeventstates;
 
+/* ========================================================================= *
+ * wakeup classes for queued events
+ * ========================================================================= */
+
+typedef enum queuewakeupclasses
+{
+  QUEUE_WAKEUP_DESKTOP,  // boot to desktop
+  QUEUE_WAKEUP_ACTDEAD,  // boot to acting dead
+  QUEUE_WAKEUP_NO_BOOT,  // no boot, software wakeup only
+  QUEUE_WAKEUP_NUMOF
+} queuewakeupclasses;
+
 #ifdef __cplusplus
 };
 #endif
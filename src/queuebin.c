@@ -0,0 +1,892 @@
+/* ========================================================================= *
+ *
+ * This file is part of Alarmd
+ *
+ * Copyright (C) 2008-2009 Nokia Corporation and/or its subsidiary(-ies).
+ *
+ * Contact: Simo Piiroinen <simo.piiroinen@nokia.com>
+ *
+ * Alarmd is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * version 2.1 as published by the Free Software Foundation.
+ *
+ * Alarmd is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with Alarmd; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA
+ * 02110-1301 USA
+ *
+ * ========================================================================= */
+
+#include "alarmd_config.h"
+
+#include "queuebin.h"
+#include "logging.h"
+#include "xutil.h"
+#include "unique.h"
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+
+/* ========================================================================= *
+ * FILE FORMAT
+ * ========================================================================= */
+
+#define QUEUEBIN_MAGIC   "ALARMDQB"
+#define QUEUEBIN_VERSION 2
+#define QUEUEBIN_ORDER   0x01020304
+
+/* ------------------------------------------------------------------------- *
+ * queuebin_header_t  --  at offset zero
+ * ------------------------------------------------------------------------- */
+
+typedef struct
+{
+  char     qh_magic[8];
+  uint32_t qh_version;
+  uint32_t qh_order;
+
+  /* file size, for detecting truncated files */
+  uint32_t qh_size;
+
+  /* config section of the queue file */
+  uint32_t qh_snooze;
+  uint32_t qh_journal;
+  uint32_t qh_reserved;
+
+  /* identity of the text file this is a copy of */
+  uint64_t qh_master_ino;
+  uint64_t qh_master_size;
+  int64_t  qh_master_sec;
+  int64_t  qh_master_nsec;
+
+  /* record tables: offset from start of file and element count,
+   * string table: offset and size in bytes */
+  uint32_t qh_event_off,  qh_event_cnt;
+  uint32_t qh_action_off, qh_action_cnt;
+  uint32_t qh_recur_off,  qh_recur_cnt;
+  uint32_t qh_attr_off,   qh_attr_cnt;
+  uint32_t qh_string_off, qh_string_size;
+} queuebin_header_t;
+
+/* ------------------------------------------------------------------------- *
+ * queuebin_event_t  --  fixed part of alarm_event_t
+ *
+ * Strings are offsets to the string table, offset zero is
+ * an empty string. Actions, recurrences and attributes are
+ * index + count ranges in the respective tables.
+ * ------------------------------------------------------------------------- */
+
+typedef struct
+{
+  int64_t  qe_cookie;
+  int64_t  qe_trigger;
+  int64_t  qe_alarm_time;
+
+  /* hash of the event section in the text file */
+  uint64_t qe_hash;
+
+  uint32_t qe_flags;
+  int32_t  qe_alarm_tm[9];
+
+  int32_t  qe_recur_secs;
+  int32_t  qe_recur_count;
+  int32_t  qe_snooze_secs;
+  int32_t  qe_snooze_total;
+
+  uint32_t qe_title;
+  uint32_t qe_message;
+  uint32_t qe_sound;
+  uint32_t qe_icon;
+  uint32_t qe_alarm_appid;
+  uint32_t qe_alarm_tz;
+
+  uint32_t qe_action_idx, qe_action_cnt;
+  uint32_t qe_recur_idx,  qe_recur_cnt;
+  uint32_t qe_attr_idx,   qe_attr_cnt;
+} queuebin_event_t;
+
+/* ------------------------------------------------------------------------- *
+ * queuebin_action_t  --  alarm_action_t
+ * ------------------------------------------------------------------------- */
+
+typedef struct
+{
+  uint32_t qa_flags;
+  uint32_t qa_label;
+  uint32_t qa_exec_command;
+  uint32_t qa_dbus_interface;
+  uint32_t qa_dbus_service;
+  uint32_t qa_dbus_path;
+  uint32_t qa_dbus_name;
+  uint32_t qa_dbus_args;
+} queuebin_action_t;
+
+/* ------------------------------------------------------------------------- *
+ * queuebin_recur_t  --  alarm_recur_t
+ * ------------------------------------------------------------------------- */
+
+typedef struct
+{
+  uint64_t qr_mask_min;
+  uint32_t qr_mask_hour;
+  uint32_t qr_mask_mday;
+  uint32_t qr_mask_wday;
+  uint32_t qr_mask_mon;
+  int32_t  qr_special;
+  uint32_t qr_reserved;
+} queuebin_recur_t;
+
+/* ------------------------------------------------------------------------- *
+ * queuebin_attr_t  --  alarm_attr_t
+ * ------------------------------------------------------------------------- */
+
+typedef struct
+{
+  int64_t  qt_value;
+  uint32_t qt_name;
+  int32_t  qt_type;
+} queuebin_attr_t;
+
+/* ------------------------------------------------------------------------- *
+ * queuebin_t  --  mapped file
+ * ------------------------------------------------------------------------- */
+
+struct queuebin_t
+{
+  void                    *qb_base;
+  size_t                   qb_size;
+
+  const queuebin_header_t *qb_head;
+  const queuebin_event_t  *qb_event;
+  const queuebin_action_t *qb_action;
+  const queuebin_recur_t  *qb_recur;
+  const queuebin_attr_t   *qb_attr;
+  const char              *qb_string;
+};
+
+/* ========================================================================= *
+ * ENCODING
+ * ========================================================================= */
+
+/* ------------------------------------------------------------------------- *
+ * queuebin_buf_t  --  growable buffer for one table
+ * ------------------------------------------------------------------------- */
+
+typedef struct
+{
+  char   *bb_data;
+  size_t  bb_size;
+  size_t  bb_used;
+  int     bb_error;
+} queuebin_buf_t;
+
+/* ------------------------------------------------------------------------- *
+ * queuebin_buf_add  --  append data, returns offset or -1 on error
+ * ------------------------------------------------------------------------- */
+
+static ssize_t
+queuebin_buf_add(queuebin_buf_t *self, const void *data, size_t size)
+{
+  if( self->bb_error )
+  {
+    return -1;
+  }
+
+  if( self->bb_size - self->bb_used < size )
+  {
+    size_t need = self->bb_used + size;
+    size_t want = self->bb_size ? self->bb_size : 1024;
+    char  *temp = 0;
+
+    while( want < need ) want *= 2;
+
+    if( (temp = realloc(self->bb_data, want)) == 0 )
+    {
+      self->bb_error = 1;
+      return -1;
+    }
+    self->bb_data = temp;
+    self->bb_size = want;
+  }
+
+  ssize_t res = self->bb_used;
+  if( size != 0 )
+  {
+    memcpy(self->bb_data + self->bb_used, data, size);
+    self->bb_used += size;
+  }
+  return res;
+}
+
+/* ------------------------------------------------------------------------- *
+ * queuebin_strtab_t  --  string table with duplicate elimination
+ * ------------------------------------------------------------------------- */
+
+typedef struct
+{
+  queuebin_buf_t st_buf;
+
+  /* open addressing hash: offset + 1, or zero for unused */
+  uint32_t      *st_hash;
+  size_t         st_slots;
+  size_t         st_count;
+} queuebin_strtab_t;
+
+/* ------------------------------------------------------------------------- *
+ * queuebin_strtab_hash
+ * ------------------------------------------------------------------------- */
+
+static size_t
+queuebin_strtab_hash(const char *s)
+{
+  uint32_t h = 2166136261u;
+
+  for( ; *s; ++s )
+  {
+    h ^= (unsigned char)*s;
+    h *= 16777619u;
+  }
+  return h;
+}
+
+/* ------------------------------------------------------------------------- *
+ * queuebin_strtab_rehash
+ * ------------------------------------------------------------------------- */
+
+static int
+queuebin_strtab_rehash(queuebin_strtab_t *self)
+{
+  size_t    slots = self->st_slots ? self->st_slots * 2 : 256;
+  uint32_t *hash  = calloc(slots, sizeof *hash);
+
+  if( hash == 0 )
+  {
+    return -1;
+  }
+
+  for( size_t i = 0; i < self->st_slots; ++i )
+  {
+    uint32_t ent = self->st_hash[i];
+
+    if( ent == 0 ) continue;
+
+    size_t k = queuebin_strtab_hash(self->st_buf.bb_data + ent - 1);
+
+    for( k &= slots - 1; hash[k]; k = (k + 1) & (slots - 1) ) {}
+    hash[k] = ent;
+  }
+
+  free(self->st_hash);
+  self->st_hash  = hash;
+  self->st_slots = slots;
+  return 0;
+}
+
+/* ------------------------------------------------------------------------- *
+ * queuebin_strtab_add  --  get string table offset for string
+ * ------------------------------------------------------------------------- */
+
+static uint32_t
+queuebin_strtab_add(queuebin_strtab_t *self, const char *s)
+{
+  if( s == 0 || *s == 0 )
+  {
+    return 0;
+  }
+
+  if( 2 * (self->st_count + 1) > self->st_slots &&
+      queuebin_strtab_rehash(self) == -1 )
+  {
+    self->st_buf.bb_error = 1;
+    return 0;
+  }
+
+  size_t k = queuebin_strtab_hash(s) & (self->st_slots - 1);
+
+  for( ; self->st_hash[k]; k = (k + 1) & (self->st_slots - 1) )
+  {
+    uint32_t off = self->st_hash[k] - 1;
+
+    if( !strcmp(self->st_buf.bb_data + off, s) )
+    {
+      return off;
+    }
+  }
+
+  ssize_t off = queuebin_buf_add(&self->st_buf, s, strlen(s) + 1);
+
+  if( off == -1 )
+  {
+    return 0;
+  }
+
+  self->st_hash[k] = off + 1;
+  self->st_count  += 1;
+  return off;
+}
+
+/* ------------------------------------------------------------------------- *
+ * queuebin_encode  --  binary image of given events
+ *
+ * The events must be sorted by cookie. The hash table, if given,
+ * holds values to be returned by queuebin_get_hash() for each event.
+ * ------------------------------------------------------------------------- */
+
+int
+queuebin_encode(char **pdata, size_t *psize, unsigned snooze,
+                unsigned journal, const struct stat *master,
+                alarm_event_t **vec, const uint64_t *hash)
+{
+  int               err  = -1;
+  queuebin_header_t head;
+  queuebin_buf_t    file = { .bb_data = 0, };
+  queuebin_buf_t    evet = { .bb_data = 0, };
+  queuebin_buf_t    acts = { .bb_data = 0, };
+  queuebin_buf_t    recs = { .bb_data = 0, };
+  queuebin_buf_t    atts = { .bb_data = 0, };
+  queuebin_strtab_t strs = { .st_hash = 0, };
+
+  auto uint32_t str(const char *s);
+  auto uint32_t str(const char *s)
+  {
+    return queuebin_strtab_add(&strs, s);
+  }
+
+  // offset zero == empty string
+  queuebin_buf_add(&strs.st_buf, "", 1);
+
+  /* - - - - - - - - - - - - - - - - - - - *
+   * build the tables
+   * - - - - - - - - - - - - - - - - - - - */
+
+  for( size_t i = 0; vec[i] != 0; ++i )
+  {
+    const alarm_event_t *e = vec[i];
+    queuebin_event_t     r;
+
+    memset(&r, 0, sizeof r);
+
+    r.qe_cookie       = e->ALARMD_PRIVATE(cookie);
+    r.qe_trigger      = e->ALARMD_PRIVATE(trigger);
+    r.qe_alarm_time   = e->alarm_time;
+    r.qe_hash         = hash ? hash[i] : 0;
+    r.qe_flags        = e->flags;
+
+    r.qe_alarm_tm[0]  = e->alarm_tm.tm_year;
+    r.qe_alarm_tm[1]  = e->alarm_tm.tm_mon;
+    r.qe_alarm_tm[2]  = e->alarm_tm.tm_mday;
+    r.qe_alarm_tm[3]  = e->alarm_tm.tm_hour;
+    r.qe_alarm_tm[4]  = e->alarm_tm.tm_min;
+    r.qe_alarm_tm[5]  = e->alarm_tm.tm_sec;
+    r.qe_alarm_tm[6]  = e->alarm_tm.tm_wday;
+    r.qe_alarm_tm[7]  = e->alarm_tm.tm_yday;
+    r.qe_alarm_tm[8]  = e->alarm_tm.tm_isdst;
+
+    r.qe_recur_secs   = e->recur_secs;
+    r.qe_recur_count  = e->recur_count;
+    r.qe_snooze_secs  = e->snooze_secs;
+    r.qe_snooze_total = e->snooze_total;
+
+    r.qe_title        = str(e->title);
+    r.qe_message      = str(e->message);
+    r.qe_sound        = str(e->sound);
+    r.qe_icon         = str(e->icon);
+    r.qe_alarm_appid  = str(e->alarm_appid);
+    r.qe_alarm_tz     = str(e->alarm_tz);
+
+    r.qe_action_idx   = acts.bb_used / sizeof(queuebin_action_t);
+    r.qe_action_cnt   = e->action_cnt;
+    r.qe_recur_idx    = recs.bb_used / sizeof(queuebin_recur_t);
+    r.qe_recur_cnt    = e->recurrence_cnt;
+    r.qe_attr_idx     = atts.bb_used / sizeof(queuebin_attr_t);
+    r.qe_attr_cnt     = e->attr_cnt;
+
+    for( size_t k = 0; k < e->action_cnt; ++k )
+    {
+      const alarm_action_t *a = &e->action_tab[k];
+      queuebin_action_t     b;
+
+      b.qa_flags          = a->flags;
+      b.qa_label          = str(a->label);
+      b.qa_exec_command   = str(a->exec_command);
+      b.qa_dbus_interface = str(a->dbus_interface);
+      b.qa_dbus_service   = str(a->dbus_service);
+      b.qa_dbus_path      = str(a->dbus_path);
+      b.qa_dbus_name      = str(a->dbus_name);
+      b.qa_dbus_args      = str(a->dbus_args);
+
+      queuebin_buf_add(&acts, &b, sizeof b);
+    }
+
+    for( size_t k = 0; k < e->recurrence_cnt; ++k )
+    {
+      const alarm_recur_t *a = &e->recurrence_tab[k];
+      queuebin_recur_t     b;
+
+      b.qr_mask_min  = a->mask_min;
+      b.qr_mask_hour = a->mask_hour;
+      b.qr_mask_mday = a->mask_mday;
+      b.qr_mask_wday = a->mask_wday;
+      b.qr_mask_mon  = a->mask_mon;
+      b.qr_special   = a->special;
+      b.qr_reserved  = 0;
+
+      queuebin_buf_add(&recs, &b, sizeof b);
+    }
+
+    for( size_t k = 0; k < e->attr_cnt; ++k )
+    {
+      const alarm_attr_t *a = e->attr_tab[k];
+      queuebin_attr_t     b;
+
+      b.qt_name  = str(a->attr_name);
+      b.qt_type  = a->attr_type;
+      b.qt_value = 0;
+
+      switch( a->attr_type )
+      {
+      case ALARM_ATTR_INT:    b.qt_value = a->attr_data.ival;      break;
+      case ALARM_ATTR_TIME:   b.qt_value = a->attr_data.tval;      break;
+      case ALARM_ATTR_STRING: b.qt_value = str(a->attr_data.sval); break;
+      }
+
+      queuebin_buf_add(&atts, &b, sizeof b);
+    }
+
+    queuebin_buf_add(&evet, &r, sizeof r);
+  }
+
+  /* - - - - - - - - - - - - - - - - - - - *
+   * header + tables -> file image
+   * - - - - - - - - - - - - - - - - - - - */
+
+  memset(&head, 0, sizeof head);
+  memcpy(head.qh_magic, QUEUEBIN_MAGIC, sizeof head.qh_magic);
+  head.qh_version     = QUEUEBIN_VERSION;
+  head.qh_order       = QUEUEBIN_ORDER;
+  head.qh_snooze      = snooze;
+  head.qh_journal     = journal;
+
+  head.qh_master_ino  = master->st_ino;
+  head.qh_master_size = master->st_size;
+  head.qh_master_sec  = master->st_mtim.tv_sec;
+  head.qh_master_nsec = master->st_mtim.tv_nsec;
+
+  head.qh_event_cnt   = evet.bb_used / sizeof(queuebin_event_t);
+  head.qh_action_cnt  = acts.bb_used / sizeof(queuebin_action_t);
+  head.qh_recur_cnt   = recs.bb_used / sizeof(queuebin_recur_t);
+  head.qh_attr_cnt    = atts.bb_used / sizeof(queuebin_attr_t);
+  head.qh_string_size = strs.st_buf.bb_used;
+
+  // all record types are multiples of 8 bytes, pad strings
+  static const char pad[8];
+
+  queuebin_buf_add(&file, &head, sizeof head);
+  head.qh_event_off  = queuebin_buf_add(&file, evet.bb_data, evet.bb_used);
+  head.qh_action_off = queuebin_buf_add(&file, acts.bb_data, acts.bb_used);
+  head.qh_recur_off  = queuebin_buf_add(&file, recs.bb_data, recs.bb_used);
+  head.qh_attr_off   = queuebin_buf_add(&file, atts.bb_data, atts.bb_used);
+  head.qh_string_off = queuebin_buf_add(&file, strs.st_buf.bb_data,
+                                        strs.st_buf.bb_used);
+  queuebin_buf_add(&file, pad, -file.bb_used & 7);
+
+  head.qh_size = file.bb_used;
+
+  if( file.bb_error || evet.bb_error || acts.bb_error ||
+      recs.bb_error || atts.bb_error || strs.st_buf.bb_error ||
+      file.bb_used > UINT32_MAX )
+  {
+    log_warning("%s: %s\n", "queuebin", "encoding failed");
+    goto cleanup;
+  }
+
+  memcpy(file.bb_data, &head, sizeof head);
+
+  free(*pdata), *pdata = file.bb_data, file.bb_data = 0;
+  *psize = file.bb_used;
+
+  err = 0;
+
+  cleanup:
+
+  free(file.bb_data);
+  free(evet.bb_data);
+  free(acts.bb_data);
+  free(recs.bb_data);
+  free(atts.bb_data);
+  free(strs.st_buf.bb_data);
+  free(strs.st_hash);
+
+  return err;
+}
+
+/* ========================================================================= *
+ * DECODING
+ * ========================================================================= */
+
+/* ------------------------------------------------------------------------- *
+ * queuebin_table_ok  --  table lies within the file
+ * ------------------------------------------------------------------------- */
+
+static int
+queuebin_table_ok(const queuebin_t *self, uint32_t off, uint64_t cnt,
+                  size_t size)
+{
+  return (off % 8 == 0 &&
+          off <= self->qb_size &&
+          cnt * size <= self->qb_size - off);
+}
+
+/* ------------------------------------------------------------------------- *
+ * queuebin_validate  --  sanity check header of mapped file
+ * ------------------------------------------------------------------------- */
+
+static int
+queuebin_validate(const queuebin_t *self)
+{
+  const queuebin_header_t *h = self->qb_head;
+
+  if( self->qb_size < sizeof *h ||
+      memcmp(h->qh_magic, QUEUEBIN_MAGIC, sizeof h->qh_magic) ||
+      h->qh_version != QUEUEBIN_VERSION ||
+      h->qh_order   != QUEUEBIN_ORDER   ||
+      h->qh_size    != self->qb_size )
+  {
+    return 0;
+  }
+
+  if( !queuebin_table_ok(self, h->qh_event_off, h->qh_event_cnt,
+                         sizeof(queuebin_event_t))  ||
+      !queuebin_table_ok(self, h->qh_action_off, h->qh_action_cnt,
+                         sizeof(queuebin_action_t)) ||
+      !queuebin_table_ok(self, h->qh_recur_off, h->qh_recur_cnt,
+                         sizeof(queuebin_recur_t))  ||
+      !queuebin_table_ok(self, h->qh_attr_off, h->qh_attr_cnt,
+                         sizeof(queuebin_attr_t))   ||
+      !queuebin_table_ok(self, h->qh_string_off, h->qh_string_size, 1) )
+  {
+    return 0;
+  }
+
+  // string table must be terminated -> any offset is a valid string
+  const char *str = (const char *)self->qb_base + h->qh_string_off;
+
+  if( h->qh_string_size == 0 || str[h->qh_string_size - 1] != 0 )
+  {
+    return 0;
+  }
+
+  return 1;
+}
+
+/* ------------------------------------------------------------------------- *
+ * queuebin_str  --  string table lookup
+ * ------------------------------------------------------------------------- */
+
+static const char *
+queuebin_str(const queuebin_t *self, uint32_t off)
+{
+  return (off < self->qb_head->qh_string_size) ? (self->qb_string + off) : "";
+}
+
+/* ------------------------------------------------------------------------- *
+ * queuebin_open
+ * ------------------------------------------------------------------------- */
+
+queuebin_t *
+queuebin_open(const char *path)
+{
+  queuebin_t *self = 0;
+  int         file = -1;
+  void       *base = MAP_FAILED;
+  struct stat st;
+
+  if( (file = open(path, O_RDONLY)) == -1 )
+  {
+    if( errno != ENOENT )
+    {
+      log_warning("%s: open: %s\n", path, strerror(errno));
+    }
+    goto cleanup;
+  }
+
+  if( fstat(file, &st) == -1 || st.st_size < (off_t)sizeof(queuebin_header_t) )
+  {
+    log_warning("%s: %s\n", path, "truncated file");
+    goto cleanup;
+  }
+
+  if( (base = mmap(0, st.st_size, PROT_READ, MAP_PRIVATE, file, 0)) == MAP_FAILED )
+  {
+    log_warning("%s: mmap: %s\n", path, strerror(errno));
+    goto cleanup;
+  }
+
+  self = calloc(1, sizeof *self);
+  self->qb_base   = base, base = MAP_FAILED;
+  self->qb_size   = st.st_size;
+  self->qb_head   = self->qb_base;
+
+  if( !queuebin_validate(self) )
+  {
+    log_warning("%s: %s\n", path, "unsupported or corrupted file");
+    queuebin_close(self), self = 0;
+    goto cleanup;
+  }
+
+  self->qb_event  = self->qb_base + self->qb_head->qh_event_off;
+  self->qb_action = self->qb_base + self->qb_head->qh_action_off;
+  self->qb_recur  = self->qb_base + self->qb_head->qh_recur_off;
+  self->qb_attr   = self->qb_base + self->qb_head->qh_attr_off;
+  self->qb_string = self->qb_base + self->qb_head->qh_string_off;
+
+  cleanup:
+
+  if( base != MAP_FAILED ) munmap(base, st.st_size);
+  if( file != -1 ) close(file);
+
+  return self;
+}
+
+/* ------------------------------------------------------------------------- *
+ * queuebin_close
+ * ------------------------------------------------------------------------- */
+
+void
+queuebin_close(queuebin_t *self)
+{
+  if( self != 0 )
+  {
+    munmap(self->qb_base, self->qb_size);
+    free(self);
+  }
+}
+
+/* ------------------------------------------------------------------------- *
+ * queuebin_is_copy_of  --  check that text file has not changed since
+ * ------------------------------------------------------------------------- */
+
+int
+queuebin_is_copy_of(const queuebin_t *self, const struct stat *master)
+{
+  const queuebin_header_t *h = self->qb_head;
+
+  return (h->qh_master_ino  == (uint64_t)master->st_ino  &&
+          h->qh_master_size == (uint64_t)master->st_size &&
+          h->qh_master_sec  == master->st_mtim.tv_sec    &&
+          h->qh_master_nsec == master->st_mtim.tv_nsec);
+}
+
+/* ------------------------------------------------------------------------- *
+ * queuebin_get_snooze
+ * ------------------------------------------------------------------------- */
+
+unsigned
+queuebin_get_snooze(const queuebin_t *self)
+{
+  return self->qb_head->qh_snooze;
+}
+
+/* ------------------------------------------------------------------------- *
+ * queuebin_get_journal
+ * ------------------------------------------------------------------------- */
+
+unsigned
+queuebin_get_journal(const queuebin_t *self)
+{
+  return self->qb_head->qh_journal;
+}
+
+/* ------------------------------------------------------------------------- *
+ * queuebin_get_count
+ * ------------------------------------------------------------------------- */
+
+size_t
+queuebin_get_count(const queuebin_t *self)
+{
+  return self->qb_head->qh_event_cnt;
+}
+
+/* ------------------------------------------------------------------------- *
+ * queuebin_get_cookie
+ * ------------------------------------------------------------------------- */
+
+cookie_t
+queuebin_get_cookie(const queuebin_t *self, size_t i)
+{
+  return (i < self->qb_head->qh_event_cnt) ? self->qb_event[i].qe_cookie : 0;
+}
+
+/* ------------------------------------------------------------------------- *
+ * queuebin_get_hash
+ * ------------------------------------------------------------------------- */
+
+uint64_t
+queuebin_get_hash(const queuebin_t *self, size_t i)
+{
+  return (i < self->qb_head->qh_event_cnt) ? self->qb_event[i].qe_hash : 0;
+}
+
+/* ------------------------------------------------------------------------- *
+ * queuebin_get_event  --  materialize i'th event
+ * ------------------------------------------------------------------------- */
+
+alarm_event_t *
+queuebin_get_event(const queuebin_t *self, size_t i)
+{
+  const queuebin_header_t *h = self->qb_head;
+  const queuebin_event_t  *r = 0;
+  alarm_event_t           *e = 0;
+
+  if( i >= h->qh_event_cnt )
+  {
+    goto cleanup;
+  }
+
+  r = &self->qb_event[i];
+
+  if( (uint64_t)r->qe_action_idx + r->qe_action_cnt > h->qh_action_cnt ||
+      (uint64_t)r->qe_recur_idx  + r->qe_recur_cnt  > h->qh_recur_cnt  ||
+      (uint64_t)r->qe_attr_idx   + r->qe_attr_cnt   > h->qh_attr_cnt )
+  {
+    log_warning("binary queue: event %zd: %s\n", i, "bad table range");
+    goto cleanup;
+  }
+
+  /* - - - - - - - - - - - - - - - - - - - *
+   * fill in the same way as the text file
+   * loader does, i.e. strings are never NULL
+   * - - - - - - - - - - - - - - - - - - - */
+
+  e = alarm_event_create();
+
+  alarm_event_add_actions(e, r->qe_action_cnt);
+  alarm_event_add_recurrences(e, r->qe_recur_cnt);
+
+  e->ALARMD_PRIVATE(cookie)  = r->qe_cookie;
+  e->ALARMD_PRIVATE(trigger) = r->qe_trigger;
+
+  xstrset(&e->title,             queuebin_str(self, r->qe_title));
+  xstrset(&e->message,           queuebin_str(self, r->qe_message));
+  unique_strset(&e->sound,       queuebin_str(self, r->qe_sound));
+  unique_strset(&e->icon,        queuebin_str(self, r->qe_icon));
+  e->flags = r->qe_flags;
+
+  unique_strset(&e->alarm_appid, queuebin_str(self, r->qe_alarm_appid));
+
+  e->alarm_time         = r->qe_alarm_time;
+
+  e->alarm_tm.tm_year   = r->qe_alarm_tm[0];
+  e->alarm_tm.tm_mon    = r->qe_alarm_tm[1];
+  e->alarm_tm.tm_mday   = r->qe_alarm_tm[2];
+  e->alarm_tm.tm_hour   = r->qe_alarm_tm[3];
+  e->alarm_tm.tm_min    = r->qe_alarm_tm[4];
+  e->alarm_tm.tm_sec    = r->qe_alarm_tm[5];
+  e->alarm_tm.tm_wday   = r->qe_alarm_tm[6];
+  e->alarm_tm.tm_yday   = r->qe_alarm_tm[7];
+  e->alarm_tm.tm_isdst  = r->qe_alarm_tm[8];
+
+  unique_strset(&e->alarm_tz, queuebin_str(self, r->qe_alarm_tz));
+
+  e->recur_secs         = r->qe_recur_secs;
+  e->recur_count        = r->qe_recur_count;
+  e->snooze_secs        = r->qe_snooze_secs;
+  e->snooze_total       = r->qe_snooze_total;
+
+  for( size_t k = 0; k < e->action_cnt; ++k )
+  {
+    const queuebin_action_t *b = &self->qb_action[r->qe_action_idx + k];
+    alarm_action_t          *a = &e->action_tab[k];
+
+    a->flags = b->qa_flags;
+    xstrset(&a->label,                queuebin_str(self, b->qa_label));
+    xstrset(&a->exec_command,         queuebin_str(self, b->qa_exec_command));
+    unique_strset(&a->dbus_interface, queuebin_str(self, b->qa_dbus_interface));
+    unique_strset(&a->dbus_service,   queuebin_str(self, b->qa_dbus_service));
+    unique_strset(&a->dbus_path,      queuebin_str(self, b->qa_dbus_path));
+    unique_strset(&a->dbus_name,      queuebin_str(self, b->qa_dbus_name));
+    xstrset(&a->dbus_args,            queuebin_str(self, b->qa_dbus_args));
+  }
+
+  for( size_t k = 0; k < e->recurrence_cnt; ++k )
+  {
+    const queuebin_recur_t *b = &self->qb_recur[r->qe_recur_idx + k];
+    alarm_recur_t          *a = &e->recurrence_tab[k];
+
+    a->mask_min  = b->qr_mask_min;
+    a->mask_hour = b->qr_mask_hour;
+    a->mask_mday = b->qr_mask_mday;
+    a->mask_wday = b->qr_mask_wday;
+    a->mask_mon  = b->qr_mask_mon;
+    a->special   = b->qr_special;
+  }
+
+  for( size_t k = 0; k < r->qe_attr_cnt; ++k )
+  {
+    const queuebin_attr_t *b = &self->qb_attr[r->qe_attr_idx + k];
+    alarm_attr_t          *a = alarm_event_add_attr(e, queuebin_str(self, b->qt_name));
+
+    alarm_attr_set_null(a);
+    a->attr_type = b->qt_type;
+
+    switch( a->attr_type )
+    {
+    case ALARM_ATTR_INT:
+      a->attr_data.ival = b->qt_value;
+      break;
+    case ALARM_ATTR_TIME:
+      a->attr_data.tval = b->qt_value;
+      break;
+    case ALARM_ATTR_STRING:
+      a->attr_data.sval = 0;
+      xstrset(&a->attr_data.sval, queuebin_str(self, b->qt_value));
+      break;
+    }
+  }
+
+  cleanup:
+
+  return e;
+}
+
+/* ------------------------------------------------------------------------- *
+ * queuebin_find_event  --  materialize event by cookie
+ * ------------------------------------------------------------------------- */
+
+alarm_event_t *
+queuebin_find_event(const queuebin_t *self, cookie_t cookie)
+{
+  size_t lo = 0;
+  size_t hi = self->qb_head->qh_event_cnt;
+
+  while( lo < hi )
+  {
+    size_t i = (lo + hi) / 2;
+
+    if( self->qb_event[i].qe_cookie < cookie )
+    {
+      lo = i + 1;
+    }
+    else
+    {
+      hi = i;
+    }
+  }
+
+  if( lo < self->qb_head->qh_event_cnt &&
+      self->qb_event[lo].qe_cookie == cookie )
+  {
+    return queuebin_get_event(self, lo);
+  }
+  return 0;
+}
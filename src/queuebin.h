@@ -0,0 +1,73 @@
+/* ========================================================================= *
+ *
+ * This file is part of Alarmd
+ *
+ * Copyright (C) 2008-2009 Nokia Corporation and/or its subsidiary(-ies).
+ *
+ * Contact: Simo Piiroinen <simo.piiroinen@nokia.com>
+ *
+ * Alarmd is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * version 2.1 as published by the Free Software Foundation.
+ *
+ * Alarmd is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with Alarmd; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA
+ * 02110-1301 USA
+ *
+ * ========================================================================= */
+
+#ifndef QUEUEBIN_H_
+#define QUEUEBIN_H_
+
+#include "libalarm.h"
+
+#include <sys/stat.h>
+
+#ifdef __cplusplus
+extern "C" {
+#elif 0
+} /* fool JED indentation ... */
+#endif
+
+typedef struct queuebin_t queuebin_t;
+
+/* ------------------------------------------------------------------------- *
+ * Binary copy of the queue file
+ *
+ * Events are stored as fixed size records sorted by cookie, with
+ * actions, recurrences and attributes in tables of their own and all
+ * strings in a shared string table. The file is mapped to memory on
+ * open and events are materialized only when asked for.
+ *
+ * The binary file records the identity of the text file it was made
+ * from; queuebin_is_copy_of() tells whether it is still up to date.
+ * Each event also carries a caller supplied hash, so that the queue
+ * code does not need to reformat events loaded from the copy.
+ *
+ * The format uses native byte order and is not meant to be moved
+ * between devices; files of other versions or byte order are rejected.
+ * ------------------------------------------------------------------------- */
+
+int            queuebin_encode     (char **pdata, size_t *psize, unsigned snooze, unsigned journal, const struct stat *master, alarm_event_t **vec, const uint64_t *hash);
+queuebin_t    *queuebin_open       (const char *path);
+void           queuebin_close      (queuebin_t *self);
+int            queuebin_is_copy_of (const queuebin_t *self, const struct stat *master);
+unsigned       queuebin_get_snooze (const queuebin_t *self);
+unsigned       queuebin_get_journal(const queuebin_t *self);
+size_t         queuebin_get_count  (const queuebin_t *self);
+cookie_t       queuebin_get_cookie (const queuebin_t *self, size_t i);
+uint64_t       queuebin_get_hash   (const queuebin_t *self, size_t i);
+alarm_event_t *queuebin_get_event  (const queuebin_t *self, size_t i);
+alarm_event_t *queuebin_find_event (const queuebin_t *self, cookie_t cookie);
+
+#ifdef __cplusplus
+};
+#endif
+
+#endif /* QUEUEBIN_H_ */
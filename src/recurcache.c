@@ -0,0 +1,388 @@
+/* ========================================================================= *
+ *
+ * This file is part of Alarmd
+ *
+ * Copyright (C) 2008-2009 Nokia Corporation and/or its subsidiary(-ies).
+ *
+ * Contact: Simo Piiroinen <simo.piiroinen@nokia.com>
+ *
+ * Alarmd is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * version 2.1 as published by the Free Software Foundation.
+ *
+ * Alarmd is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with Alarmd; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA
+ * 02110-1301 USA
+ *
+ * ========================================================================= */
+
+#include "alarmd_config.h"
+
+#include "recurcache.h"
+#include "ticker.h"
+#include "tzfile.h"
+#include "xutil.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+/* ========================================================================= *
+ * Which results can be reused
+ *
+ * In general the result of mask alignment depends on the starting
+ * point in non-obvious ways: fields without masks are carried over
+ * from the start time, and hour/day stepping keeps the minute found
+ * for the first allowed hour.
+ *
+ * For "canonical" recurrences (exactly one minute, exactly one hour
+ * or no hour and no date masks, no special handling) the result is
+ * simply the first matching minute at or after the start time. Then
+ * a list of consecutive occurrences can answer any query that falls
+ * in the range it was computed for -- provided that the utc offset
+ * of the zone does not change within or shortly before that range.
+ *
+ * Everything else is evaluated directly every time.
+ * ========================================================================= */
+
+/* Number of upcoming occurrences cached per recurrence table entry */
+#define RECURCACHE_DEPTH 4
+
+/* Local times shortly after utc offset change can be ambiguous and
+ * map to utc times before the query time -> require stable offset
+ * also for some time before the query */
+#define RECURCACHE_MARGIN (2 * 24 * 60 * 60)
+
+typedef struct recurslot_t recurslot_t;
+
+/* ------------------------------------------------------------------------- *
+ * recurslot_t  --  upcoming occurrences for one recurrence table entry
+ * ------------------------------------------------------------------------- */
+
+struct recurslot_t
+{
+  /* lowest query time the occurrences are valid for */
+  time_t rs_base;
+
+  /* consecutive matches starting from rs_base */
+  int    rs_count;
+  time_t rs_occ[RECURCACHE_DEPTH];
+};
+
+/* ------------------------------------------------------------------------- *
+ * recurcache_t  --  per event cache
+ * ------------------------------------------------------------------------- */
+
+struct recurcache_t
+{
+  /* key: zone name, zone data generation and recurrence masks */
+  char          *rc_tz;
+  unsigned       rc_gen;
+  size_t         rc_count;
+  alarm_recur_t *rc_recur;
+
+  /* rc_count slots */
+  recurslot_t   *rc_slot;
+};
+
+/* Bumped whenever zone data may have changed */
+static unsigned recurcache_gen = 1;
+
+/* ========================================================================= *
+ * recurcache_t  --  internal helpers
+ * ========================================================================= */
+
+/* ------------------------------------------------------------------------- *
+ * recurcache_do_align  --  uncached alarm_recur_align() for utc time
+ * ------------------------------------------------------------------------- */
+
+static time_t
+recurcache_do_align(const alarm_recur_t *rec, const char *tz, time_t t)
+{
+  struct tm tm;
+  ticker_break_tm(t, &tm, tz);
+  return alarm_recur_align(rec, &tm, tz);
+}
+
+/* ------------------------------------------------------------------------- *
+ * recurcache_do_next  --  uncached alarm_recur_next() for utc time
+ * ------------------------------------------------------------------------- */
+
+static time_t
+recurcache_do_next(const alarm_recur_t *rec, const char *tz, time_t t)
+{
+  struct tm tm;
+  ticker_break_tm(t, &tm, tz);
+  return alarm_recur_next(rec, &tm, tz);
+}
+
+/* ------------------------------------------------------------------------- *
+ * recurcache_is_canonical  --  result is the first matching minute
+ * ------------------------------------------------------------------------- */
+
+static int
+recurcache_is_canonical(const alarm_recur_t *rec)
+{
+  uint64_t m = rec->mask_min  & ALARM_RECUR_MIN_ALL;
+  uint32_t h = rec->mask_hour & ALARM_RECUR_HOUR_ALL;
+
+  int dates = ((rec->mask_wday & ALARM_RECUR_WDAY_ALL) ||
+               (rec->mask_mday & (ALARM_RECUR_MDAY_ALL|ALARM_RECUR_MDAY_EOM)) ||
+               (rec->mask_mon  & ALARM_RECUR_MON_ALL));
+
+  if( rec->special != ALARM_RECUR_SPECIAL_NONE )
+  {
+    return 0;
+  }
+
+  if( m == 0 || (m & (m - 1)) != 0 )
+  {
+    return 0;
+  }
+
+  if( h == 0 )
+  {
+    return !dates;
+  }
+
+  return (h & (h - 1)) == 0;
+}
+
+/* ------------------------------------------------------------------------- *
+ * recurcache_same_recur
+ * ------------------------------------------------------------------------- */
+
+static int
+recurcache_same_recur(const alarm_recur_t *a, const alarm_recur_t *b)
+{
+  return (a->mask_min  == b->mask_min  &&
+          a->mask_hour == b->mask_hour &&
+          a->mask_mday == b->mask_mday &&
+          a->mask_wday == b->mask_wday &&
+          a->mask_mon  == b->mask_mon  &&
+          a->special   == b->special);
+}
+
+/* ------------------------------------------------------------------------- *
+ * recurcache_is_valid  --  cache key matches event and zone
+ * ------------------------------------------------------------------------- */
+
+static int
+recurcache_is_valid(const recurcache_t *self, const alarm_event_t *eve,
+                    const char *tz)
+{
+  if( self->rc_gen != recurcache_gen ||
+      self->rc_count != eve->recurrence_cnt ||
+      !xissame(self->rc_tz, tz) )
+  {
+    return 0;
+  }
+
+  for( size_t i = 0; i < self->rc_count; ++i )
+  {
+    if( !recurcache_same_recur(&self->rc_recur[i], &eve->recurrence_tab[i]) )
+    {
+      return 0;
+    }
+  }
+  return 1;
+}
+
+/* ------------------------------------------------------------------------- *
+ * recurcache_create  --  empty cache keyed to event and zone
+ * ------------------------------------------------------------------------- */
+
+static recurcache_t *
+recurcache_create(const alarm_event_t *eve, const char *tz)
+{
+  recurcache_t *self = calloc(1, sizeof *self);
+
+  self->rc_tz    = tz ? strdup(tz) : 0;
+  self->rc_gen   = recurcache_gen;
+  self->rc_count = eve->recurrence_cnt;
+  self->rc_recur = calloc(self->rc_count + 1, sizeof *self->rc_recur);
+  self->rc_slot  = calloc(self->rc_count + 1, sizeof *self->rc_slot);
+
+  for( size_t i = 0; i < self->rc_count; ++i )
+  {
+    self->rc_recur[i] = eve->recurrence_tab[i];
+  }
+
+  return self;
+}
+
+/* ------------------------------------------------------------------------- *
+ * recurcache_get_slot  --  get valid slot, re-creating cache if needed
+ * ------------------------------------------------------------------------- */
+
+static recurslot_t *
+recurcache_get_slot(recurcache_t **pcache, const alarm_event_t *eve,
+                    size_t i, const char *tz)
+{
+  if( *pcache == 0 || !recurcache_is_valid(*pcache, eve, tz) )
+  {
+    recurcache_delete(*pcache);
+    *pcache = recurcache_create(eve, tz);
+  }
+  return &(*pcache)->rc_slot[i];
+}
+
+/* ------------------------------------------------------------------------- *
+ * recurslot_covers  --  query can be answered from cached occurrences
+ * ------------------------------------------------------------------------- */
+
+static int
+recurslot_covers(const recurslot_t *self, time_t t, int next)
+{
+  if( self->rs_count <= 0 || t < self->rs_base )
+  {
+    return 0;
+  }
+
+  time_t last = self->rs_occ[self->rs_count - 1];
+
+  return next ? (t < last) : (t <= last);
+}
+
+/* ------------------------------------------------------------------------- *
+ * recurslot_find  --  first occurrence at or after / after given time
+ * ------------------------------------------------------------------------- */
+
+static time_t
+recurslot_find(const recurslot_t *self, time_t t, int next)
+{
+  int i = 0;
+
+  while( next ? (self->rs_occ[i] <= t) : (self->rs_occ[i] < t) )
+  {
+    ++i;
+  }
+  return self->rs_occ[i];
+}
+
+/* ------------------------------------------------------------------------- *
+ * recurslot_fill  --  compute occurrences starting from given time
+ *
+ * Returns alarm_recur_align() result for t.
+ * ------------------------------------------------------------------------- */
+
+static time_t
+recurslot_fill(recurslot_t *self, const alarm_recur_t *rec,
+               const char *tz, time_t t)
+{
+  time_t lim = 0;
+  int    has = tzfile_next_change(tz, t - RECURCACHE_MARGIN, &lim);
+  time_t res = recurcache_do_align(rec, tz, t);
+
+  self->rs_base  = t;
+  self->rs_count = 0;
+
+  if( has == -1 || res == -1 || res < t || (has && res >= lim) )
+  {
+    // zone not supported, no match or offset change before match
+    return res;
+  }
+
+  self->rs_occ[self->rs_count++] = res;
+
+  while( self->rs_count < RECURCACHE_DEPTH )
+  {
+    time_t prev = self->rs_occ[self->rs_count - 1];
+    time_t curr = recurcache_do_align(rec, tz, prev + 60);
+
+    if( curr == -1 || curr <= prev || (has && curr >= lim) )
+    {
+      break;
+    }
+    self->rs_occ[self->rs_count++] = curr;
+  }
+
+  return res;
+}
+
+/* ------------------------------------------------------------------------- *
+ * recurcache_lookup
+ * ------------------------------------------------------------------------- */
+
+static time_t
+recurcache_lookup(recurcache_t **pcache, const alarm_event_t *eve,
+                  size_t i, const char *tz, time_t t, int next)
+{
+  const alarm_recur_t *rec = &eve->recurrence_tab[i];
+
+  if( pcache == 0 || !recurcache_is_canonical(rec) )
+  {
+    return next ? recurcache_do_next(rec, tz, t) : recurcache_do_align(rec, tz, t);
+  }
+
+  recurslot_t *slot = recurcache_get_slot(pcache, eve, i, tz);
+
+  if( !recurslot_covers(slot, t, next) )
+  {
+    time_t res = recurslot_fill(slot, rec, tz, t);
+
+    if( !recurslot_covers(slot, t, next) )
+    {
+      return next ? recurcache_do_next(rec, tz, t) : res;
+    }
+  }
+
+  return recurslot_find(slot, t, next);
+}
+
+/* ========================================================================= *
+ * recurcache_t  --  methods
+ * ========================================================================= */
+
+/* ------------------------------------------------------------------------- *
+ * recurcache_delete
+ * ------------------------------------------------------------------------- */
+
+void
+recurcache_delete(recurcache_t *self)
+{
+  if( self != 0 )
+  {
+    free(self->rc_tz);
+    free(self->rc_recur);
+    free(self->rc_slot);
+    free(self);
+  }
+}
+
+/* ------------------------------------------------------------------------- *
+ * recurcache_flush  --  invalidate all caches after zone data change
+ * ------------------------------------------------------------------------- */
+
+void
+recurcache_flush(void)
+{
+  recurcache_gen += 1;
+}
+
+/* ------------------------------------------------------------------------- *
+ * recurcache_align  --  cached alarm_recur_align()
+ * ------------------------------------------------------------------------- */
+
+time_t
+recurcache_align(recurcache_t **pcache, const alarm_event_t *eve, size_t i,
+                 const char *tz, time_t t)
+{
+  return recurcache_lookup(pcache, eve, i, tz, t, 0);
+}
+
+/* ------------------------------------------------------------------------- *
+ * recurcache_next  --  cached alarm_recur_next()
+ * ------------------------------------------------------------------------- */
+
+time_t
+recurcache_next(recurcache_t **pcache, const alarm_event_t *eve, size_t i,
+                const char *tz, time_t t)
+{
+  return recurcache_lookup(pcache, eve, i, tz, t, 1);
+}
@@ -0,0 +1,61 @@
+/* ========================================================================= *
+ *
+ * This file is part of Alarmd
+ *
+ * Copyright (C) 2008-2009 Nokia Corporation and/or its subsidiary(-ies).
+ *
+ * Contact: Simo Piiroinen <simo.piiroinen@nokia.com>
+ *
+ * Alarmd is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * version 2.1 as published by the Free Software Foundation.
+ *
+ * Alarmd is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with Alarmd; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA
+ * 02110-1301 USA
+ *
+ * ========================================================================= */
+
+#ifndef RECURCACHE_H_
+#define RECURCACHE_H_
+
+#include "libalarm.h"
+
+#ifdef __cplusplus
+extern "C" {
+#elif 0
+} /* fool JED indentation ... */
+#endif
+
+typedef struct recurcache_t recurcache_t;
+
+/* ------------------------------------------------------------------------- *
+ * Memoized recurrence mask evaluation
+ *
+ * recurcache_align() and recurcache_next() return the same values as
+ * alarm_recur_align() / alarm_recur_next() applied to time t broken
+ * down in zone tz, for the i'th entry in the recurrence table of the
+ * event.
+ *
+ * Upcoming occurrences are cached in *pcache and reused as long as the
+ * zone name, the recurrence masks and the zone data generation stay the
+ * same and t stays within the range the occurrences were computed for.
+ * Passing a NULL pcache disables caching.
+ * ------------------------------------------------------------------------- */
+
+void   recurcache_delete(recurcache_t *self);
+void   recurcache_flush (void);
+time_t recurcache_align (recurcache_t **pcache, const alarm_event_t *eve, size_t i, const char *tz, time_t t);
+time_t recurcache_next  (recurcache_t **pcache, const alarm_event_t *eve, size_t i, const char *tz, time_t t);
+
+#ifdef __cplusplus
+};
+#endif
+
+#endif /* RECURCACHE_H_ */
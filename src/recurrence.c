@@ -26,9 +26,12 @@
 
 #include "libalarm.h"
 #include "ticker.h"
+#include "tzfile.h"
 #include "logging.h"
 
 #include <stdlib.h>
+#include <stdint.h>
+#include <time.h>
 
 /* ========================================================================= *
  * alarm_recur_t  --  methods
@@ -110,13 +113,48 @@ alarm_recur_delete_cb(void *self)
 }
 
 /* ------------------------------------------------------------------------- *
- * alarm_recur_handle_masks
+ * alarm_recur_build_tm  --  normalize a mask scanning step
+ *
+ * As ticker_build_tm_guess_dst(), except that with ALARMD_RECUR_GAP_FORWARD
+ * enabled skipped local time is always resolved to after the gap.
  * ------------------------------------------------------------------------- */
 
 static
 time_t
-alarm_recur_handle_masks(const alarm_recur_t *self, struct tm *dst,
-                         const char *tz, int align_only)
+alarm_recur_build_tm(struct tm *tm, const char *tz)
+{
+#if ALARMD_RECUR_GAP_FORWARD
+  struct tm want = *tm;
+  time_t    res  = ticker_build_tm_guess_dst(tm, tz);
+
+  if( res != -1 )
+  {
+    struct tm have = *tm;
+    time_t    skip = timegm(&want) - timegm(&have);
+
+    if( skip > 0 )
+    {
+      res += skip;
+      ticker_break_tm(res, tm, tz);
+    }
+  }
+  return res;
+#else
+  return ticker_build_tm_guess_dst(tm, tz);
+#endif
+}
+
+/* ------------------------------------------------------------------------- *
+ * alarm_recur_scan_masks  --  step field by field until masks match
+ *
+ * Reference implementation: every step is normalized via mktime.
+ * Used when the time zone is not supported by alarm_recur_solve_masks().
+ * ------------------------------------------------------------------------- */
+
+static
+time_t
+alarm_recur_scan_masks(const alarm_recur_t *self, struct tm *dst,
+                       const char *tz, int align_only)
 {
   time_t    res = -1;
   int       inc = (align_only == 0);
@@ -128,7 +166,7 @@ alarm_recur_handle_masks(const alarm_recur_t *self, struct tm *dst,
   if( dst->tm_sec != 0 )
   {
     inc = 0, dst->tm_min += 1, dst->tm_sec = 0;
-    if( (res = ticker_build_tm_guess_dst(dst, tz)) == -1 )
+    if( (res = alarm_recur_build_tm(dst, tz)) == -1 )
     {
       goto cleanup;
     }
@@ -140,7 +178,7 @@ alarm_recur_handle_masks(const alarm_recur_t *self, struct tm *dst,
   {
     for( dst->tm_min += inc, inc = 0; ; dst->tm_min += 1 )
     {
-      if( (res = ticker_build_tm_guess_dst(dst, tz)) == -1 )
+      if( (res = alarm_recur_build_tm(dst, tz)) == -1 )
       {
         goto cleanup;
       }
@@ -157,7 +195,7 @@ alarm_recur_handle_masks(const alarm_recur_t *self, struct tm *dst,
   {
     for( dst->tm_hour += inc, inc = 0; ; dst->tm_hour += 1 )
     {
-      if( (res = ticker_build_tm_guess_dst(dst, tz)) == -1 )
+      if( (res = alarm_recur_build_tm(dst, tz)) == -1 )
       {
         goto cleanup;
       }
@@ -196,7 +234,7 @@ alarm_recur_handle_masks(const alarm_recur_t *self, struct tm *dst,
 
     for( dst->tm_mday += inc, inc = 0;; )
     {
-      if( (res = ticker_build_tm_guess_dst(dst, tz)) == -1 )
+      if( (res = alarm_recur_build_tm(dst, tz)) == -1 )
       {
         goto cleanup;
       }
@@ -228,6 +266,407 @@ alarm_recur_handle_masks(const alarm_recur_t *self, struct tm *dst,
   return res;
 }
 
+/* ========================================================================= *
+ * alarm_recur_solver_t  --  mktime free mask solver
+ *
+ * Produces exactly the same results as alarm_recur_scan_masks(), but
+ * jumps directly to the next allowed minute / hour and walks days
+ * using plain calendar arithmetic.
+ *
+ * Normalizing a valid local time via mktime() does not change the
+ * broken down fields, only steps that land on a local time skipped
+ * by a dst change get shifted. The solver keeps track of the next
+ * such range and falls back to mktime() only for steps that hit it.
+ * ========================================================================= */
+
+#define DAY (24 * 60 * 60)
+
+/* Gregorian calendar repeats itself every 400 years */
+#define ALARM_RECUR_SOLVER_HORIZON (146097LL * DAY)
+
+typedef struct
+{
+  const char *tz;
+
+  /* local wall clock seconds of the current candidate */
+  int64_t     loc;
+
+  /* next skipped local time range ending after loc */
+  int         gap_valid;
+  int64_t     gap_beg;
+  int64_t     gap_end;
+
+  /* mktime equivalent steps taken */
+  int         steps;
+} alarm_recur_solver_t;
+
+/* ------------------------------------------------------------------------- *
+ * alarm_recur_solver_days_from_civil  --  year, month (1-12), mday -> days
+ * ------------------------------------------------------------------------- */
+
+static int64_t
+alarm_recur_solver_days_from_civil(int64_t y, int m, int d)
+{
+  y -= (m <= 2);
+
+  int64_t  era = (y >= 0 ? y : y - 399) / 400;
+  unsigned yoe = (unsigned)(y - era * 400);
+  unsigned doy = (153 * (m + (m > 2 ? -3 : 9)) + 2) / 5 + d - 1;
+  unsigned doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+
+  return era * 146097 + (int64_t)doe - 719468;
+}
+
+/* ------------------------------------------------------------------------- *
+ * alarm_recur_solver_floor_div  --  integer division rounding towards -inf
+ * ------------------------------------------------------------------------- */
+
+static inline int64_t
+alarm_recur_solver_floor_div(int64_t a, int64_t b)
+{
+  return (a >= 0) ? (a / b) : -((b - 1 - a) / b);
+}
+
+/* ------------------------------------------------------------------------- *
+ * alarm_recur_solver_get_loc  --  struct tm -> local wall clock seconds
+ * ------------------------------------------------------------------------- */
+
+static int64_t
+alarm_recur_solver_get_loc(const struct tm *tm)
+{
+  int64_t mon  = tm->tm_mon;
+  int64_t year = tm->tm_year + 1900LL + alarm_recur_solver_floor_div(mon, 12);
+
+  mon -= alarm_recur_solver_floor_div(mon, 12) * 12;
+
+  return ((alarm_recur_solver_days_from_civil(year, (int)mon + 1, 1) +
+           tm->tm_mday - 1) * DAY +
+          tm->tm_hour * 3600LL + tm->tm_min * 60LL + tm->tm_sec);
+}
+
+/* ------------------------------------------------------------------------- *
+ * alarm_recur_solver_set_loc  --  local wall clock seconds -> struct tm
+ * ------------------------------------------------------------------------- */
+
+static void
+alarm_recur_solver_set_loc(struct tm *tm, int64_t loc)
+{
+  int64_t z    = alarm_recur_solver_floor_div(loc, DAY);
+  int64_t secs = loc - z * DAY;
+  int64_t days = z + 719468;
+
+  int64_t  era = (days >= 0 ? days : days - 146096) / 146097;
+  unsigned doe = (unsigned)(days - era * 146097);
+  unsigned yoe = (doe - doe / 1460 + doe / 36524 - doe / 146096) / 365;
+  unsigned doy = doe - (365 * yoe + yoe / 4 - yoe / 100);
+  unsigned mp  = (5 * doy + 2) / 153;
+  unsigned m   = (mp < 10) ? (mp + 3) : (mp - 9);
+  int64_t  y   = (int64_t)yoe + era * 400 + (m <= 2);
+
+  tm->tm_sec  = (int)(secs % 60);
+  tm->tm_min  = (int)(secs / 60 % 60);
+  tm->tm_hour = (int)(secs / 3600);
+  tm->tm_mday = doy - (153 * mp + 2) / 5 + 1;
+  tm->tm_mon  = m - 1;
+  tm->tm_year = (int)(y - 1900);
+  tm->tm_wday = (int)(((z % 7) + 11) % 7);
+  tm->tm_yday = (int)(z - alarm_recur_solver_days_from_civil(y, 1, 1));
+}
+
+/* ------------------------------------------------------------------------- *
+ * alarm_recur_solver_update_gap  --  make sure gap range ends after loc
+ * ------------------------------------------------------------------------- */
+
+static int
+alarm_recur_solver_update_gap(alarm_recur_solver_t *self)
+{
+  time_t beg, end;
+
+  while( self->gap_valid && self->gap_end <= self->loc )
+  {
+    switch( tzfile_next_gap(self->tz, self->loc, &beg, &end) )
+    {
+    case 1:
+      self->gap_beg = beg;
+      self->gap_end = end;
+      break;
+
+    case 0:
+      self->gap_valid = 0;
+      break;
+
+    default:
+      return -1;
+    }
+  }
+  return 0;
+}
+
+/* ------------------------------------------------------------------------- *
+ * alarm_recur_solver_normalize  --  mktime() equivalent for a step
+ * ------------------------------------------------------------------------- */
+
+static int
+alarm_recur_solver_normalize(alarm_recur_solver_t *self, struct tm *tm)
+{
+  self->steps += 1;
+  self->loc = alarm_recur_solver_get_loc(tm);
+
+  if( alarm_recur_solver_update_gap(self) == -1 )
+  {
+    return -1;
+  }
+
+  if( self->gap_valid && self->gap_beg <= self->loc )
+  {
+    // skipped local time, let mktime decide where it goes
+    if( alarm_recur_build_tm(tm, self->tz) == -1 )
+    {
+      return -1;
+    }
+    self->loc = alarm_recur_solver_get_loc(tm);
+    return alarm_recur_solver_update_gap(self);
+  }
+
+  alarm_recur_solver_set_loc(tm, self->loc);
+  return 0;
+}
+
+/* ------------------------------------------------------------------------- *
+ * alarm_recur_solver_scan  --  advance minutes/hours to next bit in mask
+ * ------------------------------------------------------------------------- */
+
+static int
+alarm_recur_solver_scan(alarm_recur_solver_t *self, struct tm *tm,
+                        int *field, int range, uint64_t mask, int unit)
+{
+  while( !(mask & (1llu << *field)) )
+  {
+    // steps needed to reach the next set bit, possibly wrapping over
+    uint64_t above = mask & (~0llu << (*field + 1));
+
+    int64_t  steps = (above ? __builtin_ctzll(above)
+                      : range + __builtin_ctzll(mask)) - *field;
+
+    // but stop at the first step that hits the next skipped range
+    if( self->gap_valid )
+    {
+      int64_t hit = (self->gap_beg - self->loc + unit - 1) / unit;
+      if( 0 < hit && hit < steps )
+      {
+        steps = hit;
+      }
+    }
+
+    *field += (int)steps;
+
+    if( alarm_recur_solver_normalize(self, tm) == -1 )
+    {
+      return -1;
+    }
+  }
+  return 0;
+}
+
+/* ------------------------------------------------------------------------- *
+ * alarm_recur_solver_add_days  --  advance whole days within a month
+ * ------------------------------------------------------------------------- */
+
+static int
+alarm_recur_solver_add_days(alarm_recur_solver_t *self, struct tm *tm,
+                            int days)
+{
+  int dim = ticker_get_days_in_month(tm);
+
+  self->steps += 1;
+  self->loc   += days * (int64_t)DAY;
+
+  tm->tm_wday  = (tm->tm_wday + days) % 7;
+  tm->tm_yday += days;
+
+  if( (tm->tm_mday += days) > dim )
+  {
+    tm->tm_mday -= dim;
+    if( ++tm->tm_mon == 12 )
+    {
+      tm->tm_mon  = 0;
+      tm->tm_yday = tm->tm_mday - 1;
+      tm->tm_year += 1;
+    }
+  }
+
+  if( alarm_recur_solver_update_gap(self) == -1 )
+  {
+    return -1;
+  }
+
+  if( self->gap_valid && self->gap_beg <= self->loc )
+  {
+    return alarm_recur_solver_normalize(self, tm);
+  }
+  return 0;
+}
+
+/* ------------------------------------------------------------------------- *
+ * alarm_recur_solve_masks  --  alarm_recur_scan_masks() without the mktimes
+ *
+ * Returns -1 if the time zone is not supported, 0 otherwise.
+ * ------------------------------------------------------------------------- */
+
+static int
+alarm_recur_solve_masks(const alarm_recur_t *self, struct tm *dst,
+                        const char *tz, int align_only, time_t *pres)
+{
+  alarm_recur_solver_t solver =
+  {
+    .tz        = tz,
+    .loc       = alarm_recur_solver_get_loc(dst),
+    .gap_valid = 1,
+    .gap_beg   = 0,
+    .gap_end   = INT64_MIN,
+    .steps     = 0,
+  };
+
+  int     inc = (align_only == 0);
+  int64_t lim = solver.loc + ALARM_RECUR_SOLVER_HORIZON;
+
+  *pres = -1;
+
+  if( alarm_recur_solver_update_gap(&solver) == -1 )
+  {
+    return -1;
+  }
+
+  // SECONDS
+  if( dst->tm_sec != 0 )
+  {
+    inc = 0, dst->tm_min += 1, dst->tm_sec = 0;
+    if( alarm_recur_solver_normalize(&solver, dst) == -1 )
+    {
+      return -1;
+    }
+  }
+
+  // MINUTES
+  if( self->mask_min & ALARM_RECUR_MIN_ALL )
+  {
+    dst->tm_min += inc, inc = 0;
+    if( alarm_recur_solver_normalize(&solver, dst) == -1 ||
+        alarm_recur_solver_scan(&solver, dst, &dst->tm_min, 60,
+                                self->mask_min & ALARM_RECUR_MIN_ALL,
+                                60) == -1 )
+    {
+      return -1;
+    }
+  }
+
+  // HOURS
+  if( self->mask_hour & ALARM_RECUR_HOUR_ALL )
+  {
+    dst->tm_hour += inc, inc = 0;
+    if( alarm_recur_solver_normalize(&solver, dst) == -1 ||
+        alarm_recur_solver_scan(&solver, dst, &dst->tm_hour, 24,
+                                self->mask_hour & ALARM_RECUR_HOUR_ALL,
+                                60 * 60) == -1 )
+    {
+      return -1;
+    }
+  }
+
+  // DAY OF MONTH and DAY OF WEEK and MONTH
+
+  uint32_t M_wday = self->mask_wday & ALARM_RECUR_WDAY_ALL;
+  uint32_t M_mday = self->mask_mday & ALARM_RECUR_MDAY_ALL;
+  uint32_t M_eom  = self->mask_mday & ALARM_RECUR_MDAY_EOM;
+  uint32_t M_mon  = self->mask_mon  & ALARM_RECUR_MON_ALL;
+
+  if( M_wday || M_mday || M_eom || M_mon )
+  {
+    if( M_wday == 0 )
+    {
+      M_wday = ALARM_RECUR_WDAY_ALL;
+    }
+    if( M_mday == 0 && M_eom == 0 )
+    {
+      M_mday = ALARM_RECUR_MDAY_ALL;
+    }
+    if( M_mon == 0 )
+    {
+      M_mon = ALARM_RECUR_MON_ALL;
+    }
+
+    dst->tm_mday += inc, inc = 0;
+    if( alarm_recur_solver_normalize(&solver, dst) == -1 )
+    {
+      return -1;
+    }
+
+    for( ;; )
+    {
+      int dim = ticker_get_days_in_month(dst);
+      int add = 1;
+
+      if( solver.loc > lim )
+      {
+        // the date masks can never match
+        return 0;
+      }
+
+      if( !(M_mon & (1u << dst->tm_mon)) )
+      {
+        // skip to the 1st of the next month
+        add = dim - dst->tm_mday + 1;
+      }
+      else
+      {
+        uint32_t T_mday = M_mday;
+
+        if( M_eom )
+        {
+          T_mday |= (1u << dim);
+        }
+
+        if( (M_wday & (1<<dst->tm_wday)) && (T_mday & (1<<dst->tm_mday)) )
+        {
+          break;
+        }
+      }
+
+      if( alarm_recur_solver_add_days(&solver, dst, add) == -1 )
+      {
+        return -1;
+      }
+    }
+  }
+
+  // the final candidate is the only one that needs conversion to utc
+  if( solver.steps != 0 )
+  {
+    *pres = alarm_recur_build_tm(dst, tz);
+  }
+  return 0;
+}
+
+/* ------------------------------------------------------------------------- *
+ * alarm_recur_handle_masks
+ * ------------------------------------------------------------------------- */
+
+static
+time_t
+alarm_recur_handle_masks(const alarm_recur_t *self, struct tm *dst,
+                         const char *tz, int align_only)
+{
+  struct tm tmp = *dst;
+  time_t    res = -1;
+
+  if( alarm_recur_solve_masks(self, dst, tz, align_only, &res) == -1 )
+  {
+    *dst = tmp;
+    res = alarm_recur_scan_masks(self, dst, tz, align_only);
+  }
+  return res;
+}
+
 /* ------------------------------------------------------------------------- *
  * alarm_recur_handle_specials  --  handle special recurrency periods
  * ------------------------------------------------------------------------- */
@@ -27,9 +27,13 @@
 #include "server.h"
 #include "logging.h"
 #include "queue.h"
+#include "recurcache.h"
+#include "tzfile.h"
+#include "msgcache.h"
 #include "ticker.h"
 #include "dbusif.h"
 #include "xutil.h"
+#include "unique.h"
 #include "hwrtc.h"
 #include "serialize.h"
 #include "mainloop.h"
@@ -52,6 +56,17 @@
 #include <unistd.h>
 #include <limits.h>
 #include <assert.h>
+#include <errno.h>
+
+#if HAVE_TIMERFD
+# include <sys/timerfd.h>
+# ifndef TFD_TIMER_CANCEL_ON_SET
+#  define TFD_TIMER_CANCEL_ON_SET (1 << 1)
+# endif
+# ifndef CLOCK_REALTIME_ALARM
+#  define CLOCK_REALTIME_ALARM 8
+# endif
+#endif
 
 #define SNOOZE_HIJACK_FIX 1  // changes meaning of eve->snooze_total
 #define SNOOZE_ADJUST_FIX 1  // snooze triggers follow system time
@@ -79,6 +94,12 @@ static void                server_queuestate_invalidate         (void);
 static void                server_queuestate_init               (void);
 static void                server_queuestate_sync               (void);
 
+static void                server_queuechange_delete            (gpointer data);
+static void                server_queuechange_cb                (alarm_event_t *eve, int kind);
+static void                server_queuechange_flush             (void);
+static void                server_queuechange_init              (void);
+static void                server_queuechange_quit              (void);
+
 static void                server_limbo_disable                 (const char *reason);
 static gboolean            server_limbo_disable_cb              (gpointer data);
 static void                server_limbo_disable_delayed         (const char *reason);
@@ -112,13 +133,15 @@ static int                 server_event_evaluate_initial_trigger(alarm_event_t *
 
 static time_t              server_clock_back_delta              (void);
 static time_t              server_clock_forw_delta              (void);
-static gboolean            server_clock_source_is_stable        (void);
+static gboolean            server_clock_source_is_stable        (time_t *pdelay);
 
 static gboolean            server_wakeup_start_cb               (gpointer data);
 static void                server_cancel_wakeup                 (void);
 static void                server_request_wakeup                (time_t tmo);
+static void                server_wakeup_init                   (void);
+static void                server_wakeup_quit                   (void);
 
-static int                 server_handle_systemui_ack           (cookie_t *vec, int cnt);
+static int                 server_handle_systemui_ack           (const dbus_int32_t *vec, int cnt);
 static void                server_systemui_ack_cb               (dbus_int32_t *vec, int cnt);
 static int                 server_handle_systemui_rsp           (cookie_t cookie, int button);
 
@@ -144,6 +167,7 @@ static gboolean            server_rethink_start_cb              (gpointer data);
 static void                server_rethink_request               (int delayed);
 
 static DBusMessage        *server_handle_set_debug              (DBusMessage *msg);
+static DBusMessage        *server_handle_dump_log               (DBusMessage *msg);
 static DBusMessage        *server_handle_CUD                    (DBusMessage *msg);
 static DBusMessage        *server_handle_RFS                    (DBusMessage *msg);
 static DBusMessage        *server_handle_snooze_get             (DBusMessage *msg);
@@ -151,7 +175,10 @@ static DBusMessage        *server_handle_snooze_set             (DBusMessage *ms
 static DBusMessage        *server_handle_event_add              (DBusMessage *msg);
 static DBusMessage        *server_handle_event_update           (DBusMessage *msg);
 static DBusMessage        *server_handle_event_del              (DBusMessage *msg);
+static DBusMessage        *server_handle_events_add             (DBusMessage *msg);
+static DBusMessage        *server_handle_events_del             (DBusMessage *msg);
 static DBusMessage        *server_handle_event_query            (DBusMessage *msg);
+static DBusMessage        *server_handle_event_query_full       (DBusMessage *msg);
 static DBusMessage        *server_handle_event_get              (DBusMessage *msg);
 static DBusMessage        *server_handle_event_ack              (DBusMessage *msg);
 static DBusMessage        *server_handle_queue_ack              (DBusMessage *msg);
@@ -206,6 +233,11 @@ typedef enum alarmlimits
    */
   SERVER_QUEUE_SAVE_DELAY_MSEC = 1 * 1000,
 
+  /** Maximum number of event changes sent in one
+   *  ALARMD_QUEUE_CHANGED_IND signal.
+   */
+  SERVER_QUEUE_CHANGE_CHUNK = 256,
+
   SERVER_POWERUP_BIT = 1<<31,
 } alarmlimits;
 
@@ -810,6 +842,251 @@ server_queuestate_sync(void)
   }
 }
 
+/* ========================================================================= *
+ * Queue Change Indication
+ * ========================================================================= */
+
+typedef struct
+{
+  cookie_t  qc_cookie;  // changed event
+  int       qc_kind;    // ALARMD_QUEUE_CHANGE_xxx, 0 = nothing to report
+  time_t    qc_trigger; // trigger time after the change
+  unsigned  qc_state;   // event state after the change
+  char     *qc_appid;   // owning application, interned
+
+} server_queuechange_t;
+
+/* pending changes, cookie -> server_queuechange_t */
+static GHashTable *server_queuechange_lut = 0;
+
+/* ------------------------------------------------------------------------- *
+ * server_queuechange_delete
+ * ------------------------------------------------------------------------- */
+
+static
+void
+server_queuechange_delete(gpointer data)
+{
+  server_queuechange_t *self = data;
+
+  if( self != 0 )
+  {
+    unique_release(self->qc_appid);
+    free(self);
+  }
+}
+
+/* ------------------------------------------------------------------------- *
+ * server_queuechange_cb  --  merge event change to pending changes
+ * ------------------------------------------------------------------------- */
+
+static
+void
+server_queuechange_cb(alarm_event_t *eve, int kind)
+{
+  cookie_t              cookie = alarm_event_get_cookie(eve);
+  server_queuechange_t *self   = 0;
+
+  if( server_queuechange_lut == 0 || cookie <= 0 )
+  {
+    goto cleanup;
+  }
+
+  self = g_hash_table_lookup(server_queuechange_lut, GINT_TO_POINTER(cookie));
+
+  if( self == 0 )
+  {
+    self = calloc(1, sizeof *self);
+    self->qc_cookie = cookie;
+    self->qc_kind   = kind;
+    self->qc_appid  = unique_intern(alarm_event_get_alarm_appid(eve));
+    g_hash_table_insert(server_queuechange_lut, GINT_TO_POINTER(cookie), self);
+  }
+  else if( kind == ALARMD_QUEUE_CHANGE_DELETED )
+  {
+    /* added and removed before anybody got
+     * to know about it -> report nothing */
+    switch( self->qc_kind )
+    {
+    case 0:
+    case ALARMD_QUEUE_CHANGE_ADDED:
+      self->qc_kind = 0;
+      break;
+
+    default:
+      self->qc_kind = kind;
+      break;
+    }
+  }
+
+  /* modifications do not change the kind of
+   * pending change, just the reported values */
+
+  self->qc_trigger = alarm_event_get_trigger(eve);
+  self->qc_state   = queue_event_get_state(eve);
+
+  cleanup:
+
+  return;
+}
+
+/* ------------------------------------------------------------------------- *
+ * server_queuechange_flush  --  broadcast pending changes
+ * ------------------------------------------------------------------------- */
+
+static
+void
+server_queuechange_flush(void)
+{
+  server_queuechange_t **vec = 0;
+  size_t                 cnt = 0;
+
+  dbus_int32_t *cookies  = 0;
+  dbus_int32_t *kinds    = 0;
+  dbus_int32_t *triggers = 0;
+  dbus_int32_t *states   = 0;
+
+  auto void collect_cb(gpointer key, gpointer val, gpointer aptr);
+  auto void collect_cb(gpointer key, gpointer val, gpointer aptr)
+  {
+    server_queuechange_t *self = val;
+
+    if( self->qc_kind != 0 )
+    {
+      vec[cnt++] = self;
+    }
+  }
+
+  auto int compare(const void *a1, const void *a2);
+  auto int compare(const void *a1, const void *a2)
+  {
+    const server_queuechange_t *s1 = *(const server_queuechange_t **)a1;
+    const server_queuechange_t *s2 = *(const server_queuechange_t **)a2;
+
+    int r = strcmp(s1->qc_appid, s2->qc_appid);
+
+    if( r == 0 )
+    {
+      r = (s1->qc_cookie > s2->qc_cookie) - (s1->qc_cookie < s2->qc_cookie);
+    }
+    return r;
+  }
+
+  auto void emit(DBusConnection *con, const char *appid, int n);
+  auto void emit(DBusConnection *con, const char *appid, int n)
+  {
+    if( con != 0 )
+    {
+      dbusif_signal_send(con,
+                         ALARMD_PATH,
+                         ALARMD_INTERFACE,
+                         ALARMD_QUEUE_CHANGED_IND,
+                         DBUS_TYPE_STRING, &appid,
+                         DBUS_TYPE_ARRAY, DBUS_TYPE_INT32, &cookies,  n,
+                         DBUS_TYPE_ARRAY, DBUS_TYPE_INT32, &kinds,    n,
+                         DBUS_TYPE_ARRAY, DBUS_TYPE_INT32, &triggers, n,
+                         DBUS_TYPE_ARRAY, DBUS_TYPE_INT32, &states,   n,
+                         DBUS_TYPE_INVALID);
+    }
+  }
+
+  if( server_queuechange_lut == 0 )
+  {
+    goto cleanup;
+  }
+
+  if( g_hash_table_size(server_queuechange_lut) == 0 )
+  {
+    goto cleanup;
+  }
+
+  /* - - - - - - - - - - - - - - - - - - - *
+   * group reportable changes by appid
+   * - - - - - - - - - - - - - - - - - - - */
+
+  vec = calloc(g_hash_table_size(server_queuechange_lut), sizeof *vec);
+  g_hash_table_foreach(server_queuechange_lut, collect_cb, 0);
+  qsort(vec, cnt, sizeof *vec, compare);
+
+  cookies  = calloc(SERVER_QUEUE_CHANGE_CHUNK, sizeof *cookies);
+  kinds    = calloc(SERVER_QUEUE_CHANGE_CHUNK, sizeof *kinds);
+  triggers = calloc(SERVER_QUEUE_CHANGE_CHUNK, sizeof *triggers);
+  states   = calloc(SERVER_QUEUE_CHANGE_CHUNK, sizeof *states);
+
+  /* - - - - - - - - - - - - - - - - - - - *
+   * one signal per appid, split to chunks
+   * if there are lots of changes
+   * - - - - - - - - - - - - - - - - - - - */
+
+  for( size_t i = 0; i < cnt; )
+  {
+    const char *appid = vec[i]->qc_appid;
+    int         n     = 0;
+
+    while( i < cnt && n < SERVER_QUEUE_CHANGE_CHUNK &&
+           !strcmp(vec[i]->qc_appid, appid) )
+    {
+      cookies[n]  = vec[i]->qc_cookie;
+      kinds[n]    = vec[i]->qc_kind;
+      triggers[n] = vec[i]->qc_trigger;
+      states[n]   = vec[i]->qc_state;
+      ++n, ++i;
+    }
+
+    log_debug("QCHANGE - appid: '%s', changes: %d\n", appid, n);
+
+    emit(server_session_bus, appid, n);
+    emit(server_system_bus,  appid, n);
+  }
+
+  cleanup:
+
+  if( server_queuechange_lut != 0 )
+  {
+    g_hash_table_remove_all(server_queuechange_lut);
+  }
+
+  free(vec);
+  free(cookies);
+  free(kinds);
+  free(triggers);
+  free(states);
+}
+
+/* ------------------------------------------------------------------------- *
+ * server_queuechange_init
+ * ------------------------------------------------------------------------- */
+
+static
+void
+server_queuechange_init(void)
+{
+  if( server_queuechange_lut == 0 )
+  {
+    server_queuechange_lut = g_hash_table_new_full(g_direct_hash,
+                                                   g_direct_equal, 0,
+                                                   server_queuechange_delete);
+  }
+  queue_set_changed_cb(server_queuechange_cb);
+}
+
+/* ------------------------------------------------------------------------- *
+ * server_queuechange_quit
+ * ------------------------------------------------------------------------- */
+
+static
+void
+server_queuechange_quit(void)
+{
+  queue_set_changed_cb(0);
+
+  if( server_queuechange_lut != 0 )
+  {
+    g_hash_table_destroy(server_queuechange_lut);
+    server_queuechange_lut = 0;
+  }
+}
+
 /* ========================================================================= *
  * Limbo State Control
  * ========================================================================= */
@@ -1199,7 +1476,7 @@ server_action_do_disable(alarm_event_t *event, alarm_action_t *action)
    * state machine via ALARM_STATE_NEW state.
    */
   log_info("DISABLING DUE TO ACTION: cookie=%d\n", (int)event->ALARMD_PRIVATE(cookie));
-  event->flags |= ALARM_EVENT_DISABLED;
+  queue_event_set_disabled(event);
   return 0;
 }
 
@@ -1300,39 +1577,15 @@ server_action_do_dbus(alarm_event_t *event, alarm_action_t *action)
   log_info("DBUS: interface = '%s'\n", action->dbus_interface);
   log_info("DBUS: name      = '%s'\n", action->dbus_name);
 
-  if( !xisempty(action->dbus_service) )
-  {
-    log_info("DBUS: is method\n");
-    msg = dbus_message_new_method_call(action->dbus_service,
-                                       action->dbus_path,
-                                       action->dbus_interface,
-                                       action->dbus_name);
-
-    if( action->flags & ALARM_ACTION_DBUS_USE_ACTIVATION )
-    {
-      log_info("DBUS: is auto start\n");
-      dbus_message_set_auto_start(msg, TRUE);
-    }
-    dbus_message_set_no_reply(msg, TRUE);
-  }
-  else
-  {
-    log_info("DBUS: is signal\n");
-    msg = dbus_message_new_signal(action->dbus_path,
-                                  action->dbus_interface,
-                                  action->dbus_name);
-  }
+  /* The message with user args is copied from a template
+   * cached for the event; only the cookie is appended here */
+  msg = msgcache_get_message(queue_event_get_msgcache(event), event,
+                             action - event->action_tab);
 
   if( msg != 0 )
   {
     DBusConnection *conn = server_session_bus;
 
-    if( !xisempty(action->dbus_args) )
-    {
-      log_info("DBUS: has user args\n");
-      serialize_unpack_to_mesg(action->dbus_args, msg);
-    }
-
     if( action->flags & ALARM_ACTION_DBUS_ADD_COOKIE )
     {
       log_info("DBUS: appending cookie %d\n", (int)event->ALARMD_PRIVATE(cookie));
@@ -1500,6 +1753,27 @@ server_event_get_boot_mask(alarm_event_t *eve)
   return acc;
 }
 
+/* ------------------------------------------------------------------------- *
+ * server_event_get_wakeup_class  --  classify queued events for queue.c
+ * ------------------------------------------------------------------------- */
+
+static
+int
+server_event_get_wakeup_class(alarm_event_t *eve)
+{
+  unsigned boot = server_event_get_boot_mask(eve);
+
+  if( boot & ALARM_EVENT_BOOT )
+  {
+    return QUEUE_WAKEUP_DESKTOP;
+  }
+  if( boot & ALARM_EVENT_ACTDEAD )
+  {
+    return QUEUE_WAKEUP_ACTDEAD;
+  }
+  return QUEUE_WAKEUP_NO_BOOT;
+}
+
 /* ------------------------------------------------------------------------- *
  * server_event_get_snooze
  * ------------------------------------------------------------------------- */
@@ -1630,21 +1904,17 @@ server_event_get_next_trigger(time_t t0, time_t t1, alarm_event_t *self)
     else
     {
       // recurrence masks
-      time_t next = INT_MAX;
-      struct tm now;
+      time_t         next  = INT_MAX;
+      recurcache_t **cache = queue_event_get_recurcache(self);
 
       if( t1 < t0 )
       {
         t1 = t0;
       }
 
-      ticker_break_tm(t1, &now, tz);
-
       for( size_t i = 0; i < self->recurrence_cnt; ++i )
       {
-        alarm_recur_t *rec = &self->recurrence_tab[i];
-        struct tm tmp = now;
-        time_t    trg = alarm_recur_align(rec, &tmp, tz);
+        time_t trg = recurcache_align(cache, self, i, tz, t1);
 
         if( t1 < trg && trg < next )
         {
@@ -1677,10 +1947,10 @@ server_event_evaluate_initial_trigger(alarm_event_t *self)
   time_t t0 = ticker_get_time();
   time_t t1 = server_event_get_next_trigger(t0, self->alarm_time, self);
 
-  log_debug("[%ld] INITIAL TRIGGER: T%s, %s\n",
-            (long)alarm_event_get_cookie(self),
-            ticker_secs_format(0,0,t0-t1),
-            ticker_date_format_long(0,0,t1));
+  log_debug_G("[%ld] INITIAL TRIGGER: T%s, %s\n",
+              (long)alarm_event_get_cookie(self),
+              ticker_secs_format(0,0,t0-t1),
+              ticker_date_format_long(0,0,t1));
 
   return t1;
 }
@@ -1724,12 +1994,12 @@ static time_t server_clock_forw_delta(void)
 }
 
 /* ------------------------------------------------------------------------- *
- * server_clock_source_is_stable
+ * server_clock_source_is_stable  --  check clock, get seconds to wait if not
  * ------------------------------------------------------------------------- */
 
 static
 gboolean
-server_clock_source_is_stable(void)
+server_clock_source_is_stable(time_t *pdelay)
 {
   static int    initialized = 0;
   static time_t delta_sched = 0;
@@ -1775,6 +2045,7 @@ server_clock_source_is_stable(void)
   if( mono_time < delay_until )
   {
     log_info("waiting clock source to stabilize ...\n");
+    *pdelay = delay_until - mono_time;
     return FALSE;
   }
 
@@ -1800,11 +2071,21 @@ server_clock_source_is_stable(void)
 
 /* ========================================================================= *
  * Server Wakeup for alarm
+ *
+ * When available, wakeups are timed with an absolute CLOCK_REALTIME
+ * timerfd: it fires on the exact second also after suspend, and the
+ * kernel cancels it when the system time is set, which makes clock
+ * changes visible without polling. Otherwise glib timeouts are used.
  * ========================================================================= */
 
 static time_t server_wakeup_time = INT_MAX;
 static guint  server_wakeup_id   = 0;
 
+#if HAVE_TIMERFD
+static int    server_wakeup_fd    = -1;
+static guint  server_wakeup_watch = 0;
+#endif
+
 /* ------------------------------------------------------------------------- *
  * server_wakeup_start_cb
  * ------------------------------------------------------------------------- */
@@ -1819,6 +2100,65 @@ server_wakeup_start_cb(gpointer data)
   return FALSE;
 }
 
+#if HAVE_TIMERFD
+/* ------------------------------------------------------------------------- *
+ * server_wakeup_timerfd_arm  --  set timerfd to expire at given time
+ * ------------------------------------------------------------------------- */
+
+static
+int
+server_wakeup_timerfd_arm(time_t tmo)
+{
+  struct itimerspec its;
+
+  memset(&its, 0, sizeof its);
+  its.it_value.tv_sec = tmo;
+
+  // even when there is nothing to wait for, the timer must
+  // stay armed to get notified about system time changes
+  return timerfd_settime(server_wakeup_fd,
+                         TFD_TIMER_ABSTIME | TFD_TIMER_CANCEL_ON_SET,
+                         &its, 0);
+}
+
+/* ------------------------------------------------------------------------- *
+ * server_wakeup_timerfd_cb  --  timer expired or system time was set
+ * ------------------------------------------------------------------------- */
+
+static
+gboolean
+server_wakeup_timerfd_cb(GIOChannel *channel, GIOCondition condition,
+                         gpointer data)
+{
+  uint64_t cnt = 0;
+
+  if( read(server_wakeup_fd, &cnt, sizeof cnt) == -1 )
+  {
+    switch( errno )
+    {
+    case ECANCELED:
+      log_info("timerfd - system time changed\n");
+      server_state_set(0, SF_CLK_CHANGED);
+      break;
+
+    case EAGAIN:
+    case EINTR:
+      return TRUE;
+
+    default:
+      log_error("timerfd: %s\n", strerror(errno));
+      break;
+    }
+  }
+
+  server_wakeup_time = INT_MAX;
+  server_wakeup_timerfd_arm(INT_MAX);
+  server_rethink_request(0);
+
+  return TRUE;
+}
+#endif
+
 /* ------------------------------------------------------------------------- *
  * server_cancel_wakeup
  * ------------------------------------------------------------------------- */
@@ -1832,6 +2172,14 @@ server_cancel_wakeup(void)
     g_source_remove(server_wakeup_id);
     server_wakeup_id = 0;
   }
+
+#if HAVE_TIMERFD
+  if( server_wakeup_fd != -1 )
+  {
+    server_wakeup_timerfd_arm(INT_MAX);
+  }
+#endif
+
   server_wakeup_time = INT_MAX;
 }
 
@@ -1846,6 +2194,7 @@ server_request_wakeup(time_t tmo)
   time_t now = ticker_get_time();
   time_t top = now + 14 * 24 * 60 * 60; // two weeks ahead
 
+  if( log_enabled(LOG_DEBUG) )
   {
     struct tm tm; char tmp[128];
     const char *tz = server_tz_curr;
@@ -1869,6 +2218,7 @@ server_request_wakeup(time_t tmo)
 
     server_wakeup_time = tmo;
 
+    if( log_enabled(LOG_DEBUG) )
     {
       const char *tz = server_tz_curr;
       struct tm tm; char tmp[128];
@@ -1881,6 +2231,12 @@ server_request_wakeup(time_t tmo)
     {
       server_wakeup_id = g_idle_add(server_wakeup_start_cb, 0);
     }
+#if HAVE_TIMERFD
+    else if( server_wakeup_fd != -1 && server_wakeup_timerfd_arm(tmo) == 0 )
+    {
+      // wakeup via server_wakeup_timerfd_cb()
+    }
+#endif
     else
     {
       tmo -= now;
@@ -1892,6 +2248,96 @@ server_request_wakeup(time_t tmo)
   }
 }
 
+/* ------------------------------------------------------------------------- *
+ * server_wakeup_init  --  use timerfd for wakeups if possible
+ * ------------------------------------------------------------------------- */
+
+static
+void
+server_wakeup_init(void)
+{
+#if HAVE_TIMERFD
+  /* CLOCK_REALTIME_ALARM also resumes the device from
+   * suspend, but requires CAP_WAKE_ALARM */
+  static const clockid_t clocks[] =
+  {
+    CLOCK_REALTIME_ALARM,
+    CLOCK_REALTIME,
+  };
+
+  GIOChannel *channel = 0;
+
+  for( size_t i = 0; i < sizeof clocks / sizeof *clocks; ++i )
+  {
+    server_wakeup_fd = timerfd_create(clocks[i], TFD_NONBLOCK | TFD_CLOEXEC);
+
+    if( server_wakeup_fd == -1 )
+    {
+      continue;
+    }
+
+    if( server_wakeup_timerfd_arm(INT_MAX) == 0 )
+    {
+      break;
+    }
+
+    // CANCEL_ON_SET not supported
+    close(server_wakeup_fd), server_wakeup_fd = -1;
+  }
+
+  if( server_wakeup_fd == -1 )
+  {
+    log_notice("timerfd not available, using glib timeouts\n");
+    goto cleanup;
+  }
+
+  if( (channel = g_io_channel_unix_new(server_wakeup_fd)) == 0 )
+  {
+    goto cleanup;
+  }
+
+  server_wakeup_watch = g_io_add_watch(channel, G_IO_IN,
+                                       server_wakeup_timerfd_cb, 0);
+
+  cleanup:
+
+  if( channel != 0 )
+  {
+    g_io_channel_unref(channel);
+  }
+
+  if( server_wakeup_watch == 0 && server_wakeup_fd != -1 )
+  {
+    close(server_wakeup_fd), server_wakeup_fd = -1;
+  }
+#endif
+}
+
+/* ------------------------------------------------------------------------- *
+ * server_wakeup_quit
+ * ------------------------------------------------------------------------- */
+
+static
+void
+server_wakeup_quit(void)
+{
+  server_cancel_wakeup();
+
+#if HAVE_TIMERFD
+  if( server_wakeup_watch != 0 )
+  {
+    g_source_remove(server_wakeup_watch);
+    server_wakeup_watch = 0;
+  }
+
+  if( server_wakeup_fd != -1 )
+  {
+    close(server_wakeup_fd);
+    server_wakeup_fd = -1;
+  }
+#endif
+}
+
 /* ========================================================================= *
  * Rething states of queued events
  * ========================================================================= */
@@ -1901,6 +2347,9 @@ static guint  server_rethink_id  = 0;
 
 static time_t server_rethink_time = 0;
 
+// SF_CONNECTED at previous rethink, -1 = unknown
+static int    server_rethink_connected = -1;
+
 /* ------------------------------------------------------------------------- *
  * time_filt  --  utility for scanning lowest time_t value
  * ------------------------------------------------------------------------- */
@@ -1916,21 +2365,34 @@ static inline void time_filt(time_t *low, time_t add)
 
 static
 int
-server_handle_systemui_ack(cookie_t *vec, int cnt)
+server_handle_systemui_ack(const dbus_int32_t *vec, int cnt)
 {
   int err = 0;
+  int ack = 0;
+
   log_debug_F("vec=%p, cnt=%d\n", vec, cnt);
 
   for( int i = 0; i < cnt; ++i )
   {
     alarm_event_t *eve = queue_get_event(vec[i]);
-    log_debug("[%ld] ACK: event=%p\n", vec[i], eve);
-    if( eve != 0 )
+    log_debug("[%ld] ACK: event=%p\n", (long)vec[i], eve);
+
+    if( eve != 0 && queue_event_get_state(eve) == ALARM_STATE_SYSUI_REQ )
     {
       queue_event_set_state(eve, ALARM_STATE_SYSUI_ACK);
+      ack += 1;
     }
   }
-  server_rethink_request(1);
+
+  /* - - - - - - - - - - - - - - - - - - - *
+   * one rethink for the whole batch, and
+   * none at all for duplicate acks
+   * - - - - - - - - - - - - - - - - - - - */
+
+  if( ack != 0 )
+  {
+    server_rethink_request(1);
+  }
 
   return err;
 }
@@ -1943,7 +2405,7 @@ static
 void
 server_systemui_ack_cb(dbus_int32_t *vec, int cnt)
 {
-  server_handle_systemui_ack((cookie_t*)vec, cnt);
+  server_handle_systemui_ack(vec, cnt);
 }
 
 /* ------------------------------------------------------------------------- *
@@ -1989,6 +2451,7 @@ server_rethink_new(void)
     alarm_event_t *eve = queue_get_event(vec[i]);
 
 #if ENABLE_LOGGING >= 3
+    if( log_enabled(LOG_INFO) )
     {
       time_t now = server_rethink_time;
       time_t trg = alarm_event_get_trigger(eve);
@@ -2063,68 +2526,84 @@ server_rethink_queued(void)
   time_t    now = server_rethink_time;
   time_t    tsw = INT_MAX;
   time_t    thw = INT_MAX;
-  int       cnt = 0;
-  cookie_t *vec = queue_query_by_state(&cnt, ALARM_STATE_QUEUED);
+  int       con = (server_state_get() & SF_CONNECTED) != 0;
 
-  for( int i = 0; i < cnt; ++i )
+  /* - - - - - - - - - - - - - - - - - - - *
+   * events entering the queued state have
+   * already been checked for connection
+   * requirements -> all queued events need
+   * to be checked only when the connection
+   * goes away
+   * - - - - - - - - - - - - - - - - - - - */
+
+  if( !con && server_rethink_connected != 0 )
   {
-    alarm_event_t *eve = queue_get_event(vec[i]);
+    int       cnt = 0;
+    cookie_t *vec = queue_query_by_state(&cnt, ALARM_STATE_QUEUED);
 
-    // required internet connection not available?
-    if( eve->flags & ALARM_EVENT_CONNECTED )
+    for( int i = 0; i < cnt; ++i )
     {
-      if( !(server_state_get() & SF_CONNECTED) )
+      alarm_event_t *eve = queue_get_event(vec[i]);
+
+      // required internet connection not available?
+      if( eve->flags & ALARM_EVENT_CONNECTED )
       {
         queue_event_set_state(eve, ALARM_STATE_WAITCONN);
-        continue;
       }
     }
+    free(vec);
+  }
+  server_rethink_connected = con;
 
-// QUARANTINE     {
-// QUARANTINE       const char *tz = server_event_get_tz(eve);
-// QUARANTINE       struct tm tm;
-// QUARANTINE       char trg[128];
-// QUARANTINE       ticker_break_tm(alarm_event_get_trigger(eve), &tm, tz);
-// QUARANTINE       server_repr_tm(&tm, tz, trg, sizeof trg);
-// QUARANTINE       log_debug("Q: %s, at %+d\n", trg, (int)(alarm_event_get_trigger(eve) - now));
-// QUARANTINE     }
+  /* - - - - - - - - - - - - - - - - - - - *
+   * queue keeps queued events in trigger
+   * order -> only events that are due need
+   * to be looked at, state changes remove
+   * them from the queued set
+   * - - - - - - - - - - - - - - - - - - - */
 
-    // in future -> just update wakeup time values
-    if( alarm_event_get_trigger(eve) > now )
-    {
-      unsigned boot = server_event_get_boot_mask(eve);
+  for( int cls = 0; cls < QUEUE_WAKEUP_NUMOF; ++cls )
+  {
+    alarm_event_t *eve;
 
-      if( boot & ALARM_EVENT_BOOT )
-      {
-        time_filt(&server_queuestate_curr.qs_desktop, alarm_event_get_trigger(eve));
-      }
-      else if( boot & ALARM_EVENT_ACTDEAD )
-      {
-        time_filt(&server_queuestate_curr.qs_actdead, alarm_event_get_trigger(eve));
-      }
-      else
+    while( (eve = queue_get_next_queued(cls)) != 0 )
+    {
+      // in future -> nothing more to do
+      if( alarm_event_get_trigger(eve) > now )
       {
-        time_filt(&server_queuestate_curr.qs_no_boot, alarm_event_get_trigger(eve));
+        break;
       }
 
-      if( eve->flags & ALARM_EVENT_SHOW_ICON )
+      // missed for some reason, power off for example
+      if( (now - alarm_event_get_trigger(eve)) > SERVER_MISSED_LIMIT )
       {
-        server_icons_curr += 1;
+        queue_event_set_state(eve, ALARM_STATE_MISSED);
+        continue;
       }
-      continue;
-    }
 
-    // missed for some reason, power off for example
-    if( (now - alarm_event_get_trigger(eve)) > SERVER_MISSED_LIMIT )
-    {
-      queue_event_set_state(eve, ALARM_STATE_MISSED);
-      continue;
+      // trigger it
+      queue_event_set_state(eve, ALARM_STATE_LIMBO);
     }
+  }
 
-    // trigger it
-    queue_event_set_state(eve, ALARM_STATE_LIMBO);
+  /* - - - - - - - - - - - - - - - - - - - *
+   * the rest are in future -> update
+   * wakeup time values
+   * - - - - - - - - - - - - - - - - - - - */
+
+  auto void wakeup(time_t *low, int cls);
+  auto void wakeup(time_t *low, int cls)
+  {
+    alarm_event_t *eve = queue_get_next_queued(cls);
+    if( eve != 0 ) time_filt(low, alarm_event_get_trigger(eve));
   }
 
+  wakeup(&server_queuestate_curr.qs_desktop, QUEUE_WAKEUP_DESKTOP);
+  wakeup(&server_queuestate_curr.qs_actdead, QUEUE_WAKEUP_ACTDEAD);
+  wakeup(&server_queuestate_curr.qs_no_boot, QUEUE_WAKEUP_NO_BOOT);
+
+  server_icons_curr = queue_count_queued_icons();
+
   // determinetimeout values
   time_filt(&thw, server_queuestate_curr.qs_desktop);
   time_filt(&thw, server_queuestate_curr.qs_actdead);
@@ -2150,9 +2629,6 @@ server_rethink_queued(void)
     gmtime_r(&trg, &tm);
     hwrtc_set_alarm(&tm, 1);
   }
-
-  // cleanup
-  free(vec);
 }
 
 /* ------------------------------------------------------------------------- *
@@ -2201,7 +2677,7 @@ server_rethink_missed(void)
       // the event will come invisible to alarmd state machine
       // once the ALARM_EVENT_DISABLED flag is set
       // -> no state transfer required
-      eve->flags |= ALARM_EVENT_DISABLED;
+      queue_event_set_disabled(eve);
       server_event_do_state_actions(eve, ALARM_ACTION_WHEN_DISABLED);
       continue;
     }
@@ -2325,6 +2801,7 @@ server_rethink_triggered(void)
 
     server_event_do_state_actions(eve, ALARM_ACTION_WHEN_TRIGGERED);
 
+    if( log_enabled(LOG_INFO) )
     {
       struct tm tm;
       char now[128];
@@ -2458,7 +2935,7 @@ server_rethink_sysui_rsp(void)
          (eve->flags & ALARM_EVENT_DISABLE_DELAYED) &&
          !alarm_event_is_recurring(eve) )
     {
-      eve->flags |= ALARM_EVENT_DISABLED;
+      queue_event_set_disabled(eve);
       continue;
     }
 
@@ -2584,15 +3061,11 @@ server_rethink_recurring(void)
       }
       else
       {
-        struct tm tm_now;
-
-        ticker_break_tm(now, &tm_now, tz);
+        recurcache_t **cache = queue_event_get_recurcache(eve);
 
         for( size_t i = 0; i < eve->recurrence_cnt; ++i )
         {
-          struct tm tm_tmp = tm_now;
-          alarm_recur_t *rec = &eve->recurrence_tab[i];
-          time_t t = alarm_recur_next(rec, &tm_tmp, tz);
+          time_t t = recurcache_next(cache, eve, i, tz, now);
           if( t > 0 && t < curr ) curr = t;
         }
       }
@@ -2666,6 +3139,8 @@ server_rethink_timechange(void)
   if( server_state_get() & SF_TZ_CHANGED )
   {
     server_state_clr(SF_TZ_CHANGED);
+    tzfile_flush();
+    recurcache_flush();
     zone = 1;
     log_info("timezone: '%s' -> '%s'\n", server_tz_prev, server_tz_curr);
   }
@@ -2764,6 +3239,7 @@ server_rethink_timechange(void)
        * adjust alarm triggering time
        * - - - - - - - - - - - - - - - - - - - */
 
+      if( log_enabled(LOG_DEBUG) )
       {
         const char *tz = NULL;
         struct tm tm;
@@ -2781,10 +3257,10 @@ server_rethink_timechange(void)
         ticker_break_tm(use, &tm, tz ?: server_tz_curr);
         server_repr_tm(&tm, tz ?: server_tz_curr, trg, sizeof trg);
         log_debug("[%ld] NEW: %s, at %+d\n", vec[i], trg, (int)(use - now));
-
-        queue_event_set_trigger(eve, use);
-        queue_event_set_state(eve, ALARM_STATE_NEW);
       }
+
+      queue_event_set_trigger(eve, use);
+      queue_event_set_state(eve, ALARM_STATE_NEW);
     }
 
     server_timestate_sync();
@@ -2838,7 +3314,9 @@ server_rethink_start_cb(gpointer data)
 {
   //log_debug("----------------------------------------------------------------\n");
 
-  if( !server_clock_source_is_stable() )
+  time_t delay = 0;
+
+  if( !server_clock_source_is_stable(&delay) )
   {
     server_state_set(0, SF_CLK_BCAST);
     server_cancel_wakeup();
@@ -2846,7 +3324,8 @@ server_rethink_start_cb(gpointer data)
     // broadcast queue status after time is stable
     server_queuestate_invalidate();
 
-    server_rethink_id = g_timeout_add(1*1000, server_rethink_start_cb, 0);
+    // further clock changes restart the wait, no need to poll
+    server_rethink_id = g_timeout_add(delay * 1000, server_rethink_start_cb, 0);
     return FALSE;
   }
 
@@ -2928,6 +3407,7 @@ server_rethink_start_cb(gpointer data)
   }
 
   server_queuestate_sync();
+  server_queuechange_flush();
   server_broadcast_timechange_handled();
   server_queue_request_save();
 
@@ -3005,6 +3485,25 @@ server_handle_set_debug(DBusMessage *msg)
   return rsp;
 }
 
+/* ------------------------------------------------------------------------- *
+ * server_handle_dump_log  --  flush buffered log messages
+ * ------------------------------------------------------------------------- */
+
+static
+DBusMessage *
+server_handle_dump_log(DBusMessage *msg)
+{
+  dbus_bool_t res = 1;
+
+  /* When logging to the in-memory ring buffer, this formats
+   * and writes the buffered messages to <cachedir>/alarmd.log
+   *
+   * Available only on the session bus, see server_session_bus_cb() */
+  log_flush();
+
+  return dbusif_reply_create(msg, DBUS_TYPE_BOOLEAN, &res, DBUS_TYPE_INVALID);
+}
+
 /* ------------------------------------------------------------------------- *
  * server_handle_CUD  --  "clear user data" handler
  * ------------------------------------------------------------------------- */
@@ -3116,6 +3615,48 @@ server_handle_snooze_set(DBusMessage *msg)
   return rsp;
 }
 
+/* ------------------------------------------------------------------------- *
+ * server_event_add  --  add event received from client to queue
+ *
+ * Takes ownership of the event. Returns cookie, or 0 if the event
+ * was rejected.
+ * ------------------------------------------------------------------------- */
+
+static
+cookie_t
+server_event_add(alarm_event_t *event)
+{
+  cookie_t cookie = 0;
+
+  /* - - - - - - - - - - - - - - - - - - - *
+   * client -> server: reset fields that
+   * are manged by the server
+   * - - - - - - - - - - - - - - - - - - - */
+
+  event->response = -1;
+  event->snooze_total = 0;
+
+  alarm_event_set_cookie(event, 0);
+  alarm_event_set_trigger(event, 0);
+  queue_event_set_state(event, ALARM_STATE_NEW);
+
+  time_t trigger = server_event_evaluate_initial_trigger(event);
+
+  time_t now = ticker_get_time();
+  if( trigger >= now )
+  {
+    alarm_event_set_trigger(event, trigger);
+    if( (cookie = queue_add_event(event)) != 0 )
+    {
+      event = 0;
+    }
+  }
+
+  alarm_event_delete(event);
+
+  return cookie;
+}
+
 /* ------------------------------------------------------------------------- *
  * server_handle_event_add  --  handle ALARMD_EVENT_ADD method call
  * ------------------------------------------------------------------------- */
@@ -3130,38 +3671,62 @@ server_handle_event_add(DBusMessage *msg)
 
   if( (event = dbusif_decode_event(msg)) != 0 )
   {
-    /* - - - - - - - - - - - - - - - - - - - *
-     * client -> server: reset fields that
-     * are manged by the server
-     * - - - - - - - - - - - - - - - - - - - */
+    cookie = server_event_add(event);
+  }
 
-    event->response = -1;
-    event->snooze_total = 0;
+  rsp = dbusif_reply_create(msg, DBUS_TYPE_INT32, &cookie, DBUS_TYPE_INVALID);
 
-    alarm_event_set_cookie(event, 0);
-    alarm_event_set_trigger(event, 0);
-    queue_event_set_state(event, ALARM_STATE_NEW);
+  server_rethink_request(1);
 
-    time_t trigger = server_event_evaluate_initial_trigger(event);
+  log_info("%s() -> %ld\n", __FUNCTION__, (long)cookie);
 
-    time_t now = ticker_get_time();
-    if( trigger >= now )
+  return rsp;
+}
+
+/* ------------------------------------------------------------------------- *
+ * server_handle_events_add  --  handle ALARMD_EVENTS_ADD method call
+ * ------------------------------------------------------------------------- */
+
+static
+DBusMessage *
+server_handle_events_add(DBusMessage *msg)
+{
+  DBusMessage    *rsp = 0;
+  alarm_event_t **vec = 0;
+  dbus_int32_t   *res = 0;
+  size_t          cnt = 0;
+  size_t          ack = 0;
+
+  if( (vec = dbusif_decode_events(msg, &cnt)) != 0 )
+  {
+    res = calloc(cnt + 1, sizeof *res);
+
+    for( size_t i = 0; i < cnt; ++i )
     {
-      alarm_event_set_trigger(event, trigger);
-      if( (cookie = queue_add_event(event)) != 0 )
+      if( (res[i] = server_event_add(vec[i])) != 0 )
       {
-        event = 0;
+        ++ack;
       }
     }
-  }
 
-  alarm_event_delete(event);
+    rsp = dbusif_reply_create(msg,
+                              DBUS_TYPE_ARRAY, DBUS_TYPE_INT32, &res, (int)cnt,
+                              DBUS_TYPE_INVALID);
 
-  rsp = dbusif_reply_create(msg, DBUS_TYPE_INT32, &cookie, DBUS_TYPE_INVALID);
+    // one rethink for the whole batch
+    server_rethink_request(1);
+  }
+  else
+  {
+    // malformed request, as dbusif_method_parse_args() would reply
+    rsp = dbus_message_new_error(msg, DBUS_ERROR_INVALID_ARGS,
+                                 dbus_message_get_member(msg));
+  }
 
-  server_rethink_request(1);
+  log_info("%s() -> %zu/%zu\n", __FUNCTION__, ack, cnt);
 
-  log_info("%s() -> %ld\n", __FUNCTION__, (long)cookie);
+  free(res);
+  free(vec);
 
   return rsp;
 }
@@ -3190,28 +3755,9 @@ server_handle_event_update(DBusMessage *msg)
      * continue as with add
      * - - - - - - - - - - - - - - - - - - - */
 
-    event->response = -1;
-    event->snooze_total = 0;
-
-    alarm_event_set_cookie(event, 0);
-    alarm_event_set_trigger(event, 0);
-    queue_event_set_state(event, ALARM_STATE_NEW);
-
-    time_t trigger = server_event_evaluate_initial_trigger(event);
-
-    time_t now = ticker_get_time();
-    if( trigger >= now )
-    {
-      alarm_event_set_trigger(event, trigger);
-      if( (cookie = queue_add_event(event)) != 0 )
-      {
-        event = 0;
-      }
-    }
+    cookie = server_event_add(event);
   }
 
-  alarm_event_delete(event);
-
   rsp = dbusif_reply_create(msg, DBUS_TYPE_INT32, &cookie, DBUS_TYPE_INVALID);
 
   server_rethink_request(1);
@@ -3247,6 +3793,50 @@ server_handle_event_del(DBusMessage *msg)
   return rsp;
 }
 
+/* ------------------------------------------------------------------------- *
+ * server_handle_events_del  -- handle ALARMD_EVENTS_DEL method call
+ * ------------------------------------------------------------------------- */
+
+static
+DBusMessage *
+server_handle_events_del(DBusMessage *msg)
+{
+  DBusMessage   *rsp = 0;
+  dbus_int32_t  *vec = 0;
+  int            cnt = 0;
+  dbus_bool_t   *res = 0;
+  int            ack = 0;
+
+  if( !(rsp = dbusif_method_parse_args(msg,
+                                       DBUS_TYPE_ARRAY, DBUS_TYPE_INT32,
+                                       &vec, &cnt,
+                                       DBUS_TYPE_INVALID)) )
+  {
+    res = calloc(cnt + 1, sizeof *res);
+
+    for( int i = 0; i < cnt; ++i )
+    {
+      if( (res[i] = queue_del_event(vec[i])) )
+      {
+        ++ack;
+      }
+    }
+
+    rsp = dbusif_reply_create(msg,
+                              DBUS_TYPE_ARRAY, DBUS_TYPE_BOOLEAN, &res, cnt,
+                              DBUS_TYPE_INVALID);
+
+    // one rethink for the whole batch
+    server_rethink_request(1);
+  }
+
+  log_info("%s() -> %d/%d\n", __FUNCTION__, ack, cnt);
+
+  free(res);
+
+  return rsp;
+}
+
 /* ------------------------------------------------------------------------- *
  * server_handle_event_query  --  handle ALARMD_EVENT_QUERY method call
  * ------------------------------------------------------------------------- */
@@ -3287,6 +3877,124 @@ server_handle_event_query(DBusMessage *msg)
   return rsp;
 }
 
+/* ------------------------------------------------------------------------- *
+ * server_handle_event_query_page  --  handle ALARMD_EVENT_QUERY_PAGE
+ * ------------------------------------------------------------------------- */
+
+static
+DBusMessage *
+server_handle_event_query_page(DBusMessage *msg)
+{
+  DBusMessage   *rsp     = 0;
+  dbus_int32_t   lo      = 0;
+  dbus_int32_t   hi      = 0;
+  dbus_int32_t   mask    = 0;
+  dbus_int32_t   flag    = 0;
+  dbus_uint32_t  limit   = 0;
+  cookie_t      *vec     = 0;
+  int            cnt     = 0;
+  char          *app     = 0;
+  char          *cursor  = 0;
+  long           trigger = 0;
+  long           cookie  = 0;
+  char           next[64];
+
+  assert( sizeof(dbus_int32_t) == sizeof(cookie_t) );
+
+  if( !(rsp = dbusif_method_parse_args(msg,
+                                       DBUS_TYPE_INT32,  &lo,
+                                       DBUS_TYPE_INT32,  &hi,
+                                       DBUS_TYPE_INT32,  &mask,
+                                       DBUS_TYPE_INT32,  &flag,
+                                       DBUS_TYPE_STRING, &app,
+                                       DBUS_TYPE_UINT32, &limit,
+                                       DBUS_TYPE_STRING, &cursor,
+                                       DBUS_TYPE_INVALID)) )
+  {
+    /* the cursor is "<trigger>:<cookie>" of the last event
+     * on the previous page, anything else starts over */
+    if( sscanf(cursor, "%ld:%ld", &trigger, &cookie) != 2 )
+    {
+      trigger = cookie = 0;
+    }
+
+    time_t   pos = trigger;
+    cookie_t ref = cookie;
+
+    if( (vec = queue_query_events_page(&cnt, lo, hi, mask, flag, app,
+                                       limit, &pos, &ref)) )
+    {
+      *next = 0;
+      if( ref != 0 )
+      {
+        snprintf(next, sizeof next, "%ld:%ld", (long)pos, (long)ref);
+      }
+      cursor = next;
+
+      rsp = dbusif_reply_create(msg,
+                                DBUS_TYPE_ARRAY, DBUS_TYPE_INT32, &vec, cnt,
+                                DBUS_TYPE_STRING, &cursor,
+                                DBUS_TYPE_INVALID);
+    }
+  }
+
+  free(vec);
+
+  return rsp;
+}
+
+/* ------------------------------------------------------------------------- *
+ * server_handle_event_query_full  --  handle ALARMD_EVENT_QUERY_FULL
+ * ------------------------------------------------------------------------- */
+
+static
+DBusMessage *
+server_handle_event_query_full(DBusMessage *msg)
+{
+  DBusMessage          *rsp    = 0;
+  dbus_int32_t          lo     = 0;
+  dbus_int32_t          hi     = 0;
+  dbus_int32_t          mask   = 0;
+  dbus_int32_t          flag   = 0;
+  dbus_uint32_t         fields = 0;
+  cookie_t             *vec    = 0;
+  const alarm_event_t **eve    = 0;
+  int                   cnt    = 0;
+  char                 *app    = 0;
+
+  if( !(rsp = dbusif_method_parse_args(msg,
+                                       DBUS_TYPE_INT32,  &lo,
+                                       DBUS_TYPE_INT32,  &hi,
+                                       DBUS_TYPE_INT32,  &mask,
+                                       DBUS_TYPE_INT32,  &flag,
+                                       DBUS_TYPE_STRING, &app,
+                                       DBUS_TYPE_UINT32, &fields,
+                                       DBUS_TYPE_INVALID)) )
+  {
+    if( (vec = queue_query_events(&cnt, lo, hi, mask, flag, app)) )
+    {
+      eve = calloc(cnt + 1, sizeof *eve);
+      for( int i = 0; i < cnt; ++i )
+      {
+        eve[i] = queue_get_event(vec[i]);
+      }
+
+      rsp = dbusif_reply_create(msg, DBUS_TYPE_INVALID);
+      if( !dbusif_encode_events(rsp, eve, cnt, fields) )
+      {
+        dbus_message_unref(rsp), rsp = 0;
+      }
+    }
+  }
+
+  log_info("%s() -> %d events\n", __FUNCTION__, cnt);
+
+  free(eve);
+  free(vec);
+
+  return rsp;
+}
+
 /* ------------------------------------------------------------------------- *
  * server_handle_event_get  --  handle ALARMD_EVENT_GET method call
  * ------------------------------------------------------------------------- */
@@ -3368,7 +4076,7 @@ server_handle_queue_ack(DBusMessage *msg)
                                        DBUS_TYPE_ARRAY, DBUS_TYPE_INT32, &vec, &cnt,
                                        DBUS_TYPE_INVALID)) )
   {
-    res = (server_handle_systemui_ack((cookie_t *)vec, cnt) != -1);
+    res = (server_handle_systemui_ack(vec, cnt) != -1);
     rsp = dbusif_reply_create(msg, DBUS_TYPE_BOOLEAN, &res, DBUS_TYPE_INVALID);
 
   }
@@ -3507,6 +4215,9 @@ server_handle_name_owner_chaned(DBusMessage *msg)
       else
       {
         set |= SF_SYSTEMUI_UP;
+
+        // new instance might support batch requests
+        ipc_systemui_reset_protocol();
       }
     }
     else if( !strcmp(service, CLOCKD_SERVICE) )
@@ -3647,8 +4358,12 @@ server_session_bus_cb(DBusConnection *conn, DBusMessage *msg, void *user_data)
   {
     {ALARMD_EVENT_ADD,   server_handle_event_add},
     {ALARMD_EVENT_DEL,   server_handle_event_del},
+    {ALARMD_EVENTS_ADD,  server_handle_events_add},
+    {ALARMD_EVENTS_DEL,  server_handle_events_del},
     {ALARMD_EVENT_GET,   server_handle_event_get},
     {ALARMD_EVENT_QUERY, server_handle_event_query},
+    {ALARMD_EVENT_QUERY_FULL, server_handle_event_query_full},
+    {ALARMD_EVENT_QUERY_PAGE, server_handle_event_query_page},
     {ALARMD_EVENT_UPDATE,server_handle_event_update},
 
     {ALARMD_SNOOZE_SET,  server_handle_snooze_set},
@@ -3658,6 +4373,7 @@ server_session_bus_cb(DBusConnection *conn, DBusMessage *msg, void *user_data)
     {ALARMD_DIALOG_ACK,  server_handle_queue_ack},
 
     {"alarmd_set_debug", server_handle_set_debug},
+    {"alarmd_dump_log",  server_handle_dump_log},
 
 #if ALARMD_CUD_ENABLE
     {"clear_user_data",          server_handle_CUD},
@@ -3723,8 +4439,12 @@ server_system_bus_cb(DBusConnection *conn, DBusMessage *msg, void *user_data)
   {
     {ALARMD_EVENT_ADD,   server_handle_event_add},
     {ALARMD_EVENT_DEL,   server_handle_event_del},
+    {ALARMD_EVENTS_ADD,  server_handle_events_add},
+    {ALARMD_EVENTS_DEL,  server_handle_events_del},
     {ALARMD_EVENT_GET,   server_handle_event_get},
     {ALARMD_EVENT_QUERY, server_handle_event_query},
+    {ALARMD_EVENT_QUERY_FULL, server_handle_event_query_full},
+    {ALARMD_EVENT_QUERY_PAGE, server_handle_event_query_page},
     {ALARMD_EVENT_UPDATE,server_handle_event_update},
 
     {ALARMD_SNOOZE_SET,  server_handle_snooze_set},
@@ -4184,6 +4904,26 @@ server_init(void)
   server_queue_touched_ignore_setup();
 #endif
 
+  /* - - - - - - - - - - - - - - - - - - - *
+   * queued events are kept sorted by the
+   * kind of wakeup they need
+   * - - - - - - - - - - - - - - - - - - - */
+
+  queue_set_wakeup_class_cb(server_event_get_wakeup_class);
+
+  /* - - - - - - - - - - - - - - - - - - - *
+   * changes to queued events are collected
+   * and broadcast after each rethink
+   * - - - - - - - - - - - - - - - - - - - */
+
+  server_queuechange_init();
+
+  /* - - - - - - - - - - - - - - - - - - - *
+   * alarm wakeups & clock change tracking
+   * - - - - - - - - - - - - - - - - - - - */
+
+  server_wakeup_init();
+
   /* - - - - - - - - - - - - - - - - - - - *
    * set the ball rolling
    * - - - - - - - - - - - - - - - - - - - */
@@ -4222,6 +4962,12 @@ server_quit(void)
 
   server_queue_cancel_save();
 
+  server_wakeup_quit();
+
+  queue_set_wakeup_class_cb(0);
+
+  server_queuechange_quit();
+
   ipc_icd_quit();
 
   server_quit_session_bus();
@@ -28,6 +28,102 @@
 
 #include <stdlib.h>
 
+/* ========================================================================= *
+ * CONSTANTS
+ * ========================================================================= */
+
+/* Tables smaller than this are searched linearly */
+#define SYMTAB_INDEX_MIN 8
+
+/* ========================================================================= *
+ * symtab_t  --  hash index
+ * ========================================================================= */
+
+/* ------------------------------------------------------------------------- *
+ * symtab_index_drop  --  release index, it is rebuilt when needed
+ * ------------------------------------------------------------------------- */
+
+static
+void
+symtab_index_drop(symtab_t *self)
+{
+  free(self->st_index);
+  self->st_index = 0;
+  self->st_slots = 0;
+}
+
+/* ------------------------------------------------------------------------- *
+ * symtab_index_insert  --  add st_elem[i] to index
+ * ------------------------------------------------------------------------- */
+
+static
+void
+symtab_index_insert(symtab_t *self, size_t i)
+{
+  size_t mask = self->st_slots - 1;
+  size_t slot = self->st_hash(self->st_key(self->st_elem[i])) & mask;
+
+  // linear probing: equal keys stay in insertion order
+  while( self->st_index[slot] != 0 )
+  {
+    slot = (slot + 1) & mask;
+  }
+  self->st_index[slot] = (uint32_t)(i + 1);
+}
+
+/* ------------------------------------------------------------------------- *
+ * symtab_index_rebuild  --  size index for current element count
+ * ------------------------------------------------------------------------- */
+
+static
+void
+symtab_index_rebuild(symtab_t *self)
+{
+  size_t slots = 16;
+
+  // keep load factor at or below 1/2
+  while( slots < 2 * (self->st_count + 1) )
+  {
+    slots <<= 1;
+  }
+
+  free(self->st_index);
+  self->st_slots = slots;
+  self->st_index = calloc(slots, sizeof *self->st_index);
+
+  for( size_t i = 0; i < self->st_count; ++i )
+  {
+    symtab_index_insert(self, i);
+  }
+}
+
+/* ------------------------------------------------------------------------- *
+ * symtab_index_lookup  --  find element via index
+ * ------------------------------------------------------------------------- */
+
+static
+void *
+symtab_index_lookup(symtab_t *self, const void *key)
+{
+  if( self->st_index == 0 )
+  {
+    symtab_index_rebuild(self);
+  }
+
+  size_t mask = self->st_slots - 1;
+  size_t slot = self->st_hash(key) & mask;
+
+  for( uint32_t i; (i = self->st_index[slot]) != 0; slot = (slot + 1) & mask )
+  {
+    void *elem = self->st_elem[i - 1];
+    if( self->st_cmp(elem, key) )
+    {
+      return elem;
+    }
+  }
+  return 0;
+}
+
 /* ========================================================================= *
  * symtab_t  --  methods
  * ========================================================================= */
@@ -39,6 +135,11 @@
 void *
 symtab_lookup(symtab_t *self, const void *key)
 {
+  if( self->st_hash != 0 && self->st_count >= SYMTAB_INDEX_MIN )
+  {
+    return symtab_index_lookup(self, key);
+  }
+
   for( int i = 0; i < self->st_count; ++i )
   {
     void *elem = self->st_elem[i];
@@ -73,6 +174,11 @@ symtab_remove(symtab_t *self, const void *key)
     }
   }
 
+  if( di != self->st_count )
+  {
+    symtab_index_drop(self);
+  }
+
   self->st_count = di;
 }
 
@@ -90,6 +196,18 @@ symtab_append(symtab_t *self, void *elem)
                             self->st_alloc * sizeof *self->st_elem);
   }
   self->st_elem[self->st_count++] = elem;
+
+  if( self->st_index != 0 )
+  {
+    if( 2 * self->st_count > self->st_slots )
+    {
+      symtab_index_rebuild(self);
+    }
+    else
+    {
+      symtab_index_insert(self, self->st_count - 1);
+    }
+  }
 }
 
 /* ------------------------------------------------------------------------- *
@@ -107,6 +225,8 @@ symtab_clear(symtab_t *self)
     }
   }
   self->st_count = 0;
+
+  symtab_index_drop(self);
 }
 
 /* ------------------------------------------------------------------------- *
@@ -121,6 +241,10 @@ symtab_ctor(symtab_t *self, symtab_del_fn del, symtab_cmp_fn cmp)
   self->st_elem  = 0;
   self->st_del   = del;
   self->st_cmp   = cmp;
+  self->st_key   = 0;
+  self->st_hash  = 0;
+  self->st_slots = 0;
+  self->st_index = 0;
 }
 
 /* ------------------------------------------------------------------------- *
@@ -171,3 +295,38 @@ symtab_delete_cb(void *self)
   symtab_delete(self);
 }
 #endif
+
+/* ------------------------------------------------------------------------- *
+ * symtab_set_index  --  enable hash index for lookups
+ *
+ * The key callback must return a key from an element that is
+ * comparable with lookup keys; the hash callback must give the
+ * same hash for keys that compare equal.
+ * ------------------------------------------------------------------------- */
+
+void
+symtab_set_index(symtab_t *self, symtab_key_fn key, symtab_hash_fn hash)
+{
+  symtab_index_drop(self);
+
+  self->st_key  = key;
+  self->st_hash = hash;
+}
+
+/* ------------------------------------------------------------------------- *
+ * symtab_hash_string  --  hash callback for C string keys
+ * ------------------------------------------------------------------------- */
+
+size_t
+symtab_hash_string(const void *str)
+{
+  // FNV-1a
+  const unsigned char *s = str;
+  uint32_t             h = 2166136261u;
+
+  while( *s )
+  {
+    h = (h ^ *s++) * 16777619u;
+  }
+  return h;
+}
@@ -26,6 +26,7 @@
 #define SYMTAB_H_
 
 #include <stddef.h>
+#include <stdint.h>
 
 #ifdef __cplusplus
 extern "C" {
@@ -35,6 +36,8 @@ extern "C" {
 
 typedef void (*symtab_del_fn)(void*);
 typedef int  (*symtab_cmp_fn)(const void *,const void *);
+typedef const void *(*symtab_key_fn)(const void *);
+typedef size_t      (*symtab_hash_fn)(const void *);
 
 typedef struct symtab_t   symtab_t;
 
@@ -50,6 +53,13 @@ struct symtab_t
 
   symtab_del_fn  st_del;
   symtab_cmp_fn  st_cmp;
+
+  /* optional open addressing hash index, holds st_elem
+   * offsets + 1, zero marks empty slot; built on demand */
+  symtab_key_fn  st_key;
+  symtab_hash_fn st_hash;
+  size_t         st_slots;
+  uint32_t      *st_index;
 };
 
 void     *symtab_lookup   (symtab_t *self, const void *key);
@@ -61,6 +71,8 @@ void      symtab_dtor     (symtab_t *self);
 symtab_t *symtab_create   (symtab_del_fn del, symtab_cmp_fn cmp);
 void      symtab_delete   (symtab_t *self);
 void      symtab_delete_cb(void *self);
+void      symtab_set_index(symtab_t *self, symtab_key_fn key, symtab_hash_fn hash);
+size_t    symtab_hash_string(const void *str);
 
 #ifdef __cplusplus
 };
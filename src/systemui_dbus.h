@@ -42,24 +42,28 @@
 
 # if 01 /* so called "new api" that was never taken to use
         * due to limitations in the way systemui passes
-        * dbus messages to plugins */
+        * dbus messages to plugins; alarmd uses it only if
+        * built with ALARMD_SYSTEMUI_BATCH enabled */
 
 /** @name DBus methods for alarmd
  **/
 
 /*@{*/
 
-/** @brief PLACEHOLDER
+/** @brief Batch open dialog request
  *
  * Adds alarm events into dialog queue.
  *
+ * The reply acknowledges all cookies that were queued
+ * for dialog, as ALARMD_DIALOG_ACK would.
+ *
  * @param cookies : ARRAY of INT32
  *
  * @returns inqueue : ARRAY of INT32
  **/
 #  define SYSTEMUI_ALARM_ADD "systemui_alarm_add"
 
-/** @brief PLACEHOLDER
+/** @brief Batch close dialog request
  *
  * Removes alarm events from dialog queue.
  *
@@ -25,6 +25,7 @@
 #include "alarmd_config.h"
 
 #include "ticker.h"
+#include "tzfile.h"
 #include "logging.h"
 
 #if USE_LIBTIME
@@ -442,6 +443,13 @@ static const ticker_driver_t drivers[] =
 
 static const ticker_driver_t *ticker_driver = &drivers[0];
 
+/* the in-process zone data is used only in place of libc
+ * conversions, libtime does its own time zone handling */
+static int ticker_use_tzfile(void)
+{
+  return ticker_driver == &drivers[0];
+}
+
 int ticker_get_synced(void)
 {
   return ticker_driver->cb_get_synced();
@@ -740,7 +748,10 @@ ticker_has_date(const struct tm *self)
 struct tm *
 ticker_break_tm(time_t t, struct tm *tm, const char *tz)
 {
-  ticker_get_remote(t, tz, tm);
+  if( !ticker_use_tzfile() || tzfile_break_tm(t, tm, tz) == -1 )
+  {
+    ticker_get_remote(t, tz, tm);
+  }
   return tm;
 }
 
@@ -751,7 +762,13 @@ ticker_break_tm(time_t t, struct tm *tm, const char *tz)
 time_t
 ticker_build_tm(struct tm *tm, const char *tz)
 {
-  return ticker_mktime(tm, tz);
+  time_t t = -1;
+
+  if( !ticker_use_tzfile() || tzfile_build_tm(tm, tz, &t) == -1 )
+  {
+    t = ticker_mktime(tm, tz);
+  }
+  return t;
 }
 
 /* ------------------------------------------------------------------------- *
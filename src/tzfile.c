@@ -0,0 +1,1321 @@
+/* ========================================================================= *
+ *
+ * This file is part of Alarmd
+ *
+ * Copyright (C) 2008-2009 Nokia Corporation and/or its subsidiary(-ies).
+ *
+ * Contact: Simo Piiroinen <simo.piiroinen@nokia.com>
+ *
+ * Alarmd is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * version 2.1 as published by the Free Software Foundation.
+ *
+ * Alarmd is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with Alarmd; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA
+ * 02110-1301 USA
+ *
+ * ========================================================================= */
+
+#include "alarmd_config.h"
+
+#include "tzfile.h"
+#include "logging.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <limits.h>
+#include <errno.h>
+#include <time.h>
+#include <sys/stat.h>
+
+/* ========================================================================= *
+ * CONSTANTS
+ * ========================================================================= */
+
+/* zone files are looked up from $TZDIR or ... */
+#define TZFILE_ZONEINFO_DIR "/usr/share/zoneinfo"
+
+/* ... and the local time zone is used if TZ is not set */
+#define TZFILE_LOCALTIME    "/etc/localtime"
+
+/* sanity limit for zone file size */
+#define TZFILE_MAX_SIZE     (256 << 10)
+
+/* zone names come from clients, limit the number of cached zones */
+#define TZFILE_MAX_ZONES    16
+
+/* minimum seconds between checking if /etc/localtime has changed */
+#define TZFILE_STALE_CHECK  1
+
+/* seconds per day */
+#define DAY (24 * 60 * 60)
+
+/* all utc offsets are within +/- 26 hours -> for resolving
+ * local time only changes within two days are relevant */
+#define TZFILE_WINDOW       (2 * DAY)
+
+/* how far to look for offset with requested dst flag,
+ * these are the same values that glibc mktime() uses */
+#define TZFILE_DST_STRIDE   (601200)
+#define TZFILE_DST_PROBE    (457243200 / 2 + TZFILE_DST_STRIDE)
+
+/* ========================================================================= *
+ * DATA TYPES
+ * ========================================================================= */
+
+typedef struct tztype_t tztype_t;
+typedef struct tzdate_t tzdate_t;
+typedef struct tzrule_t tzrule_t;
+typedef struct tzzone_t tzzone_t;
+
+/* ------------------------------------------------------------------------- *
+ * tztype_t  --  local time type
+ * ------------------------------------------------------------------------- */
+
+struct tztype_t
+{
+  /* seconds east of UTC */
+  int32_t     tt_utoff;
+
+  /* daylight saving time flag */
+  int         tt_isdst;
+
+  /* abbreviation, owned by the zone */
+  const char *tt_abbr;
+};
+
+/* ------------------------------------------------------------------------- *
+ * tzdate_t  --  POSIX TZ rule change date, e.g. "M3.5.0/3"
+ * ------------------------------------------------------------------------- */
+
+struct tzdate_t
+{
+  /* 'J' = Julian day 1-365, 'D' = day 0-365, 'M' = month.week.wday */
+  int     td_kind;
+
+  int     td_day;
+  int     td_mon;
+  int     td_week;
+  int     td_wday;
+
+  /* local time of day of the change */
+  int32_t td_secs;
+};
+
+/* ------------------------------------------------------------------------- *
+ * tzrule_t  --  POSIX TZ rule, used after the last transition
+ * ------------------------------------------------------------------------- */
+
+struct tzrule_t
+{
+  tztype_t  tr_std;
+  tztype_t  tr_dst;
+  int       tr_has_dst;
+  tzdate_t  tr_start;
+  tzdate_t  tr_end;
+
+  /* storage for std and dst abbreviations */
+  char      tr_abbr[2][32];
+};
+
+/* ------------------------------------------------------------------------- *
+ * tzzone_t  --  cached zone data
+ * ------------------------------------------------------------------------- */
+
+struct tzzone_t
+{
+  tzzone_t    *tz_next;
+
+  /* zone name used for lookup */
+  char        *tz_name;
+
+  /* file the data was loaded from, or NULL */
+  char        *tz_path;
+  struct stat  tz_stat;
+
+  /* monotonic time of the last tz_stat comparison */
+  time_t       tz_checked;
+
+  /* zero if the zone can't be handled */
+  int          tz_valid;
+
+  /* transitions and the time types following them */
+  size_t       tz_count;
+  int64_t     *tz_trans;
+  uint8_t     *tz_index;
+
+  /* local time types */
+  size_t       tz_types;
+  tztype_t    *tz_type;
+  char        *tz_chars;
+
+  /* type used before the first transition */
+  size_t       tz_initial;
+
+  /* rule used after the last transition */
+  int          tz_has_rule;
+  tzrule_t     tz_rule;
+};
+
+/* ========================================================================= *
+ * INTERNAL STATE DATA
+ * ========================================================================= */
+
+/* recently used zones that could be loaded, most recent first */
+static tzzone_t *tzfile_zones = 0;
+
+/* ========================================================================= *
+ * CALENDAR ARITHMETIC
+ * ========================================================================= */
+
+/* ------------------------------------------------------------------------- *
+ * tzfile_is_leap_year
+ * ------------------------------------------------------------------------- */
+
+static inline int
+tzfile_is_leap_year(int64_t y)
+{
+  return (y % 4 == 0) && ((y % 100 != 0) || (y % 400 == 0));
+}
+
+/* ------------------------------------------------------------------------- *
+ * tzfile_days_from_civil  --  year, month (1-12), mday -> days since epoch
+ * ------------------------------------------------------------------------- */
+
+static int64_t
+tzfile_days_from_civil(int64_t y, int m, int d)
+{
+  y -= (m <= 2);
+
+  int64_t  era = (y >= 0 ? y : y - 399) / 400;
+  unsigned yoe = (unsigned)(y - era * 400);
+  unsigned doy = (153 * (m + (m > 2 ? -3 : 9)) + 2) / 5 + d - 1;
+  unsigned doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+
+  return era * 146097 + (int64_t)doe - 719468;
+}
+
+/* ------------------------------------------------------------------------- *
+ * tzfile_civil_from_days  --  days since epoch -> year, month (1-12), mday
+ * ------------------------------------------------------------------------- */
+
+static void
+tzfile_civil_from_days(int64_t z, int64_t *py, int *pm, int *pd)
+{
+  z += 719468;
+
+  int64_t  era = (z >= 0 ? z : z - 146096) / 146097;
+  unsigned doe = (unsigned)(z - era * 146097);
+  unsigned yoe = (doe - doe / 1460 + doe / 36524 - doe / 146096) / 365;
+  unsigned doy = doe - (365 * yoe + yoe / 4 - yoe / 100);
+  unsigned mp  = (5 * doy + 2) / 153;
+  unsigned m   = (mp < 10) ? (mp + 3) : (mp - 9);
+
+  *py = (int64_t)yoe + era * 400 + (m <= 2);
+  *pm = m;
+  *pd = doy - (153 * mp + 2) / 5 + 1;
+}
+
+/* ------------------------------------------------------------------------- *
+ * tzfile_floor_div  --  integer division rounding towards -inf
+ * ------------------------------------------------------------------------- */
+
+static inline int64_t
+tzfile_floor_div(int64_t a, int64_t b)
+{
+  return (a >= 0) ? (a / b) : -((b - 1 - a) / b);
+}
+
+/* ========================================================================= *
+ * POSIX TZ RULES
+ * ========================================================================= */
+
+/* ------------------------------------------------------------------------- *
+ * tzrule_parse_num  --  parse bounded decimal number
+ * ------------------------------------------------------------------------- */
+
+static const char *
+tzrule_parse_num(const char *s, int lo, int hi, int *pval)
+{
+  int val = 0;
+
+  if( s == 0 || *s < '0' || *s > '9' )
+  {
+    return 0;
+  }
+  while( '0' <= *s && *s <= '9' )
+  {
+    if( (val = val * 10 + (*s++ - '0')) > hi )
+    {
+      return 0;
+    }
+  }
+  if( val < lo )
+  {
+    return 0;
+  }
+  *pval = val;
+  return s;
+}
+
+/* ------------------------------------------------------------------------- *
+ * tzrule_parse_name  --  parse "EET" or "<+03>" style abbreviation
+ * ------------------------------------------------------------------------- */
+
+static const char *
+tzrule_parse_name(const char *s, char *buf, size_t size)
+{
+  size_t n = 0;
+
+  if( *s == '<' )
+  {
+    for( ++s; *s && *s != '>'; ++s )
+    {
+      if( n + 1 >= size ) return 0;
+      buf[n++] = *s;
+    }
+    if( *s++ != '>' ) return 0;
+  }
+  else
+  {
+    for( ; ('a' <= *s && *s <= 'z') || ('A' <= *s && *s <= 'Z'); ++s )
+    {
+      if( n + 1 >= size ) return 0;
+      buf[n++] = *s;
+    }
+  }
+  buf[n] = 0;
+
+  return (n < 3) ? 0 : s;
+}
+
+/* ------------------------------------------------------------------------- *
+ * tzrule_parse_time  --  parse "[+-]hh[:mm[:ss]]" to seconds
+ * ------------------------------------------------------------------------- */
+
+static const char *
+tzrule_parse_time(const char *s, int32_t *psecs)
+{
+  int sgn = 1, h = 0, m = 0, x = 0;
+
+  if( *s == '+' || *s == '-' )
+  {
+    sgn = (*s++ == '-') ? -1 : 1;
+  }
+  if( !(s = tzrule_parse_num(s, 0, 167, &h)) )
+  {
+    return 0;
+  }
+  if( *s == ':' && !(s = tzrule_parse_num(s+1, 0, 59, &m)) )
+  {
+    return 0;
+  }
+  if( s && *s == ':' && !(s = tzrule_parse_num(s+1, 0, 59, &x)) )
+  {
+    return 0;
+  }
+  *psecs = sgn * (h * 3600 + m * 60 + x);
+  return s;
+}
+
+/* ------------------------------------------------------------------------- *
+ * tzrule_parse_date  --  parse ",Jn[/time]", ",n[/time]" or ",Mm.w.d[/time]"
+ * ------------------------------------------------------------------------- */
+
+static const char *
+tzrule_parse_date(const char *s, tzdate_t *date)
+{
+  if( *s++ != ',' )
+  {
+    return 0;
+  }
+
+  memset(date, 0, sizeof *date);
+
+  if( *s == 'J' )
+  {
+    date->td_kind = 'J';
+    s = tzrule_parse_num(s+1, 1, 365, &date->td_day);
+  }
+  else if( *s == 'M' )
+  {
+    date->td_kind = 'M';
+    if( (s = tzrule_parse_num(s+1, 1, 12, &date->td_mon)) && *s == '.' &&
+        (s = tzrule_parse_num(s+1, 1, 5, &date->td_week)) && *s == '.' )
+    {
+      s = tzrule_parse_num(s+1, 0, 6, &date->td_wday);
+    }
+    else
+    {
+      s = 0;
+    }
+  }
+  else
+  {
+    date->td_kind = 'D';
+    s = tzrule_parse_num(s, 0, 365, &date->td_day);
+  }
+
+  date->td_secs = 2 * 60 * 60;
+
+  if( s && *s == '/' )
+  {
+    s = tzrule_parse_time(s+1, &date->td_secs);
+  }
+  return s;
+}
+
+/* ------------------------------------------------------------------------- *
+ * tzrule_parse  --  parse POSIX TZ string, e.g. "EET-2EEST,M3.5.0/3,M10.5.0/4"
+ * ------------------------------------------------------------------------- */
+
+static int
+tzrule_parse(tzrule_t *self, const char *s)
+{
+  int32_t offs = 0;
+
+  memset(self, 0, sizeof *self);
+
+  if( !(s = tzrule_parse_name(s, self->tr_abbr[0], sizeof self->tr_abbr[0])) ||
+      !(s = tzrule_parse_time(s, &offs)) )
+  {
+    return -1;
+  }
+
+  // POSIX offsets are positive west of UTC
+  self->tr_std.tt_utoff = -offs;
+  self->tr_std.tt_isdst = 0;
+  self->tr_std.tt_abbr  = self->tr_abbr[0];
+
+  if( *s == 0 )
+  {
+    return 0;
+  }
+
+  if( !(s = tzrule_parse_name(s, self->tr_abbr[1], sizeof self->tr_abbr[1])) )
+  {
+    return -1;
+  }
+
+  self->tr_has_dst = 1;
+  self->tr_dst.tt_utoff = self->tr_std.tt_utoff + 60 * 60;
+  self->tr_dst.tt_isdst = 1;
+  self->tr_dst.tt_abbr  = self->tr_abbr[1];
+
+  if( *s != 0 && *s != ',' )
+  {
+    if( !(s = tzrule_parse_time(s, &offs)) )
+    {
+      return -1;
+    }
+    self->tr_dst.tt_utoff = -offs;
+  }
+
+  if( *s == 0 )
+  {
+    // default to US rules, as glibc does
+    s = ",M3.2.0,M11.1.0";
+  }
+
+  if( !(s = tzrule_parse_date(s, &self->tr_start)) ||
+      !(s = tzrule_parse_date(s, &self->tr_end)) || *s != 0 )
+  {
+    return -1;
+  }
+
+  return 0;
+}
+
+/* ------------------------------------------------------------------------- *
+ * tzrule_change  --  utc time of rule change date in given year
+ * ------------------------------------------------------------------------- */
+
+static int64_t
+tzrule_change(const tzdate_t *date, int64_t year, int32_t utoff)
+{
+  int64_t day = tzfile_days_from_civil(year, 1, 1);
+
+  switch( date->td_kind )
+  {
+  case 'J':
+    // 1-365, February 29th is never counted
+    day += date->td_day - 1;
+    if( date->td_day >= 60 && tzfile_is_leap_year(year) )
+    {
+      day += 1;
+    }
+    break;
+
+  case 'D':
+    day += date->td_day;
+    break;
+
+  default:
+    {
+      static const int mdays[12] =
+      {
+        31,28,31,30,31,30,31,31,30,31,30,31
+      };
+
+      int     mon   = date->td_mon;
+      int     last  = mdays[mon-1] + (mon == 2 && tzfile_is_leap_year(year));
+      int64_t first = tzfile_days_from_civil(year, mon, 1);
+      int     wday  = (int)(((first % 7) + 11) % 7);
+      int     mday  = 1 + (date->td_wday - wday + 7) % 7 + 7 * (date->td_week - 1);
+
+      while( mday > last )
+      {
+        mday -= 7;
+      }
+      day = first + mday - 1;
+    }
+    break;
+  }
+
+  return day * DAY + date->td_secs - utoff;
+}
+
+/* ------------------------------------------------------------------------- *
+ * tzrule_span  --  utc times of dst start and end in given year
+ * ------------------------------------------------------------------------- */
+
+static void
+tzrule_span(const tzrule_t *self, int64_t year, int64_t *pbeg, int64_t *pend)
+{
+  // start is given in standard time, end in daylight saving time
+  *pbeg = tzrule_change(&self->tr_start, year, self->tr_std.tt_utoff);
+  *pend = tzrule_change(&self->tr_end,   year, self->tr_dst.tt_utoff);
+}
+
+/* ------------------------------------------------------------------------- *
+ * tzrule_year  --  local standard time year for utc time
+ * ------------------------------------------------------------------------- */
+
+static int64_t
+tzrule_year(const tzrule_t *self, int64_t t)
+{
+  int64_t y; int m, d;
+  tzfile_civil_from_days(tzfile_floor_div(t + self->tr_std.tt_utoff, DAY),
+                         &y, &m, &d);
+  return y;
+}
+
+/* ------------------------------------------------------------------------- *
+ * tzrule_lookup  --  local time type in effect at utc time
+ * ------------------------------------------------------------------------- */
+
+static const tztype_t *
+tzrule_lookup(const tzrule_t *self, int64_t t)
+{
+  int64_t beg, end;
+
+  if( !self->tr_has_dst )
+  {
+    return &self->tr_std;
+  }
+
+  tzrule_span(self, tzrule_year(self, t), &beg, &end);
+
+  if( beg < end )
+  {
+    // northern hemisphere
+    return (beg <= t && t < end) ? &self->tr_dst : &self->tr_std;
+  }
+
+  // southern hemisphere
+  return (end <= t && t < beg) ? &self->tr_std : &self->tr_dst;
+}
+
+/* ------------------------------------------------------------------------- *
+ * tzrule_next_change  --  first rule based change after utc time
+ * ------------------------------------------------------------------------- */
+
+static int
+tzrule_next_change(const tzrule_t *self, int64_t t, int64_t *pnext)
+{
+  int64_t best = INT64_MAX;
+  int64_t year = tzrule_year(self, t);
+
+  if( !self->tr_has_dst )
+  {
+    return -1;
+  }
+
+  for( int64_t y = year - 1; y <= year + 1; ++y )
+  {
+    int64_t beg, end;
+    tzrule_span(self, y, &beg, &end);
+    if( beg > t && beg < best ) best = beg;
+    if( end > t && end < best ) best = end;
+  }
+  *pnext = best;
+  return 0;
+}
+
+/* ========================================================================= *
+ * ZONE DATA
+ * ========================================================================= */
+
+/* ------------------------------------------------------------------------- *
+ * tzzone_lookup  --  local time type in effect at utc time
+ * ------------------------------------------------------------------------- */
+
+static const tztype_t *
+tzzone_lookup(const tzzone_t *self, int64_t t)
+{
+  size_t l, h, i;
+
+  if( self->tz_count == 0 || t < self->tz_trans[0] )
+  {
+    if( self->tz_types == 0 )
+    {
+      return tzrule_lookup(&self->tz_rule, t);
+    }
+    return &self->tz_type[self->tz_initial];
+  }
+
+  if( self->tz_has_rule && t >= self->tz_trans[self->tz_count-1] )
+  {
+    return tzrule_lookup(&self->tz_rule, t);
+  }
+
+  // find the last transition at or before t
+  for( l = 0, h = self->tz_count; l + 1 < h; )
+  {
+    i = (l + h) / 2;
+    if( self->tz_trans[i] <= t ) l = i; else h = i;
+  }
+  return &self->tz_type[self->tz_index[l]];
+}
+
+/* ------------------------------------------------------------------------- *
+ * tzzone_next_change  --  first transition after utc time
+ * ------------------------------------------------------------------------- */
+
+static int
+tzzone_next_change(const tzzone_t *self, int64_t t, int64_t *pnext)
+{
+  size_t l, h, i;
+
+  if( self->tz_count == 0 )
+  {
+    return (self->tz_types == 0) ? tzrule_next_change(&self->tz_rule, t, pnext) : -1;
+  }
+
+  // find the first transition after t
+  for( l = 0, h = self->tz_count; l < h; )
+  {
+    i = (l + h) / 2;
+    if( self->tz_trans[i] <= t ) l = i + 1; else h = i;
+  }
+
+  if( l < self->tz_count )
+  {
+    *pnext = self->tz_trans[l];
+    return 0;
+  }
+
+  if( self->tz_has_rule )
+  {
+    return tzrule_next_change(&self->tz_rule, t, pnext);
+  }
+  return -1;
+}
+
+/* ------------------------------------------------------------------------- *
+ * tzzone_nearest_dst  --  offset of the nearest time with given dst flag
+ * ------------------------------------------------------------------------- */
+
+static int
+tzzone_nearest_dst(const tzzone_t *self, int64_t t, int isdst, int32_t *poffs)
+{
+  for( int64_t delta = TZFILE_DST_STRIDE; delta < TZFILE_DST_PROBE;
+       delta += TZFILE_DST_STRIDE )
+  {
+    for( int dir = -1; dir <= 1; dir += 2 )
+    {
+      const tztype_t *tt = tzzone_lookup(self, t + dir * delta);
+      if( tt->tt_isdst == isdst )
+      {
+        *poffs = tt->tt_utoff;
+        return 0;
+      }
+    }
+  }
+  return -1;
+}
+
+/* ------------------------------------------------------------------------- *
+ * tzzone_solve  --  local wall clock seconds -> utc time, like mktime()
+ *
+ * This follows the glibc mktime() algorithm step by step, so that
+ * skipped times and tm_isdst hints that do not match the time of
+ * year are resolved the same way, including returning an error when
+ * mktime() would do so. Only the initial guess differs, see below.
+ * ------------------------------------------------------------------------- */
+
+static int
+tzzone_solve(const tzzone_t *self, int64_t loc, int isdst, int64_t *pt)
+{
+  /* - - - - - - - - - - - - - - - - - - - *
+   * start from the offset in effect before
+   * the local time and use the error to
+   * improve the guess
+   *
+   * mktime() starts from the offset found
+   * by the previous call instead, which
+   * makes ambiguous times depend on the
+   * call history
+   * - - - - - - - - - - - - - - - - - - - */
+
+  const tztype_t *tt   = tzzone_lookup(self, loc - TZFILE_WINDOW);
+  int64_t         t    = loc - tt->tt_utoff;
+  int64_t         t1   = t;
+  int64_t         t2   = t;
+  int             dst2 = 0;
+
+  for( int probes = 6; ; )
+  {
+    tt = tzzone_lookup(self, t);
+
+    int64_t dt = loc - (t + tt->tt_utoff);
+
+    if( dt == 0 )
+    {
+      break;
+    }
+
+    if( t == t1 && t != t2 &&
+        (isdst < 0 ? dst2 <= (tt->tt_isdst != 0)
+         : (isdst != 0) != (tt->tt_isdst != 0)) )
+    {
+      // oscillating over skipped time: like mktime(), return
+      // the time that has the other than requested dst flag,
+      // or prefer dst time when nothing was requested
+      goto found;
+    }
+
+    if( --probes == 0 )
+    {
+      return -1;
+    }
+
+    t1 = t2, t2 = t, t += dt, dst2 = (tt->tt_isdst != 0);
+  }
+
+  /* - - - - - - - - - - - - - - - - - - - *
+   * dst setting does not match: use the
+   * offset from the nearest time that does
+   * match, or assume one hour dst shift
+   * - - - - - - - - - - - - - - - - - - - */
+
+  if( isdst >= 0 && (isdst != 0) != (tt->tt_isdst != 0) )
+  {
+    int32_t want = 0;
+
+    if( tzzone_nearest_dst(self, t, (isdst != 0), &want) == 0 )
+    {
+      t = loc - want;
+    }
+    else
+    {
+      t += 60 * 60 * ((isdst == 0) - (tt->tt_isdst == 0));
+    }
+  }
+
+found:
+  *pt = t;
+  return 0;
+}
+
+/* ------------------------------------------------------------------------- *
+ * tzzone_load_tzif  --  parse TZif format zone file data
+ * ------------------------------------------------------------------------- */
+
+static int
+tzzone_load_tzif(tzzone_t *self, const unsigned char *data, size_t size)
+{
+  const unsigned char *pos = data;
+  const unsigned char *end = data + size;
+
+  uint32_t cnt_ut, cnt_std, cnt_leap, cnt_time, cnt_type, cnt_char;
+  int      vers, tsize = 4;
+
+  auto uint32_t be32(const unsigned char *p);
+  auto uint32_t be32(const unsigned char *p)
+  {
+    return ((uint32_t)p[0] << 24) | ((uint32_t)p[1] << 16) |
+           ((uint32_t)p[2] <<  8) | ((uint32_t)p[3] <<  0);
+  }
+
+  auto int header(void);
+  auto int header(void)
+  {
+    if( end - pos < 44 || memcmp(pos, "TZif", 4) )
+    {
+      return -1;
+    }
+    vers     = pos[4];
+    cnt_ut   = be32(pos + 20);
+    cnt_std  = be32(pos + 24);
+    cnt_leap = be32(pos + 28);
+    cnt_time = be32(pos + 32);
+    cnt_type = be32(pos + 36);
+    cnt_char = be32(pos + 40);
+    pos += 44;
+
+    size_t need = (size_t)cnt_time * (tsize + 1) + (size_t)cnt_type * 6 +
+                  cnt_char + (size_t)cnt_leap * (tsize + 4) + cnt_std + cnt_ut;
+
+    return (cnt_type == 0 || cnt_type > 256 || end - pos < need) ? -1 : 0;
+  }
+
+  /* - - - - - - - - - - - - - - - - - - - *
+   * version 2+ files have 64 bit data
+   * after the 32 bit data block
+   * - - - - - - - - - - - - - - - - - - - */
+
+  if( header() == -1 )
+  {
+    return -1;
+  }
+
+  if( vers >= '2' )
+  {
+    pos += (size_t)cnt_time * 5 + (size_t)cnt_type * 6 + cnt_char +
+           (size_t)cnt_leap * 8 + cnt_std + cnt_ut;
+    tsize = 8;
+
+    if( header() == -1 )
+    {
+      return -1;
+    }
+  }
+
+  if( cnt_leap != 0 )
+  {
+    // leap second aware zones are left to libc
+    log_debug("%s: leap seconds not supported\n", self->tz_name);
+    return -1;
+  }
+
+  /* - - - - - - - - - - - - - - - - - - - *
+   * transitions and local time types
+   * - - - - - - - - - - - - - - - - - - - */
+
+  self->tz_count = cnt_time;
+  self->tz_trans = calloc(cnt_time + 1, sizeof *self->tz_trans);
+  self->tz_index = calloc(cnt_time + 1, sizeof *self->tz_index);
+  self->tz_types = cnt_type;
+  self->tz_type  = calloc(cnt_type, sizeof *self->tz_type);
+  self->tz_chars = calloc(cnt_char + 1, 1);
+
+  for( size_t i = 0; i < cnt_time; ++i, pos += tsize )
+  {
+    if( tsize == 8 )
+    {
+      self->tz_trans[i] = (int64_t)(((uint64_t)be32(pos) << 32) | be32(pos + 4));
+    }
+    else
+    {
+      self->tz_trans[i] = (int32_t)be32(pos);
+    }
+  }
+
+  for( size_t i = 0; i < cnt_time; ++i )
+  {
+    if( (self->tz_index[i] = *pos++) >= cnt_type )
+    {
+      return -1;
+    }
+  }
+
+  const unsigned char *ttinfo = pos;
+
+  pos += cnt_type * 6;
+  memcpy(self->tz_chars, pos, cnt_char);
+  pos += cnt_char;
+
+  for( size_t i = 0; i < cnt_type; ++i, ttinfo += 6 )
+  {
+    if( ttinfo[5] >= cnt_char + 1 )
+    {
+      return -1;
+    }
+    self->tz_type[i].tt_utoff = (int32_t)be32(ttinfo);
+    self->tz_type[i].tt_isdst = (ttinfo[4] != 0);
+    self->tz_type[i].tt_abbr  = self->tz_chars + ttinfo[5];
+  }
+
+  // before the first transition: first standard time type
+  for( self->tz_initial = 0; self->tz_initial < cnt_type; ++self->tz_initial )
+  {
+    if( !self->tz_type[self->tz_initial].tt_isdst ) break;
+  }
+  if( self->tz_initial == cnt_type )
+  {
+    self->tz_initial = 0;
+  }
+
+  pos += (size_t)cnt_leap * (tsize + 4) + cnt_std + cnt_ut;
+
+  /* - - - - - - - - - - - - - - - - - - - *
+   * version 2+ footer: POSIX TZ rule for
+   * times after the last transition
+   * - - - - - - - - - - - - - - - - - - - */
+
+  if( tsize == 8 && pos < end && *pos == '\n' )
+  {
+    const unsigned char *beg = ++pos;
+    while( pos < end && *pos != '\n' ) ++pos;
+
+    if( pos < end && pos > beg )
+    {
+      char tmp[pos - beg + 1];
+      memcpy(tmp, beg, pos - beg);
+      tmp[pos - beg] = 0;
+
+      if( tzrule_parse(&self->tz_rule, tmp) == -1 )
+      {
+        log_debug("%s: unsupported rule '%s'\n", self->tz_name, tmp);
+        return -1;
+      }
+      self->tz_has_rule = 1;
+    }
+  }
+
+  return 0;
+}
+
+/* ------------------------------------------------------------------------- *
+ * tzzone_load_file  --  load zone data from file
+ * ------------------------------------------------------------------------- */
+
+static int
+tzzone_load_file(tzzone_t *self, const char *path)
+{
+  int            res  = -1;
+  FILE          *file = 0;
+  unsigned char *data = 0;
+  size_t         size = 0;
+
+  if( (file = fopen(path, "r")) == 0 )
+  {
+    goto cleanup;
+  }
+
+  if( fstat(fileno(file), &self->tz_stat) == -1 ||
+      self->tz_stat.st_size > TZFILE_MAX_SIZE )
+  {
+    goto cleanup;
+  }
+
+  size = self->tz_stat.st_size;
+  data = malloc(size + 1);
+
+  if( fread(data, 1, size, file) != size )
+  {
+    goto cleanup;
+  }
+
+  self->tz_path = strdup(path);
+  res = tzzone_load_tzif(self, data, size);
+
+cleanup:
+
+  if( file != 0 ) fclose(file);
+  free(data);
+
+  return res;
+}
+
+/* ------------------------------------------------------------------------- *
+ * tzzone_delete
+ * ------------------------------------------------------------------------- */
+
+static void
+tzzone_delete(tzzone_t *self)
+{
+  if( self != 0 )
+  {
+    free(self->tz_name);
+    free(self->tz_path);
+    free(self->tz_trans);
+    free(self->tz_index);
+    free(self->tz_type);
+    free(self->tz_chars);
+    free(self);
+  }
+}
+
+/* ------------------------------------------------------------------------- *
+ * tzzone_create  --  load zone by TZ style name
+ * ------------------------------------------------------------------------- */
+
+static tzzone_t *
+tzzone_create(const char *name)
+{
+  tzzone_t *self = calloc(1, sizeof *self);
+  char      path[512];
+
+  self->tz_name = strdup(name);
+
+  if( *name == '/' )
+  {
+    snprintf(path, sizeof path, "%s", name);
+  }
+  else
+  {
+    const char *dir = getenv("TZDIR");
+    snprintf(path, sizeof path, "%s/%s",
+             (dir && *dir) ? dir : TZFILE_ZONEINFO_DIR, name);
+  }
+
+  if( tzzone_load_file(self, path) == 0 )
+  {
+    self->tz_valid = 1;
+  }
+  else if( self->tz_path == 0 && tzrule_parse(&self->tz_rule, name) == 0 )
+  {
+    // not a zone file, but valid POSIX TZ string
+    self->tz_valid    = 1;
+    self->tz_has_rule = 1;
+  }
+  else
+  {
+    log_debug("%s: zone not supported\n", name);
+  }
+
+  return self;
+}
+
+/* ------------------------------------------------------------------------- *
+ * tzzone_is_stale  --  zone file changed after loading
+ *
+ * The file is checked at most once per TZFILE_STALE_CHECK seconds,
+ * recurrence scans do thousands of conversions in a row.
+ * ------------------------------------------------------------------------- */
+
+static int
+tzzone_is_stale(tzzone_t *self)
+{
+  struct timespec ts;
+  struct stat     st;
+
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+
+  if( self->tz_checked != 0 &&
+      ts.tv_sec - self->tz_checked < TZFILE_STALE_CHECK )
+  {
+    return 0;
+  }
+  self->tz_checked = ts.tv_sec;
+
+  if( stat(self->tz_path, &st) == -1 )
+  {
+    return 1;
+  }
+
+  return (st.st_ino   != self->tz_stat.st_ino   ||
+          st.st_dev   != self->tz_stat.st_dev   ||
+          st.st_size  != self->tz_stat.st_size  ||
+          st.st_mtime != self->tz_stat.st_mtime);
+}
+
+/* ------------------------------------------------------------------------- *
+ * tzfile_get_zone  --  get cached zone data for TZ style name
+ * ------------------------------------------------------------------------- */
+
+static const tzzone_t *
+tzfile_get_zone(const char *tz)
+{
+  tzzone_t **pos, *zone;
+
+  if( tz == 0 || *tz == 0 )
+  {
+    tz = getenv("TZ");
+  }
+  if( tz == 0 || *tz == 0 )
+  {
+    tz = TZFILE_LOCALTIME;
+  }
+  if( *tz == ':' )
+  {
+    ++tz;
+  }
+
+  for( pos = &tzfile_zones; (zone = *pos) != 0; pos = &zone->tz_next )
+  {
+    if( strcmp(zone->tz_name, tz) )
+    {
+      continue;
+    }
+
+    // the default zone can be changed by replacing /etc/localtime
+    if( zone->tz_path && !strcmp(zone->tz_path, TZFILE_LOCALTIME) &&
+        tzzone_is_stale(zone) )
+    {
+      *pos = zone->tz_next;
+      tzzone_delete(zone);
+      break;
+    }
+
+    // move to front, typically only a couple of zones are used
+    *pos = zone->tz_next;
+    zone->tz_next = tzfile_zones;
+    tzfile_zones = zone;
+
+    return zone;
+  }
+
+  /* - - - - - - - - - - - - - - - - - - - *
+   * failures are not cached, otherwise
+   * bogus names from clients would just
+   * accumulate in the cache
+   * - - - - - - - - - - - - - - - - - - - */
+
+  zone = tzzone_create(tz);
+
+  if( !zone->tz_valid )
+  {
+    tzzone_delete(zone);
+    return 0;
+  }
+
+  zone->tz_next = tzfile_zones;
+  tzfile_zones = zone;
+
+  /* - - - - - - - - - - - - - - - - - - - *
+   * drop the least recently used zones
+   * if the cache grows too large
+   * - - - - - - - - - - - - - - - - - - - */
+
+  int cnt = 0;
+
+  for( pos = &tzfile_zones; (zone = *pos) != 0; pos = &zone->tz_next )
+  {
+    if( ++cnt > TZFILE_MAX_ZONES )
+    {
+      *pos = 0;
+      while( zone != 0 )
+      {
+        tzzone_t *next = zone->tz_next;
+        tzzone_delete(zone);
+        zone = next;
+      }
+      break;
+    }
+  }
+
+  return tzfile_zones;
+}
+
+/* ------------------------------------------------------------------------- *
+ * tzfile_flush  --  drop all cached zone data
+ * ------------------------------------------------------------------------- */
+
+void
+tzfile_flush(void)
+{
+  tzzone_t *zone;
+
+  while( (zone = tzfile_zones) != 0 )
+  {
+    tzfile_zones = zone->tz_next;
+    tzzone_delete(zone);
+  }
+}
+
+/* ========================================================================= *
+ * CONVERSIONS
+ * ========================================================================= */
+
+/* ------------------------------------------------------------------------- *
+ * tzfile_fill_tm  --  utc time + local time type -> struct tm
+ * ------------------------------------------------------------------------- */
+
+static int
+tzfile_fill_tm(int64_t t, const tztype_t *tt, struct tm *tm)
+{
+  int64_t loc  = t + tt->tt_utoff;
+  int64_t days = tzfile_floor_div(loc, DAY);
+  int64_t secs = loc - days * DAY;
+  int64_t year;
+  int     mon, mday;
+
+  tzfile_civil_from_days(days, &year, &mon, &mday);
+
+  if( year - 1900 < INT_MIN || year - 1900 > INT_MAX )
+  {
+    errno = EOVERFLOW;
+    return -1;
+  }
+
+  tm->tm_sec    = (int)(secs % 60);
+  tm->tm_min    = (int)(secs / 60 % 60);
+  tm->tm_hour   = (int)(secs / 3600);
+  tm->tm_mday   = mday;
+  tm->tm_mon    = mon - 1;
+  tm->tm_year   = (int)(year - 1900);
+  tm->tm_wday   = (int)(((days % 7) + 11) % 7);
+  tm->tm_yday   = (int)(days - tzfile_days_from_civil(year, 1, 1));
+  tm->tm_isdst  = tt->tt_isdst;
+#ifdef _GNU_SOURCE
+  tm->tm_gmtoff = tt->tt_utoff;
+  tm->tm_zone   = tt->tt_abbr;
+#endif
+
+  return 0;
+}
+
+/* ------------------------------------------------------------------------- *
+ * tzfile_break_tm  --  time_t -> struct tm in given timezone
+ * ------------------------------------------------------------------------- */
+
+int
+tzfile_break_tm(time_t t, struct tm *tm, const char *tz)
+{
+  const tzzone_t *zone = tzfile_get_zone(tz);
+
+  if( zone == 0 )
+  {
+    return -1;
+  }
+
+  tzfile_fill_tm(t, tzzone_lookup(zone, t), tm);
+  return 0;
+}
+
+/* ------------------------------------------------------------------------- *
+ * tzfile_build_tm  --  struct tm + timezone -> time_t, like mktime()
+ * ------------------------------------------------------------------------- */
+
+int
+tzfile_build_tm(struct tm *tm, const char *tz, time_t *pt)
+{
+  const tzzone_t *zone = tzfile_get_zone(tz);
+
+  if( zone == 0 )
+  {
+    return -1;
+  }
+
+  /* - - - - - - - - - - - - - - - - - - - *
+   * normalize to local wall clock seconds
+   * - - - - - - - - - - - - - - - - - - - */
+
+  int64_t mon  = tm->tm_mon;
+  int64_t year = tm->tm_year + 1900LL + tzfile_floor_div(mon, 12);
+
+  mon -= tzfile_floor_div(mon, 12) * 12;
+
+  // out of range seconds are added after solving, as mktime() does
+  int     sec = (tm->tm_sec < 0) ? 0 : (tm->tm_sec > 59) ? 59 : tm->tm_sec;
+
+  int64_t loc = ((tzfile_days_from_civil(year, (int)mon + 1, 1) +
+                  tm->tm_mday - 1) * DAY +
+                 tm->tm_hour * 3600LL + tm->tm_min * 60LL + sec);
+
+  /* - - - - - - - - - - - - - - - - - - - *
+   * resolve utc time and update struct tm
+   * - - - - - - - - - - - - - - - - - - - */
+
+  int64_t   t = 0;
+  struct tm tmp;
+
+  if( tzzone_solve(zone, loc, tm->tm_isdst, &t) == -1 )
+  {
+    errno = EOVERFLOW;
+    *pt = -1;
+    return 0;
+  }
+
+  t += tm->tm_sec - sec;
+
+  if( (time_t)t != t || tzfile_fill_tm(t, tzzone_lookup(zone, t), &tmp) == -1 )
+  {
+    errno = EOVERFLOW;
+    *pt = -1;
+    return 0;
+  }
+
+  *tm = tmp;
+  *pt = (time_t)t;
+  return 0;
+}
+
+/* ------------------------------------------------------------------------- *
+ * tzfile_next_gap  --  next skipped range of local wall clock time
+ * ------------------------------------------------------------------------- */
+
+int
+tzfile_next_gap(const char *tz, time_t loc, time_t *pbeg, time_t *pend)
+{
+  const tzzone_t *zone = tzfile_get_zone(tz);
+
+  if( zone == 0 )
+  {
+    return -1;
+  }
+
+  int64_t t    = (int64_t)loc - TZFILE_WINDOW;
+  int32_t prev = tzzone_lookup(zone, t)->tt_utoff;
+
+  // rules where dst and standard time have the same offset
+  // change forever without skipping anything -> give up after
+  // the same number of transitions as tzfile_next_change()
+  for( int n = 0; n < 64 && tzzone_next_change(zone, t, &t) == 0; ++n )
+  {
+    int32_t curr = tzzone_lookup(zone, t)->tt_utoff;
+
+    if( curr > prev && t + curr > loc )
+    {
+      *pbeg = (time_t)(t + prev);
+      *pend = (time_t)(t + curr);
+      return 1;
+    }
+    prev = curr;
+  }
+  return 0;
+}
+
+/* ------------------------------------------------------------------------- *
+ * tzfile_next_change  --  next utc offset change after given time
+ * ------------------------------------------------------------------------- */
+
+int
+tzfile_next_change(const char *tz, time_t t, time_t *pnext)
+{
+  const tzzone_t *zone = tzfile_get_zone(tz);
+  int64_t         next = 0;
+
+  if( zone == 0 )
+  {
+    return -1;
+  }
+
+  int32_t curr = tzzone_lookup(zone, t)->tt_utoff;
+
+  // skip transitions that change only the abbreviation or dst flag,
+  // but do not loop forever on rules that never change the offset
+  for( int64_t pos = t, n = 0; ; pos = next )
+  {
+    if( tzzone_next_change(zone, pos, &next) == -1 )
+    {
+      return 0;
+    }
+    if( tzzone_lookup(zone, next)->tt_utoff != curr || ++n == 64 )
+    {
+      *pnext = (time_t)next;
+      return 1;
+    }
+  }
+}
@@ -0,0 +1,81 @@
+/* ========================================================================= *
+ *
+ * This file is part of Alarmd
+ *
+ * Copyright (C) 2008-2009 Nokia Corporation and/or its subsidiary(-ies).
+ *
+ * Contact: Simo Piiroinen <simo.piiroinen@nokia.com>
+ *
+ * Alarmd is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * version 2.1 as published by the Free Software Foundation.
+ *
+ * Alarmd is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with Alarmd; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA
+ * 02110-1301 USA
+ *
+ * ========================================================================= */
+
+#ifndef TZFILE_H_
+#define TZFILE_H_
+
+#include <time.h>
+
+#ifdef __cplusplus
+extern "C" {
+#elif 0
+} /* fool JED indentation ... */
+#endif
+
+/* ------------------------------------------------------------------------- *
+ * In-process time zone conversions
+ *
+ * Zone data is parsed from TZif files (or POSIX TZ strings) once
+ * and cached by zone name. Conversions do not touch the TZ
+ * environment variable or other process global libc state.
+ *
+ * Both functions return -1 if the zone can not be handled
+ * (missing zone file, leap second zone, ...), in which case
+ * the caller should fall back to libc conversions.
+ * ------------------------------------------------------------------------- */
+
+int tzfile_break_tm(time_t t, struct tm *tm, const char *tz);
+int tzfile_build_tm(struct tm *tm, const char *tz, time_t *pt);
+
+/* ------------------------------------------------------------------------- *
+ * Local wall clock times that do not exist in the zone
+ *
+ * Local times are expressed as seconds since epoch as if the zone
+ * was UTC. Returns 1 and the first skipped range [beg, end) that
+ * ends after loc, 0 if there are no such ranges, or -1 if the zone
+ * can not be handled.
+ * ------------------------------------------------------------------------- */
+
+int tzfile_next_gap(const char *tz, time_t loc, time_t *pbeg, time_t *pend);
+
+/* ------------------------------------------------------------------------- *
+ * Returns 1 and the first utc time after t where the utc offset of
+ * the zone changes, 0 if there are no more changes, or -1 if the
+ * zone can not be handled.
+ * ------------------------------------------------------------------------- */
+
+int tzfile_next_change(const char *tz, time_t t, time_t *pnext);
+
+/* ------------------------------------------------------------------------- *
+ * Drops all cached zone data, e.g. after a timezone change. Changes
+ * to /etc/localtime are otherwise noticed within a second.
+ * ------------------------------------------------------------------------- */
+
+void tzfile_flush(void);
+
+#ifdef __cplusplus
+};
+#endif
+
+#endif /* TZFILE_H_ */
@@ -28,6 +28,8 @@
 
 #include <string.h>
 #include <stdlib.h>
+#include <stdint.h>
+#include <stddef.h>
 
 /* ========================================================================= *
  * unique_t  --  methods
@@ -189,3 +191,218 @@ unique_add(unique_t *self, const char *str)
   self->un_string[self->un_count] = 0;
   self->un_dirty = 1;
 }
+
+/* ========================================================================= *
+ * interned strings  --  refcounted pool of shared string copies
+ * ========================================================================= */
+
+typedef struct unique_str_t unique_str_t;
+
+struct unique_str_t
+{
+  unique_str_t *us_next;
+  uint32_t      us_hash;
+  size_t        us_refs;
+  char          us_text[];
+};
+
+static int            unique_pool_on    = 0;
+static size_t         unique_pool_count = 0;
+static size_t         unique_pool_size  = 0;
+static unique_str_t **unique_pool_slot  = 0;
+
+/* ------------------------------------------------------------------------- *
+ * unique_pool_hash  --  FNV-1a
+ * ------------------------------------------------------------------------- */
+
+static uint32_t
+unique_pool_hash(const char *str)
+{
+  uint32_t h = 2166136261u;
+  for( ; *str; ++str )
+  {
+    h ^= (unsigned char)*str;
+    h *= 16777619u;
+  }
+  return h;
+}
+
+/* ------------------------------------------------------------------------- *
+ * unique_pool_find  --  locate pool entry with same content
+ * ------------------------------------------------------------------------- */
+
+static unique_str_t **
+unique_pool_find(const char *str, uint32_t hash)
+{
+  unique_str_t **pos = &unique_pool_slot[hash & (unique_pool_size - 1)];
+
+  for( ; *pos; pos = &(*pos)->us_next )
+  {
+    if( (*pos)->us_hash == hash && !strcmp((*pos)->us_text, str) )
+    {
+      break;
+    }
+  }
+  return pos;
+}
+
+/* ------------------------------------------------------------------------- *
+ * unique_pool_grow  --  double the slot table and rehash
+ * ------------------------------------------------------------------------- */
+
+static void
+unique_pool_grow(void)
+{
+  size_t         size = unique_pool_size ? unique_pool_size * 2 : 256;
+  unique_str_t **slot = calloc(size, sizeof *slot);
+
+  for( size_t i = 0; i < unique_pool_size; ++i )
+  {
+    unique_str_t *cur;
+    while( (cur = unique_pool_slot[i]) != 0 )
+    {
+      unique_pool_slot[i] = cur->us_next;
+      cur->us_next = slot[cur->us_hash & (size - 1)];
+      slot[cur->us_hash & (size - 1)] = cur;
+    }
+  }
+
+  free(unique_pool_slot);
+  unique_pool_slot = slot;
+  unique_pool_size = size;
+}
+
+/* ------------------------------------------------------------------------- *
+ * unique_pool_enable  --  start/stop interning new strings
+ *
+ * Libalarm clients keep plain strdup()ed strings in their events,
+ * only the server side enables the pool.
+ * ------------------------------------------------------------------------- */
+
+void
+unique_pool_enable(int enable)
+{
+  unique_pool_on = (enable != 0);
+}
+
+/* ------------------------------------------------------------------------- *
+ * unique_pool_enabled
+ * ------------------------------------------------------------------------- */
+
+int
+unique_pool_enabled(void)
+{
+  return unique_pool_on;
+}
+
+/* ------------------------------------------------------------------------- *
+ * unique_pool_stats  --  number of pooled strings and bytes they use
+ * ------------------------------------------------------------------------- */
+
+size_t
+unique_pool_stats(size_t *pbytes)
+{
+  if( pbytes != 0 )
+  {
+    size_t bytes = unique_pool_size * sizeof *unique_pool_slot;
+
+    for( size_t i = 0; i < unique_pool_size; ++i )
+    {
+      for( unique_str_t *cur = unique_pool_slot[i]; cur; cur = cur->us_next )
+      {
+        bytes += sizeof *cur + strlen(cur->us_text) + 1;
+      }
+    }
+    *pbytes = bytes;
+  }
+  return unique_pool_count;
+}
+
+/* ------------------------------------------------------------------------- *
+ * unique_intern  --  get a reference to pooled copy of string
+ *
+ * Returns strdup()ed copy if the pool is not enabled. In both
+ * cases the result must be released with unique_release().
+ * ------------------------------------------------------------------------- */
+
+char *
+unique_intern(const char *str)
+{
+  if( str == 0 )
+  {
+    return 0;
+  }
+
+  if( !unique_pool_on )
+  {
+    return strdup(str);
+  }
+
+  if( unique_pool_count >= unique_pool_size )
+  {
+    unique_pool_grow();
+  }
+
+  uint32_t       hash = unique_pool_hash(str);
+  unique_str_t **pos  = unique_pool_find(str, hash);
+
+  if( *pos == 0 )
+  {
+    size_t len = strlen(str) + 1;
+
+    *pos = malloc(offsetof(unique_str_t, us_text) + len);
+    (*pos)->us_next = 0;
+    (*pos)->us_hash = hash;
+    (*pos)->us_refs = 0;
+    memcpy((*pos)->us_text, str, len);
+    unique_pool_count += 1;
+  }
+
+  (*pos)->us_refs += 1;
+  return (*pos)->us_text;
+}
+
+/* ------------------------------------------------------------------------- *
+ * unique_release  --  drop reference to pooled string, or free() plain one
+ * ------------------------------------------------------------------------- */
+
+void
+unique_release(char *str)
+{
+  if( str == 0 )
+  {
+    return;
+  }
+
+  if( unique_pool_count != 0 )
+  {
+    unique_str_t **pos = unique_pool_find(str, unique_pool_hash(str));
+
+    if( *pos != 0 && (*pos)->us_text == str )
+    {
+      unique_str_t *cur = *pos;
+
+      if( --cur->us_refs == 0 )
+      {
+        *pos = cur->us_next;
+        free(cur);
+        unique_pool_count -= 1;
+      }
+      return;
+    }
+  }
+
+  free(str);
+}
+
+/* ------------------------------------------------------------------------- *
+ * unique_strset  --  replace string at given address with interned copy
+ * ------------------------------------------------------------------------- */
+
+void
+unique_strset(char **pdst, const char *src)
+{
+  char *curr = unique_intern(src);
+  unique_release(*pdst);
+  *pdst = curr;
+}
@@ -56,6 +56,17 @@ char     **unique_final    (unique_t *self, size_t *pcount);
 char     **unique_steal    (unique_t *self, size_t *pcount);
 void       unique_add      (unique_t *self, const char *str);
 
+/* ------------------------------------------------------------------------- *
+ * interned strings
+ * ------------------------------------------------------------------------- */
+
+void        unique_pool_enable (int enable);
+int         unique_pool_enabled(void);
+size_t      unique_pool_stats  (size_t *pbytes);
+char       *unique_intern      (const char *str);
+void        unique_release     (char *str);
+void        unique_strset      (char **pdst, const char *src);
+
 #ifdef __cplusplus
 };
 #endif
@@ -149,6 +149,54 @@ xsavefile(const char *path, int mode, const void *data, size_t size)
   return err;
 }
 
+/* ------------------------------------------------------------------------- *
+ * xappendfile  --  append buffer to file
+ * ------------------------------------------------------------------------- */
+
+int
+xappendfile(const char *path, int mode, const void *data, size_t size)
+{
+  int     err  = -1;
+  int     file = -1;
+  ssize_t done = 0;
+
+  if( (file = open(path, O_WRONLY|O_CREAT|O_APPEND, mode)) == -1 )
+  {
+    log_error_F("%s: open: %s\n", path, strerror(errno));
+    goto cleanup;
+  }
+
+  if( (done = write(file, data, size)) < 0 )
+  {
+    log_error_F("%s: write: %s\n", path, strerror(errno));
+    goto cleanup;
+  }
+
+  if( (size_t)done != size )
+  {
+    log_error_F("%s: write: %zd/%zu bytes written\n", path, done, size);
+    goto cleanup;
+  }
+
+  if( fsync(file) == -1 )
+  {
+    log_error_F("%s: sync: %s\n", path, strerror(errno));
+    goto cleanup;
+  }
+
+  err = 0;
+
+  cleanup:
+
+  if( file != -1 && close(file) == -1 )
+  {
+    log_error_F("%s: close: %s\n", path, strerror(errno));
+    err = -1;
+  }
+
+  return err;
+}
+
 /* ------------------------------------------------------------------------- *
  * xcyclefiles  --  rename: temp -> current -> backup
  * ------------------------------------------------------------------------- */
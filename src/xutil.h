@@ -45,6 +45,7 @@ int  xscratchbox(void);
 int  xexists(const char *path);
 int  xloadfile(const char *path, char **pdata, size_t *psize);
 int  xsavefile(const char *path, int mode, const void *data, size_t size);
+int  xappendfile(const char *path, int mode, const void *data, size_t size);
 int  xcyclefiles(const char *temp, const char *path, const char *back);
 void xfetchstats(const char *path, struct stat *cur);
 int  xcheckstats(const char *path, const struct stat *old);
@@ -0,0 +1,139 @@
+/* ========================================================================= *
+ *
+ * This file is part of Alarmd
+ *
+ * Copyright (C) 2008-2009 Nokia Corporation and/or its subsidiary(-ies).
+ *
+ * Contact: Simo Piiroinen <simo.piiroinen@nokia.com>
+ *
+ * Alarmd is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * version 2.1 as published by the Free Software Foundation.
+ *
+ * Alarmd is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with Alarmd; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA
+ * 02110-1301 USA
+ *
+ * ========================================================================= */
+
+/* Microbenchmark: cost of alarm_event_t attribute lookups.
+ *
+ * Events are populated with N attributes and every attribute is
+ * looked up and updated by name. The "linear" run is a reference
+ * strcmp scan over attr_tab, as alarm_event_get_attr() used to do;
+ * the "get" and "set" runs use the binary search over the name
+ * sorted table via the public api.
+ *
+ * Usage: bench_attr [count ...]   (default: 4 32 256)
+ */
+
+#include "../src/libalarm.h"
+
+#include "bench_util.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define ROUNDS 1000
+
+/* ------------------------------------------------------------------------- *
+ * bench_linear_get  --  reference: linear scan over attr_tab
+ * ------------------------------------------------------------------------- */
+
+static alarm_attr_t *
+bench_linear_get(alarm_event_t *eve, const char *name)
+{
+  for( size_t i = 0; i < eve->attr_cnt; ++i )
+  {
+    if( !strcmp(eve->attr_tab[i]->attr_name, name) )
+    {
+      return eve->attr_tab[i];
+    }
+  }
+  return 0;
+}
+
+int
+main(int ac, char **av)
+{
+  static const size_t counts[] = { 4, 32, 256 };
+
+  size_t cnt = (ac > 1) ? (size_t)(ac - 1) : sizeof counts / sizeof *counts;
+
+  printf("%8s %12s %12s %12s   (ns per lookup)\n",
+         "attrs", "linear", "get", "set");
+
+  for( size_t i = 0; i < cnt; ++i )
+  {
+    size_t          count = (ac > 1) ? strtoul(av[i+1], 0, 0) : counts[i];
+    alarm_event_t  *eve   = alarm_event_create();
+    char          **names = calloc(count, sizeof *names);
+    size_t          hits  = 0;
+    double          t;
+
+    /* - - - - - - - - - - - - - - - - - - - *
+     * attribute names as apps use them
+     * - - - - - - - - - - - - - - - - - - - */
+
+    for( size_t k = 0; k < count; ++k )
+    {
+      asprintf(&names[k], "com.example.app.attr%zu", (k * 7919) % count);
+      alarm_event_set_attr_string(eve, names[k], "value");
+    }
+
+    t = bench_now();
+    for( int r = 0; r < ROUNDS; ++r )
+    {
+      for( size_t k = 0; k < count; ++k )
+      {
+        hits += (bench_linear_get(eve, names[k]) != 0);
+      }
+    }
+    double linear = bench_now() - t;
+
+    t = bench_now();
+    for( int r = 0; r < ROUNDS; ++r )
+    {
+      for( size_t k = 0; k < count; ++k )
+      {
+        hits += (alarm_event_get_attr(eve, names[k]) != 0);
+      }
+    }
+    double get = bench_now() - t;
+
+    t = bench_now();
+    for( int r = 0; r < ROUNDS; ++r )
+    {
+      for( size_t k = 0; k < count; ++k )
+      {
+        alarm_event_set_attr_int(eve, names[k], r);
+      }
+    }
+    double set = bench_now() - t;
+
+    if( hits != 2 * ROUNDS * count || eve->attr_cnt != count )
+    {
+      fprintf(stderr, "attribute lookup failed\n");
+      return EXIT_FAILURE;
+    }
+
+    double scale = 1e9 / (ROUNDS * count);
+    printf("%8zu %12.1f %12.1f %12.1f\n",
+           count, linear * scale, get * scale, set * scale);
+
+    for( size_t k = 0; k < count; ++k )
+    {
+      free(names[k]);
+    }
+    free(names);
+    alarm_event_delete(eve);
+  }
+  return 0;
+}
@@ -0,0 +1,144 @@
+/* ========================================================================= *
+ *
+ * This file is part of Alarmd
+ *
+ * Copyright (C) 2008-2009 Nokia Corporation and/or its subsidiary(-ies).
+ *
+ * Contact: Simo Piiroinen <simo.piiroinen@nokia.com>
+ *
+ * Alarmd is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * version 2.1 as published by the Free Software Foundation.
+ *
+ * Alarmd is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with Alarmd; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA
+ * 02110-1301 USA
+ *
+ * ========================================================================= */
+
+/* Microbenchmark: inifile access pattern used by queue save / load.
+ *
+ * Each alarm is a "#cookie" section with BENCH_KEYS values. Saving
+ * sets all values via inifile_setfmt() and serializes to memory,
+ * loading parses a file and reads every value via inifile_get().
+ *
+ * Usage: bench_inifile [count ...]   (default: 1000 10000)
+ */
+
+#include "../src/inifile.h"
+#include "../src/logging.h"
+
+#include "bench_util.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+/* roughly the number of values saved per alarm event */
+#define BENCH_KEYS 30
+
+/* ------------------------------------------------------------------------- *
+ * bench_key  --  value names resembling queue save file keys
+ * ------------------------------------------------------------------------- */
+
+static const char *
+bench_key(int k)
+{
+  static char buf[BENCH_KEYS][32];
+
+  if( *buf[k] == 0 )
+  {
+    if( k < 10 ) snprintf(buf[k], sizeof *buf, "event_field%d", k);
+    else         snprintf(buf[k], sizeof *buf, "action%d.field%d", k / 10, k % 10);
+  }
+  return buf[k];
+}
+
+/* ------------------------------------------------------------------------- *
+ * bench_inifile
+ * ------------------------------------------------------------------------- */
+
+static void
+bench_inifile(size_t count)
+{
+  char       path[] = "/tmp/bench_inifile.XXXXXX";
+  char       sec[32];
+  char      *data = 0;
+  size_t     size = 0;
+  inifile_t *ini  = 0;
+  double     t0, t1, t2, t3;
+  FILE      *file;
+  int        fd;
+
+  // save
+  t0  = bench_now();
+  ini = inifile_create();
+  for( size_t i = 1; i <= count; ++i )
+  {
+    snprintf(sec, sizeof sec, "#%08zx", i);
+    for( int k = 0; k < BENCH_KEYS; ++k )
+    {
+      inifile_setfmt(ini, sec, bench_key(k), "%zu", i * k);
+    }
+  }
+  inifile_save_to_memory(ini, &data, &size);
+  inifile_delete(ini);
+  t1 = bench_now();
+
+  if( (fd = mkstemp(path)) == -1 || (file = fdopen(fd, "w")) == 0 )
+  {
+    perror(path);
+    exit(EXIT_FAILURE);
+  }
+  fwrite(data, 1, size, file);
+  fclose(file);
+
+  // load
+  t2  = bench_now();
+  ini = inifile_create();
+  inifile_load(ini, path);
+  for( size_t i = 1; i <= count; ++i )
+  {
+    snprintf(sec, sizeof sec, "#%08zx", i);
+    for( int k = 0; k < BENCH_KEYS; ++k )
+    {
+      if( strtoul(inifile_get(ini, sec, bench_key(k), ""), 0, 0) != i * k )
+      {
+        fprintf(stderr, "%s:%s: value mismatch\n", sec, bench_key(k));
+        exit(EXIT_FAILURE);
+      }
+    }
+  }
+  inifile_delete(ini);
+  t3 = bench_now();
+
+  printf("%8zu %12.6f %12.6f %12zu\n", count, t1 - t0, t3 - t2, size);
+
+  unlink(path);
+  free(data);
+}
+
+int
+main(int ac, char **av)
+{
+  static const size_t counts[] = { 1000, 10000 };
+
+  size_t cnt = (ac > 1) ? (size_t)(ac - 1) : sizeof counts / sizeof *counts;
+
+  log_set_level(LOG_WARNING);
+
+  printf("%8s %12s %12s %12s\n", "alarms", "save", "load", "bytes");
+
+  for( size_t i = 0; i < cnt; ++i )
+  {
+    bench_inifile((ac > 1) ? strtoul(av[i+1], 0, 0) : counts[i]);
+  }
+  return 0;
+}
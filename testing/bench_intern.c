@@ -0,0 +1,149 @@
+/* ========================================================================= *
+ *
+ * This file is part of Alarmd
+ *
+ * Copyright (C) 2008-2009 Nokia Corporation and/or its subsidiary(-ies).
+ *
+ * Contact: Simo Piiroinen <simo.piiroinen@nokia.com>
+ *
+ * Alarmd is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * version 2.1 as published by the Free Software Foundation.
+ *
+ * Alarmd is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with Alarmd; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA
+ * 02110-1301 USA
+ *
+ * ========================================================================= */
+
+/* Microbenchmark: heap used by repeated event strings with and
+ * without the string intern pool.
+ *
+ * Events from a handful of applications are added to the queue,
+ * each with a dbus action. The "plain" run keeps strdup()ed copies
+ * as libalarm clients do; the "interned" run enables the pool like
+ * alarmd does on startup.
+ *
+ * Usage: bench_intern [count ...]   (default: 1000 10000)
+ */
+
+#include "../src/queue.h"
+#include "../src/unique.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <malloc.h>
+
+#define APPS 5
+
+/* ------------------------------------------------------------------------- *
+ * bench_heap  --  bytes of heap in use
+ * ------------------------------------------------------------------------- */
+
+static size_t
+bench_heap(void)
+{
+#if __GLIBC_PREREQ(2,33)
+  return mallinfo2().uordblks;
+#else
+  return mallinfo().uordblks;
+#endif
+}
+
+/* ------------------------------------------------------------------------- *
+ * bench_fill  --  add events to queue, return heap bytes used
+ * ------------------------------------------------------------------------- */
+
+static size_t
+bench_fill(size_t count)
+{
+  static const char * const zones[APPS] =
+  {
+    "Europe/Helsinki", "America/New_York", "Asia/Tokyo", "UTC", "",
+  };
+
+  size_t heap = bench_heap();
+  char   tmp[128];
+
+  for( size_t k = 1; k <= count; ++k )
+  {
+    alarm_event_t  *eve = alarm_event_create();
+    alarm_action_t *act = alarm_event_add_actions(eve, 1);
+    int             app = k % APPS;
+
+    alarm_event_set_cookie(eve, k);
+    alarm_event_set_trigger(eve, 1000000000 + k * 60);
+
+    snprintf(tmp, sizeof tmp, "Reminder %zu", k);
+    alarm_event_set_title(eve, tmp);
+
+    snprintf(tmp, sizeof tmp, "com.example.app%d", app);
+    alarm_event_set_alarm_appid(eve, tmp);
+    alarm_action_set_dbus_service(act, tmp);
+    alarm_action_set_dbus_interface(act, tmp);
+
+    snprintf(tmp, sizeof tmp, "/usr/share/sounds/app%d-alarm.wav", app);
+    alarm_event_set_sound(eve, tmp);
+
+    snprintf(tmp, sizeof tmp, "/usr/share/icons/app%d-alarm.png", app);
+    alarm_event_set_icon(eve, tmp);
+
+    snprintf(tmp, sizeof tmp, "/com/example/app%d", app);
+    alarm_action_set_dbus_path(act, tmp);
+    alarm_action_set_dbus_name(act, "alarm_triggered");
+
+    alarm_event_set_alarm_tz(eve, zones[app]);
+
+    queue_event_set_state(eve, ALARM_STATE_QUEUED);
+    queue_add_event(eve);
+  }
+
+  return bench_heap() - heap;
+}
+
+/* ------------------------------------------------------------------------- *
+ * bench_clear
+ * ------------------------------------------------------------------------- */
+
+static void
+bench_clear(size_t count)
+{
+  for( size_t k = 1; k <= count; ++k )
+  {
+    queue_del_event(k);
+  }
+  queue_cleanup_deleted();
+}
+
+int
+main(int ac, char **av)
+{
+  static const size_t counts[] = { 1000, 10000 };
+
+  size_t cnt = (ac > 1) ? (size_t)(ac - 1) : sizeof counts / sizeof *counts;
+
+  printf("%8s %12s %12s %12s\n", "events", "plain", "interned", "saved");
+
+  for( size_t i = 0; i < cnt; ++i )
+  {
+    size_t count = (ac > 1) ? strtoul(av[i+1], 0, 0) : counts[i];
+
+    unique_pool_enable(0);
+    size_t plain = bench_fill(count);
+    bench_clear(count);
+
+    unique_pool_enable(1);
+    size_t pooled = bench_fill(count);
+    bench_clear(count);
+
+    printf("%8zu %12zu %12zu %12lld\n", count, plain, pooled,
+           (long long)plain - (long long)pooled);
+  }
+  return 0;
+}
@@ -0,0 +1,155 @@
+/* ========================================================================= *
+ *
+ * This file is part of Alarmd
+ *
+ * Copyright (C) 2008-2009 Nokia Corporation and/or its subsidiary(-ies).
+ *
+ * Contact: Simo Piiroinen <simo.piiroinen@nokia.com>
+ *
+ * Alarmd is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * version 2.1 as published by the Free Software Foundation.
+ *
+ * Alarmd is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with Alarmd; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA
+ * 02110-1301 USA
+ *
+ * ========================================================================= */
+
+/* Microbenchmark: cost of debug logging on the rethink path when
+ * debug output is filtered out by the runtime log level.
+ *
+ * Every event in the queue is rescheduled the way the rethink does
+ * after a timezone change, with the same kind of debug output:
+ * trigger times broken down in the event timezone and formatted.
+ * The "eager" run formats the strings unconditionally, like alarmd
+ * used to; the "gated" run skips formatting via log_enabled().
+ *
+ * With debug output enabled, the "tmpfile" run writes formatted
+ * messages to /tmp/bench_logging.log and the "ring" run stores them
+ * to the in-memory ring buffer, formatting them only on flush.
+ * The flush writes to the alarmd cache directory, so the
+ * "ring+flush" figure is meaningful only when that is writable.
+ *
+ * Usage: bench_logging [count ...]   (default: 1000 10000)
+ */
+
+#include "../src/queue.h"
+#include "../src/ticker.h"
+#include "../src/logging.h"
+
+#include "bench_util.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+/* ------------------------------------------------------------------------- *
+ * bench_log_trigger  --  debug output as in server_rethink_timechange()
+ * ------------------------------------------------------------------------- */
+
+static void
+bench_log_trigger(cookie_t cookie, time_t old, time_t use, const char *tz)
+{
+  struct tm tm;
+  char      trg[128];
+
+  ticker_break_tm(old, &tm, tz);
+  strftime(trg, sizeof trg, "%a %Y-%m-%d %H:%M:%S", &tm);
+  log_debug("[%ld] OLD: %s (%s)\n", (long)cookie, trg,
+            ticker_date_format_long(0,0,old));
+
+  ticker_break_tm(use, &tm, tz);
+  strftime(trg, sizeof trg, "%a %Y-%m-%d %H:%M:%S", &tm);
+  log_debug("[%ld] NEW: %s (%s)\n", (long)cookie, trg,
+            ticker_date_format_long(0,0,use));
+}
+
+/* ------------------------------------------------------------------------- *
+ * bench_rethink  --  reschedule all events, return elapsed seconds
+ * ------------------------------------------------------------------------- */
+
+static double
+bench_rethink(size_t count, int gated)
+{
+  static const char * const zones[] =
+  {
+    "Europe/Helsinki", "America/New_York", "Asia/Tokyo", "UTC",
+  };
+
+  double t = bench_now();
+
+  for( size_t i = 1; i <= count; ++i )
+  {
+    alarm_event_t *eve = queue_get_event(i);
+    time_t         old = alarm_event_get_trigger(eve);
+    time_t         use = old + 60 * 60;
+
+    if( !gated || log_enabled(LOG_DEBUG) )
+    {
+      bench_log_trigger(i, old, use, zones[i % 4]);
+    }
+
+    queue_event_set_trigger(eve, use);
+  }
+
+  return bench_now() - t;
+}
+
+int
+main(int ac, char **av)
+{
+  static const size_t counts[] = { 1000, 10000 };
+
+  size_t cnt = (ac > 1) ? (size_t)(ac - 1) : sizeof counts / sizeof *counts;
+
+  printf("%8s %12s %12s %12s %12s %12s\n", "events", "eager", "gated",
+         "tmpfile", "ring", "ring+flush");
+
+  for( size_t i = 0; i < cnt; ++i )
+  {
+    size_t count = (ac > 1) ? strtoul(av[i+1], 0, 0) : counts[i];
+
+    for( size_t k = 1; k <= count; ++k )
+    {
+      alarm_event_t *eve = alarm_event_create();
+      alarm_event_set_cookie(eve, k);
+      alarm_event_set_trigger(eve, 1000000000 + k * 60);
+      queue_event_set_state(eve, ALARM_STATE_QUEUED);
+      queue_add_event(eve);
+    }
+
+    log_open("bench_logging", LOG_TO_TMP, 0);
+    log_set_level(LOG_WARNING);
+
+    double eager = bench_rethink(count, 0);
+    double gated = bench_rethink(count, 1);
+
+    log_set_level(LOG_DEBUG);
+    double tmpfile = bench_rethink(count, 1);
+
+    log_reopen(LOG_TO_RING);
+    double ring = bench_rethink(count, 1);
+    double flush = bench_now();
+    log_flush();
+    flush = bench_now() - flush + ring;
+
+    log_close();
+
+    printf("%8zu %12.6f %12.6f %12.6f %12.6f %12.6f\n",
+           count, eager, gated, tmpfile, ring, flush);
+
+    for( size_t k = 1; k <= count; ++k )
+    {
+      queue_del_event(k);
+    }
+    queue_cleanup_deleted();
+  }
+  return 0;
+}
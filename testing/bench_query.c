@@ -0,0 +1,264 @@
+/* ========================================================================= *
+ *
+ * This file is part of Alarmd
+ *
+ * Copyright (C) 2008-2009 Nokia Corporation and/or its subsidiary(-ies).
+ *
+ * Contact: Simo Piiroinen <simo.piiroinen@nokia.com>
+ *
+ * Alarmd is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * version 2.1 as published by the Free Software Foundation.
+ *
+ * Alarmd is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with Alarmd; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA
+ * 02110-1301 USA
+ *
+ * ========================================================================= */
+
+/* Microbenchmark: application filtered and time window queue queries.
+ *
+ * One application owns 90% of the queue, the rest is split between
+ * a few others. The "scan" run is a reference that walks the whole
+ * queue in trigger order and compares appids, as queue_query_events()
+ * used to do; the "index" run uses the per-appid index.
+ *
+ * Time windows are queried with the lower bound seek ("seek") and,
+ * as a reference, by walking from the first event up to the end of
+ * the window ("walk") like queue_query_events() used to do. The
+ * windows are one day and half a year in the middle of the queue,
+ * and an empty one after the last event.
+ *
+ * Usage: bench_query [count ...]   (default: 1000 10000 50000)
+ */
+
+#include "../src/queue.h"
+
+#include "bench_util.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define APPS   10
+#define ROUNDS 10
+
+/* ------------------------------------------------------------------------- *
+ * bench_appid  --  app0 owns 90% of events
+ * ------------------------------------------------------------------------- */
+
+static const char *
+bench_appid(int app)
+{
+  static char tmp[APPS][32];
+
+  if( !*tmp[app] )
+  {
+    snprintf(tmp[app], sizeof tmp[app], "com.example.app%d", app);
+  }
+  return tmp[app];
+}
+
+/* ------------------------------------------------------------------------- *
+ * bench_scan  --  reference: filter all events by appid
+ * ------------------------------------------------------------------------- */
+
+static cookie_t *
+bench_scan(int *pcnt, const char *app)
+{
+  int       all = 0;
+  cookie_t *vec = queue_query_events(&all, 0, 0, 0, 0, 0);
+  int       cnt = 0;
+
+  for( int i = 0; i < all; ++i )
+  {
+    const alarm_event_t *eve = queue_get_event(vec[i]);
+
+    if( eve->alarm_appid && !strcmp(eve->alarm_appid, app) )
+    {
+      vec[cnt++] = vec[i];
+    }
+  }
+  vec[cnt] = 0;
+
+  *pcnt = cnt;
+  return vec;
+}
+
+/* ------------------------------------------------------------------------- *
+ * bench_run  --  query every app ROUNDS times, return elapsed seconds
+ * ------------------------------------------------------------------------- */
+
+static double
+bench_run(int app, int indexed)
+{
+  double t = bench_now();
+
+  for( int r = 0; r < ROUNDS; ++r )
+  {
+    int       cnt = 0;
+    cookie_t *vec = (indexed ?
+                     queue_query_events(&cnt, 0, 0, 0, 0, bench_appid(app)) :
+                     bench_scan(&cnt, bench_appid(app)));
+    free(vec);
+  }
+
+  return bench_now() - t;
+}
+
+/* ------------------------------------------------------------------------- *
+ * bench_verify  --  indexed query gives same results as full scan
+ * ------------------------------------------------------------------------- */
+
+static int
+bench_verify(void)
+{
+  for( int app = 0; app < APPS; ++app )
+  {
+    int       n1  = 0, n2 = 0;
+    cookie_t *v1  = queue_query_events(&n1, 0, 0, 0, 0, bench_appid(app));
+    cookie_t *v2  = bench_scan(&n2, bench_appid(app));
+    int       bad = (n1 != n2 || memcmp(v1, v2, n1 * sizeof *v1));
+
+    free(v1);
+    free(v2);
+
+    if( bad )
+    {
+      fprintf(stderr, "%s: query mismatch\n", bench_appid(app));
+      return 0;
+    }
+  }
+  return 1;
+}
+
+/* ------------------------------------------------------------------------- *
+ * bench_window  --  query time window ROUNDS times, return elapsed seconds
+ * ------------------------------------------------------------------------- */
+
+static double
+bench_window(time_t lo, time_t hi, int seek)
+{
+  double t = bench_now();
+
+  for( int r = 0; r < ROUNDS; ++r )
+  {
+    int cnt = 0;
+    free(queue_query_events(&cnt, seek ? lo : 0, hi, 0, 0, 0));
+  }
+
+  return bench_now() - t;
+}
+
+/* ------------------------------------------------------------------------- *
+ * bench_window_verify  --  window query gives events in [lo, hi] in order
+ * ------------------------------------------------------------------------- */
+
+static int
+bench_window_verify(time_t lo, time_t hi)
+{
+  int       n1 = 0, n2 = 0, k = 0;
+  cookie_t *v1 = queue_query_events(&n1, lo, hi, 0, 0, 0);
+  cookie_t *v2 = queue_query_events(&n2, 0, hi, 0, 0, 0);
+
+  for( int i = 0; i < n2; ++i )
+  {
+    if( queue_get_event(v2[i])->ALARMD_PRIVATE(trigger) >= lo )
+    {
+      if( k >= n1 || v1[k++] != v2[i] ) break;
+    }
+  }
+
+  int ok = (k == n1);
+
+  free(v1);
+  free(v2);
+
+  if( !ok )
+  {
+    fprintf(stderr, "%ld .. %ld: window query mismatch\n", (long)lo, (long)hi);
+  }
+  return ok;
+}
+
+int
+main(int ac, char **av)
+{
+  static const size_t counts[] = { 1000, 10000, 50000 };
+
+  size_t cnt = (ac > 1) ? (size_t)(ac - 1) : sizeof counts / sizeof *counts;
+
+  static const time_t base = 1000000000;
+  static const time_t day  = 24 * 60 * 60;
+
+  const struct
+  {
+    const char *name;
+    time_t      lo, hi;
+  } windows[] =
+  {
+    { "narrow", base + 180 * day, base + 181 * day },
+    { "wide",   base + 180 * day, base + 360 * day },
+    { "empty",  base + 400 * day, base + 401 * day },
+  };
+
+  printf("%8s %12s %12s %12s %12s", "events",
+         "scan-90%", "index-90%", "scan-1%", "index-1%");
+  for( size_t w = 0; w < sizeof windows / sizeof *windows; ++w )
+  {
+    printf(" %8s-walk %8s-seek", windows[w].name, windows[w].name);
+  }
+  printf("\n");
+
+  for( size_t i = 0; i < cnt; ++i )
+  {
+    size_t count = (ac > 1) ? strtoul(av[i+1], 0, 0) : counts[i];
+
+    for( size_t k = 1; k <= count; ++k )
+    {
+      alarm_event_t *eve = alarm_event_create();
+      int            app = (random() % 10) ? 0 : 1 + random() % (APPS - 1);
+
+      alarm_event_set_cookie(eve, k);
+      alarm_event_set_trigger(eve, base + random() % (365 * day));
+      alarm_event_set_alarm_appid(eve, bench_appid(app));
+      queue_event_set_state(eve, ALARM_STATE_QUEUED);
+      queue_add_event(eve);
+    }
+
+    if( !bench_verify() )
+    {
+      return EXIT_FAILURE;
+    }
+
+    printf("%8zu %12.6f %12.6f %12.6f %12.6f", count,
+           bench_run(0, 0), bench_run(0, 1),
+           bench_run(1, 0), bench_run(1, 1));
+
+    for( size_t w = 0; w < sizeof windows / sizeof *windows; ++w )
+    {
+      if( !bench_window_verify(windows[w].lo, windows[w].hi) )
+      {
+        return EXIT_FAILURE;
+      }
+      printf(" %13.6f %13.6f",
+             bench_window(windows[w].lo, windows[w].hi, 0),
+             bench_window(windows[w].lo, windows[w].hi, 1));
+    }
+    printf("\n");
+
+    for( size_t k = 1; k <= count; ++k )
+    {
+      queue_del_event(k);
+    }
+    queue_cleanup_deleted();
+  }
+  return 0;
+}
@@ -0,0 +1,277 @@
+/* ========================================================================= *
+ *
+ * This file is part of Alarmd
+ *
+ * Copyright (C) 2008-2009 Nokia Corporation and/or its subsidiary(-ies).
+ *
+ * Contact: Simo Piiroinen <simo.piiroinen@nokia.com>
+ *
+ * Alarmd is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * version 2.1 as published by the Free Software Foundation.
+ *
+ * Alarmd is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with Alarmd; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA
+ * 02110-1301 USA
+ *
+ * ========================================================================= */
+
+/* Microbenchmark: queue.c event bookkeeping vs. the sorted
+ * pointer arrays that were used before the trigger tree and
+ * the cookie hash were introduced.
+ *
+ * Usage: bench_queue [count ...]   (default: 1000 10000 100000)
+ */
+
+#include "../src/queue.h"
+#include "../src/logging.h"
+
+#include "bench_util.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+/* ========================================================================= *
+ * UTILITIES
+ * ========================================================================= */
+
+static time_t
+bench_random_trigger(void)
+{
+  return 1000000000 + random() % (365 * 24 * 60 * 60);
+}
+
+/* ========================================================================= *
+ * REFERENCE: sorted pointer arrays
+ * ========================================================================= */
+
+typedef struct
+{
+  cookie_t cookie;
+  time_t   trigger;
+} ref_event_t;
+
+static ref_event_t **ref_by_cookie  = 0;
+static ref_event_t **ref_by_trigger = 0;
+static size_t        ref_count      = 0;
+static size_t        ref_alloc      = 0;
+
+static int
+ref_cmp_trigger(const ref_event_t *a, const ref_event_t *b)
+{
+  // descending trigger, descending cookie
+  if( a->trigger != b->trigger ) return (a->trigger < b->trigger) ? 1 : -1;
+  if( a->cookie  != b->cookie  ) return (a->cookie  < b->cookie)  ? 1 : -1;
+  return 0;
+}
+
+static size_t
+ref_trigger_slot(const ref_event_t *eve)
+{
+  size_t l = 0, h = ref_count, i;
+  while( l < h )
+  {
+    if( ref_cmp_trigger(ref_by_trigger[(i = (l+h)/2)], eve) < 0 ) l = i + 1;
+    else h = i;
+  }
+  return l;
+}
+
+static size_t
+ref_cookie_slot(cookie_t cookie)
+{
+  size_t l = 0, h = ref_count, i;
+  while( l < h )
+  {
+    if( ref_by_cookie[(i = (l+h)/2)]->cookie < cookie ) l = i + 1;
+    else h = i;
+  }
+  return l;
+}
+
+static void
+ref_add(ref_event_t *eve)
+{
+  if( ref_count == ref_alloc )
+  {
+    ref_alloc += 32;
+    ref_by_cookie  = realloc(ref_by_cookie,  ref_alloc * sizeof *ref_by_cookie);
+    ref_by_trigger = realloc(ref_by_trigger, ref_alloc * sizeof *ref_by_trigger);
+  }
+
+  size_t t = ref_trigger_slot(eve);
+  size_t c = ref_cookie_slot(eve->cookie);
+
+  for( size_t i = ref_count; i > t; --i ) ref_by_trigger[i] = ref_by_trigger[i-1];
+  for( size_t i = ref_count; i > c; --i ) ref_by_cookie[i]  = ref_by_cookie[i-1];
+
+  ref_by_trigger[t] = eve;
+  ref_by_cookie[c]  = eve;
+  ref_count += 1;
+}
+
+static ref_event_t *
+ref_get(cookie_t cookie)
+{
+  size_t c = ref_cookie_slot(cookie);
+  return (c < ref_count && ref_by_cookie[c]->cookie == cookie) ? ref_by_cookie[c] : 0;
+}
+
+static void
+ref_set_trigger(ref_event_t *eve, time_t trigger)
+{
+  ref_event_t temp = { eve->cookie, trigger };
+
+  size_t ti = ref_trigger_slot(eve);
+  size_t to = ref_trigger_slot(&temp);
+
+  eve->trigger = trigger;
+
+  if( to <= ti )
+  {
+    for( ; ti > to; --ti ) ref_by_trigger[ti] = ref_by_trigger[ti-1];
+  }
+  else
+  {
+    for( --to; ti < to; ++ti ) ref_by_trigger[ti] = ref_by_trigger[ti+1];
+  }
+  ref_by_trigger[to] = eve;
+}
+
+static void
+ref_del(cookie_t cookie)
+{
+  size_t c = ref_cookie_slot(cookie);
+  size_t t = ref_trigger_slot(ref_by_cookie[c]);
+
+  free(ref_by_cookie[c]);
+
+  for( --ref_count; c < ref_count; ++c ) ref_by_cookie[c]  = ref_by_cookie[c+1];
+  for( ; t < ref_count; ++t )            ref_by_trigger[t] = ref_by_trigger[t+1];
+}
+
+/* ========================================================================= *
+ * BENCHMARKS
+ * ========================================================================= */
+
+typedef struct
+{
+  double add;
+  double reschedule;
+  double lookup;
+  double remove;
+} bench_result_t;
+
+static void
+bench_reference(size_t count, bench_result_t *res)
+{
+  double t;
+
+  srandom(count);
+  t = bench_now();
+  for( size_t i = 1; i <= count; ++i )
+  {
+    ref_event_t *eve = calloc(1, sizeof *eve);
+    eve->cookie  = i;
+    eve->trigger = bench_random_trigger();
+    ref_add(eve);
+  }
+  res->add = bench_now() - t;
+
+  t = bench_now();
+  for( size_t i = 1; i <= count; ++i )
+  {
+    ref_set_trigger(ref_get(1 + random() % count), bench_random_trigger());
+  }
+  res->reschedule = bench_now() - t;
+
+  t = bench_now();
+  for( size_t i = 1; i <= count; ++i )
+  {
+    if( ref_get(1 + random() % count) == 0 ) abort();
+  }
+  res->lookup = bench_now() - t;
+
+  t = bench_now();
+  for( size_t i = 1; i <= count; ++i )
+  {
+    ref_del(i);
+  }
+  res->remove = bench_now() - t;
+}
+
+static void
+bench_queue(size_t count, bench_result_t *res)
+{
+  double t;
+
+  srandom(count);
+  t = bench_now();
+  for( size_t i = 1; i <= count; ++i )
+  {
+    alarm_event_t *eve = alarm_event_create();
+    alarm_event_set_cookie(eve, i);
+    alarm_event_set_trigger(eve, bench_random_trigger());
+    queue_event_set_state(eve, ALARM_STATE_QUEUED);
+    queue_add_event(eve);
+  }
+  res->add = bench_now() - t;
+
+  t = bench_now();
+  for( size_t i = 1; i <= count; ++i )
+  {
+    queue_event_set_trigger(queue_get_event(1 + random() % count),
+                            bench_random_trigger());
+  }
+  res->reschedule = bench_now() - t;
+
+  t = bench_now();
+  for( size_t i = 1; i <= count; ++i )
+  {
+    if( queue_get_event(1 + random() % count) == 0 ) abort();
+  }
+  res->lookup = bench_now() - t;
+
+  t = bench_now();
+  for( size_t i = 1; i <= count; ++i )
+  {
+    queue_del_event(i);
+  }
+  queue_cleanup_deleted();
+  res->remove = bench_now() - t;
+}
+
+int
+main(int ac, char **av)
+{
+  static const size_t counts[] = { 1000, 10000, 100000 };
+
+  size_t  cnt = (ac > 1) ? (size_t)(ac - 1) : sizeof counts / sizeof *counts;
+
+  log_set_level(LOG_WARNING);
+
+  printf("%8s %-10s %12s %12s %12s %12s\n",
+         "events", "impl", "add", "reschedule", "lookup", "remove");
+
+  for( size_t i = 0; i < cnt; ++i )
+  {
+    size_t         count = (ac > 1) ? strtoul(av[i+1], 0, 0) : counts[i];
+    bench_result_t ref, que;
+
+    bench_reference(count, &ref);
+    bench_queue(count, &que);
+
+    printf("%8zu %-10s %12.6f %12.6f %12.6f %12.6f\n", count, "array",
+           ref.add, ref.reschedule, ref.lookup, ref.remove);
+    printf("%8zu %-10s %12.6f %12.6f %12.6f %12.6f\n", count, "queue",
+           que.add, que.reschedule, que.lookup, que.remove);
+  }
+  return 0;
+}
@@ -610,16 +610,16 @@ static gboolean queue_rescan_callback(void *data)
 {
   //log_append("@ %s()\n", __FUNCTION__);
 
-  cookie_t *vec = 0;
+  alarm_event_t **vec = 0;
   alarm_event_t *eve = 0;
 
   queue_clear();
 
-  if( (vec = alarmd_event_query(0,0, 0,0, 0)) )
+  if( (vec = alarmd_event_query_full(0,0, 0,0, 0, ALARM_QUERY_TEXT)) )
   {
-    for( int i = 0; vec[i] > 0; ++i )
+    for( int i = 0; vec[i] != 0; ++i )
     {
-      if( (eve = alarmd_event_get(vec[i])) )
+      if( (eve = vec[i]) )
       {
         char tdate[256];
         char adate[256];
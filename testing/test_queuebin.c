@@ -0,0 +1,331 @@
+/* ========================================================================= *
+ *
+ * This file is part of Alarmd
+ *
+ * Copyright (C) 2008-2009 Nokia Corporation and/or its subsidiary(-ies).
+ *
+ * Contact: Simo Piiroinen <simo.piiroinen@nokia.com>
+ *
+ * Alarmd is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * version 2.1 as published by the Free Software Foundation.
+ *
+ * Alarmd is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with Alarmd; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA
+ * 02110-1301 USA
+ *
+ * ========================================================================= */
+
+/* Round trip test: events written to binary queue file format must
+ * come back with identical content, and damaged or stale files must
+ * be rejected.
+ *
+ * Usage: test_queuebin [rounds [seed]]
+ */
+
+#include "../src/queuebin.h"
+#include "../src/logging.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+
+static int fails = 0;
+
+#define CHECK(cond) do {\
+  if( !(cond) ) { printf("FAILED: %s:%d: %s\n", __FILE__, __LINE__, #cond); ++fails; }\
+} while(0)
+
+/* ------------------------------------------------------------------------- *
+ * random_str  --  empty, shared or unique strings with odd bytes
+ * ------------------------------------------------------------------------- */
+
+static const char *
+random_str(void)
+{
+  static const char * const common[] = { "", "", "alarmd", "Clock", "\t\\\n" };
+  static char buf[64];
+
+  if( random() % 2 )
+  {
+    return common[random() % (sizeof common / sizeof *common)];
+  }
+
+  size_t n = random() % (sizeof buf - 1);
+
+  for( size_t i = 0; i < n; ++i )
+  {
+    buf[i] = 1 + random() % 255;
+  }
+  buf[n] = 0;
+  return buf;
+}
+
+/* ------------------------------------------------------------------------- *
+ * random_event
+ * ------------------------------------------------------------------------- */
+
+static alarm_event_t *
+random_event(cookie_t cookie)
+{
+  alarm_event_t *e = alarm_event_create();
+
+  e->ALARMD_PRIVATE(cookie)  = cookie;
+  e->ALARMD_PRIVATE(trigger) = random();
+
+  alarm_event_set_title(e, random_str());
+  alarm_event_set_message(e, random_str());
+  alarm_event_set_sound(e, random_str());
+  alarm_event_set_icon(e, random_str());
+  alarm_event_set_alarm_appid(e, random_str());
+  alarm_event_set_alarm_tz(e, random_str());
+
+  e->flags              = random();
+  e->alarm_time         = random() - RAND_MAX / 2;
+  e->alarm_tm.tm_year   = random() % 200;
+  e->alarm_tm.tm_mday   = random() % 32;
+  e->alarm_tm.tm_isdst  = random() % 3 - 1;
+  e->recur_secs         = random() % 100000;
+  e->recur_count        = random() % 5 - 1;
+  e->snooze_secs        = random() % 1000;
+  e->snooze_total       = random() % 1000;
+
+  alarm_action_t *act = alarm_event_add_actions(e, random() % 4);
+
+  for( size_t k = 0; k < e->action_cnt; ++k )
+  {
+    act[k].flags = random();
+    alarm_action_set_label(&act[k], random_str());
+    alarm_action_set_exec_command(&act[k], random_str());
+    alarm_action_set_dbus_service(&act[k], random_str());
+    alarm_action_set_dbus_name(&act[k], random_str());
+  }
+
+  alarm_recur_t *rec = alarm_event_add_recurrences(e, random() % 3);
+
+  for( size_t k = 0; k < e->recurrence_cnt; ++k )
+  {
+    rec[k].mask_min  = ((uint64_t)random() << 31) ^ random();
+    rec[k].mask_hour = random();
+    rec[k].mask_wday = random() % 128;
+    rec[k].special   = random() % 4;
+  }
+
+  for( int k = random() % 4; k > 0; --k )
+  {
+    char name[16];
+
+    snprintf(name, sizeof name, "attr%d", k);
+
+    switch( random() % 3 )
+    {
+    case 0: alarm_event_set_attr_int(e, name, random());    break;
+    case 1: alarm_event_set_attr_time(e, name, random());   break;
+    case 2: alarm_event_set_attr_string(e, name, random_str()); break;
+    }
+  }
+
+  return e;
+}
+
+/* ------------------------------------------------------------------------- *
+ * same_event
+ * ------------------------------------------------------------------------- */
+
+static int
+same_event(const alarm_event_t *a, const alarm_event_t *b)
+{
+  int ok = 1;
+
+#define Xn(v) ok = ok && (a->v == b->v)
+#define Xs(v) ok = ok && !strcmp(a->v ?: "", b->v ?: "")
+
+  Xn(ALARMD_PRIVATE(cookie));
+  Xn(ALARMD_PRIVATE(trigger));
+  Xs(title);
+  Xs(message);
+  Xs(sound);
+  Xs(icon);
+  Xn(flags);
+  Xs(alarm_appid);
+  Xn(alarm_time);
+  ok = ok && !memcmp(&a->alarm_tm, &b->alarm_tm, 9 * sizeof(int));
+  Xs(alarm_tz);
+  Xn(recur_secs);
+  Xn(recur_count);
+  Xn(snooze_secs);
+  Xn(snooze_total);
+  Xn(action_cnt);
+  Xn(recurrence_cnt);
+  Xn(attr_cnt);
+
+  for( size_t k = 0; ok && k < a->action_cnt; ++k )
+  {
+    Xn(action_tab[k].flags);
+    Xs(action_tab[k].label);
+    Xs(action_tab[k].exec_command);
+    Xs(action_tab[k].dbus_interface);
+    Xs(action_tab[k].dbus_service);
+    Xs(action_tab[k].dbus_path);
+    Xs(action_tab[k].dbus_name);
+    Xs(action_tab[k].dbus_args);
+  }
+
+  for( size_t k = 0; ok && k < a->recurrence_cnt; ++k )
+  {
+    Xn(recurrence_tab[k].mask_min);
+    Xn(recurrence_tab[k].mask_hour);
+    Xn(recurrence_tab[k].mask_mday);
+    Xn(recurrence_tab[k].mask_wday);
+    Xn(recurrence_tab[k].mask_mon);
+    Xn(recurrence_tab[k].special);
+  }
+
+  for( size_t k = 0; ok && k < a->attr_cnt; ++k )
+  {
+    Xs(attr_tab[k]->attr_name);
+    Xn(attr_tab[k]->attr_type);
+
+    switch( a->attr_tab[k]->attr_type )
+    {
+    case ALARM_ATTR_INT:    Xn(attr_tab[k]->attr_data.ival); break;
+    case ALARM_ATTR_TIME:   Xn(attr_tab[k]->attr_data.tval); break;
+    case ALARM_ATTR_STRING: Xs(attr_tab[k]->attr_data.sval); break;
+    }
+  }
+
+#undef Xn
+#undef Xs
+
+  return ok;
+}
+
+/* ------------------------------------------------------------------------- *
+ * save  --  write data to file
+ * ------------------------------------------------------------------------- */
+
+static void
+save(const char *path, const char *data, size_t size)
+{
+  FILE *file = fopen(path, "w");
+
+  if( file == 0 || fwrite(data, 1, size, file) != size || fclose(file) != 0 )
+  {
+    perror(path);
+    exit(EXIT_FAILURE);
+  }
+}
+
+int
+main(int ac, char **av)
+{
+  int  rounds = (ac > 1) ? strtol(av[1], 0, 0) : 200;
+  int  seed   = (ac > 2) ? strtol(av[2], 0, 0) : 1;
+  char path[] = "/tmp/test_queuebin.XXXXXX";
+  int  fd;
+
+  log_set_level(LOG_CRIT);
+  srandom(seed);
+
+  if( (fd = mkstemp(path)) == -1 )
+  {
+    perror(path);
+    exit(EXIT_FAILURE);
+  }
+  close(fd);
+
+  for( int r = 0; r < rounds && fails < 10; ++r )
+  {
+    size_t          cnt  = random() % 50;
+    alarm_event_t **vec  = calloc(cnt + 1, sizeof *vec);
+    uint64_t       *hash = calloc(cnt + 1, sizeof *hash);
+    cookie_t        cookie = 0;
+    char           *data = 0;
+    size_t          size = 0;
+    queuebin_t     *bin  = 0;
+    struct stat     master, other;
+
+    for( size_t i = 0; i < cnt; ++i )
+    {
+      cookie += 1 + random() % 3;
+      vec[i] = random_event(cookie);
+      hash[i] = ((uint64_t)random() << 32) ^ random();
+    }
+
+    memset(&master, 0, sizeof master);
+    master.st_ino          = random();
+    master.st_size         = random();
+    master.st_mtim.tv_sec  = random();
+    master.st_mtim.tv_nsec = random() % 1000000000;
+
+    CHECK( queuebin_encode(&data, &size, r, r * 7, &master, vec, hash) == 0 );
+    save(path, data, size);
+
+    /* - - - - - - - - - - - - - - - - - - - *
+     * round trip
+     * - - - - - - - - - - - - - - - - - - - */
+
+    CHECK( (bin = queuebin_open(path)) != 0 );
+
+    if( bin != 0 )
+    {
+      other = master, other.st_mtim.tv_nsec ^= 1;
+
+      CHECK( queuebin_is_copy_of(bin, &master) );
+      CHECK( !queuebin_is_copy_of(bin, &other) );
+      CHECK( queuebin_get_snooze(bin) == (unsigned)r );
+      CHECK( queuebin_get_journal(bin) == (unsigned)r * 7 );
+      CHECK( queuebin_get_count(bin) == cnt );
+
+      for( size_t i = 0; i < cnt; ++i )
+      {
+        cookie_t       c = vec[i]->ALARMD_PRIVATE(cookie);
+        alarm_event_t *e = queuebin_find_event(bin, c);
+        alarm_event_t *n = queuebin_find_event(bin, c + 1);
+
+        CHECK( queuebin_get_cookie(bin, i) == c );
+        CHECK( queuebin_get_hash(bin, i) == hash[i] );
+        CHECK( e != 0 && same_event(vec[i], e) );
+        CHECK( n == 0 || (i + 1 < cnt && same_event(vec[i+1], n)) );
+
+        alarm_event_delete(e);
+        alarm_event_delete(n);
+      }
+      queuebin_close(bin);
+    }
+
+    /* - - - - - - - - - - - - - - - - - - - *
+     * damaged files are rejected
+     * - - - - - - - - - - - - - - - - - - - */
+
+    save(path, data, size - 1 - random() % 8);
+    CHECK( (bin = queuebin_open(path)) == 0 );
+    queuebin_close(bin);
+
+    data[8] ^= 0x40; // version
+    save(path, data, size);
+    CHECK( (bin = queuebin_open(path)) == 0 );
+    queuebin_close(bin);
+
+    for( size_t i = 0; i < cnt; ++i )
+    {
+      alarm_event_delete(vec[i]);
+    }
+    free(vec);
+    free(hash);
+    free(data);
+  }
+
+  unlink(path);
+
+  printf("%d rounds, %d failures\n", rounds, fails);
+  return fails ? EXIT_FAILURE : EXIT_SUCCESS;
+}
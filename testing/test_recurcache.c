@@ -0,0 +1,163 @@
+/* ========================================================================= *
+ *
+ * This file is part of Alarmd
+ *
+ * Copyright (C) 2008-2009 Nokia Corporation and/or its subsidiary(-ies).
+ *
+ * Contact: Simo Piiroinen <simo.piiroinen@nokia.com>
+ *
+ * Alarmd is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * version 2.1 as published by the Free Software Foundation.
+ *
+ * Alarmd is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with Alarmd; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA
+ * 02110-1301 USA
+ *
+ * ========================================================================= */
+
+/* Property test: cached recurrence evaluation must return the same
+ * values as alarm_recur_align() / alarm_recur_next() for sequences
+ * of queries that move forwards (serving alarms) and jump around
+ * (system time changes).
+ *
+ * Usage: test_recurcache [rounds [seed]]
+ */
+
+#include "../src/recurcache.h"
+#include "../src/ticker.h"
+#include "../src/logging.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+
+static const char * const zones[] =
+{
+  "UTC",
+  "Europe/Helsinki",
+  "America/New_York",
+  "Australia/Lord_Howe",
+  "EST5EDT,M3.2.0,M11.1.0",
+};
+
+#define numof(a) (sizeof(a)/sizeof*(a))
+
+/* ------------------------------------------------------------------------- *
+ * random_recur  --  mostly alarm clock style masks, sometimes others
+ * ------------------------------------------------------------------------- */
+
+static void
+random_recur(alarm_recur_t *rec)
+{
+  alarm_recur_ctor(rec);
+
+  rec->mask_min  = 1llu << (random() % 60);
+  rec->mask_hour = 1u   << (random() % 24);
+
+  switch( random() % 8 )
+  {
+  case 0: rec->mask_hour = ALARM_RECUR_HOUR_DONTCARE; break;
+  case 1: rec->mask_min |= 1llu << (random() % 60); break;
+  case 2: rec->mask_hour |= 1u << (random() % 24); break;
+  case 3: rec->special = ALARM_RECUR_SPECIAL_MONTHLY; break;
+  }
+
+  switch( random() % 4 )
+  {
+  case 1: rec->mask_wday = 1 + random() % ALARM_RECUR_WDAY_ALL; break;
+  case 2: rec->mask_mday = ALARM_RECUR_MDAY_EOM; break;
+  case 3: rec->mask_mon  = 1u << (random() % 12); break;
+  }
+}
+
+/* ------------------------------------------------------------------------- *
+ * direct_eval  --  uncached reference
+ * ------------------------------------------------------------------------- */
+
+static time_t
+direct_eval(const alarm_recur_t *rec, const char *tz, time_t t, int next)
+{
+  struct tm tm;
+  ticker_break_tm(t, &tm, tz);
+  return next ? alarm_recur_next(rec, &tm, tz) : alarm_recur_align(rec, &tm, tz);
+}
+
+int
+main(int ac, char **av)
+{
+  int rounds = (ac > 1) ? strtol(av[1], 0, 0) : 2000;
+  int seed   = (ac > 2) ? strtol(av[2], 0, 0) : 1;
+  int fails  = 0;
+
+  log_set_level(LOG_WARNING);
+  srandom(seed);
+
+  for( int i = 0; i < rounds && fails < 10; ++i )
+  {
+    const char    *tz    = zones[random() % numof(zones)];
+    alarm_event_t *eve   = alarm_event_create();
+    recurcache_t  *cache = 0;
+    size_t         cnt   = 1 + random() % 2;
+    alarm_recur_t *tab   = alarm_event_add_recurrences(eve, cnt);
+
+    for( size_t k = 0; k < cnt; ++k )
+    {
+      random_recur(&tab[k]);
+    }
+
+    time_t t = 31536000 + random() % 2000000000;
+
+    for( int q = 0; q < 50 && fails < 10; ++q )
+    {
+      switch( random() % 4 )
+      {
+      case 0:
+        // system time change
+        t += (random() % (4 * 24 * 3600)) - 2 * 24 * 3600;
+        break;
+
+      case 1:
+        // zone data changed
+        if( random() % 8 == 0 ) recurcache_flush();
+        break;
+
+      default:
+        // shortly after serving
+        t = direct_eval(&tab[0], tz, t, 1);
+        if( t == -1 ) t = 31536000 + random() % 2000000000;
+        t += random() % 120;
+        break;
+      }
+
+      for( size_t k = 0; k < cnt; ++k )
+      {
+        int    next = random() & 1;
+        time_t want = direct_eval(&tab[k], tz, t, next);
+        time_t have = (next ? recurcache_next : recurcache_align)(&cache, eve, k, tz, t);
+
+        if( want != have )
+        {
+          printf("MISMATCH: %s %s t=%ld min=%llx hour=%x mday=%x"
+                 " wday=%x mon=%x special=%d: want %ld, have %ld\n",
+                 tz, next ? "next" : "align", (long)t,
+                 (unsigned long long)tab[k].mask_min, tab[k].mask_hour,
+                 tab[k].mask_mday, tab[k].mask_wday, tab[k].mask_mon,
+                 tab[k].special, (long)want, (long)have);
+          ++fails;
+        }
+      }
+    }
+
+    recurcache_delete(cache);
+    alarm_event_delete(eve);
+  }
+
+  printf("%d rounds, %d failures\n", rounds, fails);
+  return fails ? EXIT_FAILURE : EXIT_SUCCESS;
+}
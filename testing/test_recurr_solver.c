@@ -0,0 +1,251 @@
+/* ========================================================================= *
+ *
+ * This file is part of Alarmd
+ *
+ * Copyright (C) 2008-2009 Nokia Corporation and/or its subsidiary(-ies).
+ *
+ * Contact: Simo Piiroinen <simo.piiroinen@nokia.com>
+ *
+ * Alarmd is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * version 2.1 as published by the Free Software Foundation.
+ *
+ * Alarmd is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with Alarmd; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA
+ * 02110-1301 USA
+ *
+ * ========================================================================= */
+
+/* Property test: the closed form mask solver must produce exactly
+ * the same results as the mktime based reference scanner for
+ * random recurrence masks, start times and time zones.
+ *
+ * Usage: test_recurr_solver [rounds [seed]]
+ */
+
+/* include the source to get access to the static functions */
+#include "../src/recurrence.c"
+
+#include <stdio.h>
+#include <string.h>
+
+static const char * const zones[] =
+{
+  "UTC",
+  "Europe/Helsinki",
+#if ALARMD_RECUR_GAP_FORWARD
+  // mktime() resolves skipped time backwards, the scan needs the flag
+  "Europe/Dublin",
+#endif
+  "America/New_York",
+  "America/Sao_Paulo",
+  "Australia/Lord_Howe",
+  "Asia/Kolkata",
+  "Pacific/Apia",
+  "EST5EDT,M3.2.0,M11.1.0",
+  "<+0330>-3:30<+0430>,J79/24,J263/24",
+  "AAA0BBB0,M3.2.0,M11.1.0",
+};
+
+#define numof(a) (sizeof(a)/sizeof*(a))
+
+/* ------------------------------------------------------------------------- *
+ * random_bits  --  pick a few random bits from range [lo, hi]
+ * ------------------------------------------------------------------------- */
+
+static uint64_t
+random_bits(int lo, int hi)
+{
+  uint64_t res = 0;
+  int      cnt = 1 + random() % 3;
+
+  while( cnt-- > 0 )
+  {
+    res |= 1llu << (lo + random() % (hi - lo + 1));
+  }
+  return res;
+}
+
+/* ------------------------------------------------------------------------- *
+ * random_recur  --  random recurrence masks, dontcare half of the time
+ * ------------------------------------------------------------------------- */
+
+static void
+random_recur(alarm_recur_t *rec)
+{
+  alarm_recur_ctor(rec);
+
+  if( random() & 1 ) rec->mask_min  = random_bits(0, 59);
+  if( random() & 1 ) rec->mask_hour = random_bits(0, 23);
+  if( random() & 1 ) rec->mask_wday = random_bits(0, 6);
+  if( random() & 1 ) rec->mask_mon  = random_bits(0, 11);
+
+  switch( random() % 4 )
+  {
+  case 1: rec->mask_mday = random_bits(1, 31); break;
+  case 2: rec->mask_mday = ALARM_RECUR_MDAY_EOM; break;
+  }
+
+  switch( random() % 8 )
+  {
+  case 1: rec->special = ALARM_RECUR_SPECIAL_BIWEEKLY; break;
+  case 2: rec->special = ALARM_RECUR_SPECIAL_MONTHLY;  break;
+  case 3: rec->special = ALARM_RECUR_SPECIAL_YEARLY;   break;
+  }
+}
+
+/* ------------------------------------------------------------------------- *
+ * same_tm
+ * ------------------------------------------------------------------------- */
+
+static int
+same_tm(const struct tm *a, const struct tm *b)
+{
+  return (a->tm_sec   == b->tm_sec   && a->tm_min  == b->tm_min  &&
+          a->tm_hour  == b->tm_hour  && a->tm_mday == b->tm_mday &&
+          a->tm_mon   == b->tm_mon   && a->tm_year == b->tm_year &&
+          a->tm_wday  == b->tm_wday  && a->tm_yday == b->tm_yday &&
+          a->tm_isdst == b->tm_isdst);
+}
+
+/* ------------------------------------------------------------------------- *
+ * check_one  --  compare solver and reference for one start time
+ * ------------------------------------------------------------------------- */
+
+static int
+check_one(const alarm_recur_t *rec, const struct tm *now,
+          const char *tz, int align_only)
+{
+  struct tm ref = *now;
+  struct tm sol = *now;
+  time_t    t_ref, t_sol;
+
+  if( !align_only )
+  {
+    alarm_recur_handle_specials(rec, &ref, tz);
+    alarm_recur_handle_specials(rec, &sol, tz);
+  }
+
+  if( alarm_recur_solve_masks(rec, &sol, tz, align_only, &t_sol) == -1 )
+  {
+    printf("zone %s not supported by solver\n", tz);
+    return -1;
+  }
+
+  if( t_sol == -1 && (rec->mask_mday & ALARM_RECUR_MDAY_ALL) )
+  {
+    // impossible date, the reference scanner would never return
+    return 0;
+  }
+
+  t_ref = alarm_recur_scan_masks(rec, &ref, tz, align_only);
+
+  if( t_ref != t_sol || (t_ref != -1 && !same_tm(&ref, &sol)) )
+  {
+    printf("MISMATCH: %s %s min=%llx hour=%x mday=%x wday=%x mon=%x"
+           " special=%d\n", tz, align_only ? "align" : "next",
+           (unsigned long long)rec->mask_min, rec->mask_hour,
+           rec->mask_mday, rec->mask_wday, rec->mask_mon, rec->special);
+    printf("  start %s", asctime(now));
+    printf("  ref   %ld %s", (long)t_ref, asctime(&ref));
+    printf("  sol   %ld %s", (long)t_sol, asctime(&sol));
+    return -1;
+  }
+  return 0;
+}
+
+/* ------------------------------------------------------------------------- *
+ * check_gap_forward  --  scanning past time skipped in Europe/Dublin
+ * ------------------------------------------------------------------------- */
+
+#if ALARMD_RECUR_GAP_FORWARD
+static int
+check_gap_forward(void)
+{
+  static const char tz[] = "Europe/Dublin";
+
+  alarm_recur_t rec;
+  struct tm     now, ref;
+  time_t        t;
+
+  // 01:00 - 02:00 local time is skipped on 2021-03-28
+  alarm_recur_ctor(&rec);
+  rec.mask_min  = 1llu << 30;
+  rec.mask_hour = 1u   << 1;
+
+  memset(&now, 0, sizeof now);
+  now.tm_year = 2021 - 1900;
+  now.tm_mon  = 3 - 1;
+  now.tm_mday = 28;
+  now.tm_min  = 10;
+  ticker_build_tm_guess_dst(&now, tz);
+
+  ref = now;
+  t   = alarm_recur_scan_masks(&rec, &ref, tz, 1);
+
+  if( t == -1 || ref.tm_mday != 29 || ref.tm_hour != 1 || ref.tm_min != 30 )
+  {
+    printf("GAP: %s expected Mon Mar 29 01:30:00 2021\n", tz);
+    printf("  got   %ld %s", (long)t, (t == -1) ? "\n" : asctime(&ref));
+    return -1;
+  }
+
+  return check_one(&rec, &now, tz, 1);
+}
+#endif
+
+int
+main(int ac, char **av)
+{
+  int rounds = (ac > 1) ? strtol(av[1], 0, 0) : 20000;
+  int seed   = (ac > 2) ? strtol(av[2], 0, 0) : 1;
+  int fails  = 0;
+
+  log_set_level(LOG_WARNING);
+  srandom(seed);
+
+#if ALARMD_RECUR_GAP_FORWARD
+  if( check_gap_forward() == -1 ) ++fails;
+#endif
+
+  for( int i = 0; i < rounds && fails < 10; ++i )
+  {
+    const char   *tz = zones[random() % numof(zones)];
+    alarm_recur_t rec;
+    struct tm     now;
+
+    random_recur(&rec);
+
+    // 1971 .. 2037, half of the time shortly before skipped time
+    time_t t = 31536000 + random() % 2100000000;
+    time_t beg, end;
+
+    if( (random() & 1) && tzfile_next_gap(tz, t, &beg, &end) == 1 )
+    {
+      // gap limits are local times, break them down as if in utc
+      ticker_break_tm(beg - random() % (3 * 60 * 60), &now, "UTC");
+      ticker_build_tm_guess_dst(&now, tz);
+    }
+    else
+    {
+      ticker_break_tm(t, &now, tz);
+    }
+
+    if( random() & 1 )
+    {
+      now.tm_sec = 0;
+    }
+
+    if( check_one(&rec, &now, tz, 1) == -1 ) ++fails;
+    if( check_one(&rec, &now, tz, 0) == -1 ) ++fails;
+  }
+
+  printf("%d rounds, %d failures\n", rounds, fails);
+  return fails ? EXIT_FAILURE : EXIT_SUCCESS;
+}